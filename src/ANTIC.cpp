@@ -20,12 +20,15 @@ const uint32_t ANTIC::s_palette[128] = {
 
 ANTIC::ANTIC(CPU* cpu, RAM* ram) :
     Chip(cpu, ram), m_renderBuffer(), m_displayBuffer(), m_renderLine(), m_displayMode(), m_playfieldWidth(), m_scanAddress(),
-    m_listAddress(), m_triggerDLI(), m_hScroll(), m_listActive(), m_lastFrameTime(), m_scanLine(), m_scanBuffer()
+    m_listAddress(), m_triggerDLI(), m_hScroll(), m_listActive(), m_frameSkip(), m_skipped(), m_rendering(true),
+    m_frameStart(), m_scanLine(), m_scanBuffer()
 {
     memset(m_renderBuffer, 0, FRAME_BYTES);
     memset(m_displayBuffer, 0, FRAME_BYTES);
     memset(m_scanBuffer.playfield, 0, FRAME_WIDTH);
     m_scanBuffer.lineBuffer = m_renderBuffer;
+    m_scanBuffer.lineStart  = m_frameStart = m_CPU->m_scheduler.Now();
+    ScheduleLine();
 }
 
 ANTIC::~ANTIC() {}
@@ -35,7 +38,7 @@ byte_t ANTIC::Read(word_t addr)
     switch(addr)
     {
     case ChipRegisters::VCOUNT: {
-        return static_cast<byte_t>(m_scanLine / 2);
+        return static_cast<byte_t>(getScanLine() / 2);
     }
     case ChipRegisters::NMIST:
     default:
@@ -49,18 +52,20 @@ void ANTIC::Write(word_t addr, byte_t val)
 {
     switch(addr)
     {
-    case ChipRegisters::WSYNC:
+    case ChipRegisters::WSYNC: {
         m_RAM->DirectSet(addr, val);
         // wait until cycle 105 of current scanline
-        if(m_scanBuffer.scanCycle < 104)
+        const auto scanCycle = static_cast<unsigned>((m_CPU->m_scheduler.Now() - m_frameStart) % CYCLES_PER_SCANLINE);
+        if(scanCycle < 104)
         {
-            m_CPU->Wait(104 - m_scanBuffer.scanCycle);
+            m_CPU->Wait(104 - scanCycle);
         }
         else
         {
-            m_CPU->Wait(CYCLES_PER_SCANLINE + 104 - m_scanBuffer.scanCycle);
+            m_CPU->Wait(CYCLES_PER_SCANLINE + 104 - scanCycle);
         }
         break;
+    }
     case ChipRegisters::NMIRES:
         m_RAM->DirectSet(ChipRegisters::NMIST, 0);
         return;
@@ -71,10 +76,29 @@ void ANTIC::Write(word_t addr, byte_t val)
     }
 }
 
+// VCOUNT steps every other line, NMIST only changes with events and writes
+uint64_t ANTIC::StableUntil(word_t reg, uint64_t since)
+{
+    switch(reg)
+    {
+    case ChipRegisters::VCOUNT: {
+        const uint64_t pairStart = m_frameStart + static_cast<uint64_t>(getScanLine() & ~1) * CYCLES_PER_SCANLINE;
+        return since < pairStart ? since : pairStart + 2 * CYCLES_PER_SCANLINE;
+    }
+    case ChipRegisters::NMIST:
+        return Scheduler::NEVER;
+    default:
+        return since;
+    }
+}
+
 void ANTIC::Reset()
 {
+    m_skipped              = 0;
+    m_rendering            = true;
     m_scanLine             = 0;
-    m_scanBuffer.scanCycle = 0;
+    m_scanBuffer.lineStart = m_frameStart = m_CPU->m_scheduler.Now();
+    ScheduleLine();
     m_RAM->DirectSet(ChipRegisters::NMIEN, 0);
     m_RAM->DirectSet(ChipRegisters::NMIST, 0);
 }
@@ -94,8 +118,40 @@ ScanBuffer* ANTIC::getScanBuffer()
     return &m_scanBuffer;
 }
 
+void ANTIC::SetFrameSkip(unsigned frames)
+{
+    m_frameSkip = frames;
+}
+
+bool ANTIC::IsRendering() const
+{
+    return m_rendering;
+}
+
+void ANTIC::SetRendering(bool rendering)
+{
+    m_rendering = rendering;
+}
+
+// master clock at the start of line 0, frames start at every wrap and reset
+uint64_t ANTIC::getFrameStart() const
+{
+    return m_frameStart;
+}
+
+// the line being traced, from the master clock
+word_t ANTIC::getScanLine() const
+{
+    return static_cast<word_t>((m_CPU->m_scheduler.Now() - m_frameStart) / CYCLES_PER_SCANLINE);
+}
+
 void ANTIC::RenderBlankLines(int numLines)
 {
+    if(!m_rendering)
+    {
+        m_renderLine += numLines;
+        return;
+    }
     while(numLines-- > 0)
     {
         const auto bgColor   = m_RAM->Get(ChipRegisters::COLBK);
@@ -147,6 +203,24 @@ void ANTIC::RenderMapLine()
     const auto bytesPerLine  = static_cast<word_t>((m_playfieldWidth / pixelWidth) * bitsPerPixel / 8);
     const auto widthPerByte  = m_playfieldWidth / bytesPerLine;
     const auto pixelsPerByte = 8 / bitsPerPixel;
+    if(!m_rendering)
+    {
+        // GTIA still checks collisions against the playfield
+        for(word_t i = 0; i < bytesPerLine; i++)
+        {
+            byte_t pixelData = m_RAM->Get(m_scanAddress + i);
+            for(auto b = 0; b < pixelsPerByte; b++)
+            {
+                const byte_t colorIndex = bitsPerPixel == 2 ? (pixelData & 0b11) : (pixelData & 1);
+                const auto   offset     = blankWidth + i * widthPerByte + (pixelsPerByte - 1 - b) * pixelWidth;
+                memset(m_scanBuffer.playfield + offset, colorIndex, pixelWidth);
+                pixelData >>= bitsPerPixel;
+            }
+        }
+        m_renderLine += pixelHeight;
+        m_scanAddress += bytesPerLine;
+        return;
+    }
     for(auto py = 0; py < pixelHeight; py++)
     {
         const auto linePtr = m_renderBuffer + m_renderLine * FRAME_WIDTH;
@@ -216,6 +290,12 @@ void ANTIC::RenderCharacterLine()
     const auto charWidth     = 8 * bitWidth;
     const auto charsPerLine  = static_cast<word_t>(m_playfieldWidth / charWidth);
     const auto hScrollAmount = m_hScroll ? m_RAM->DirectGet(ChipRegisters::HSCROL) * 2 : 0;
+    if(!m_rendering)
+    {
+        m_renderLine += 8 * bitHeight;
+        m_scanAddress += charsPerLine;
+        return;
+    }
 
     auto foreColor = getColor((textBgColor & 0b11110000) + (textFgColor & 0b1111));
     auto backColor = getColor(textBgColor);
@@ -385,76 +465,123 @@ void ANTIC::StepDisplayList()
     }
 }
 
-void ANTIC::Tick()
+// called by the scheduler at the start of the lines ScheduleLine picked
+void ANTIC::StartScanline()
 {
-    m_scanBuffer.scanCycle++;
-    if(m_scanBuffer.scanCycle == CYCLES_PER_SCANLINE)
-    {
-        m_scanLine++;
-        m_scanBuffer.scanCycle  = 0;
-        m_scanBuffer.lineBuffer = m_renderBuffer + m_scanLine * FRAME_WIDTH;
+    const uint64_t now = m_CPU->m_scheduler.Now();
+    SkipTo(getScanLine() - 1);
 
-        // m_scanLine is starting tracing, m_renderLine is the first line we haven't
-        // actually drawn yet
-        if(m_scanLine >= m_renderLine)
+    m_scanLine++;
+    m_scanBuffer.lineBuffer = m_renderBuffer + m_scanLine * FRAME_WIDTH;
+
+    // m_scanLine is starting tracing, m_renderLine is the first line we haven't
+    // actually drawn yet
+    if(m_scanLine >= m_renderLine)
+    {
+        // catch up drawing with tracing
+        StepDisplayList();
+    }
+    // if we've started tracing the last line of the instruction and there was a
+    // DLI request, trigger
+    if(m_renderLine > 0 && m_scanLine == m_renderLine - 1 && m_triggerDLI)
+    {
+        if(m_RAM->DirectGet(ChipRegisters::NMIEN) & 128)
         {
-            // catch up drawing with tracing
-            StepDisplayList();
-        }
-        // if we've started tracing the last line of the instruction and there was a
-        // DLI request, trigger
-        if(m_renderLine > 0 && m_scanLine == m_renderLine - 1 && m_triggerDLI)
-        {
-            if(m_RAM->DirectGet(ChipRegisters::NMIEN) & 128)
-            {
-                // trigger DLI at the beginning of this line
-                m_RAM->DirectSet(ChipRegisters::NMIST, 128);
-                m_CPU->NMI();
-            }
+            // trigger DLI at the beginning of this line
+            m_RAM->DirectSet(ChipRegisters::NMIST, NMISource::DLI);
+            m_CPU->m_interrupts.RaiseNMI(NMISource::DLI);
         }
+    }
 
-        if(m_scanLine == VBLANK_SCANLINE)
+    if(m_scanLine == VBLANK_SCANLINE)
+    {
+        if(m_rendering)
         {
             memcpy(m_displayBuffer, m_renderBuffer, FRAME_BYTES);
-            if(m_RAM->DirectGet(ChipRegisters::NMIEN) & 64)
-            {
-                // VBlank interrupt
-                m_RAM->DirectSet(ChipRegisters::NMIST, 64);
-                m_CPU->NMI();
-            }
         }
-        else if(m_scanLine == TOTAL_SCANLINES)
+        if(m_RAM->DirectGet(ChipRegisters::NMIEN) & 64)
         {
-            m_scanLine = 0;
-            StartDisplayList();
-
-            const chrono::duration<double> frameTime = chrono::steady_clock::now() - m_lastFrameTime;
-            if(frameTime.count() < FRAME_TIME)
-            {
-                // slow down to real time
-                this_thread::sleep_for(chrono::duration<double>(FRAME_TIME - frameTime.count()));
-            }
-            m_lastFrameTime = chrono::steady_clock::now();
+            // VBlank interrupt
+            m_RAM->DirectSet(ChipRegisters::NMIST, NMISource::VBI);
+            m_CPU->m_interrupts.RaiseNMI(NMISource::VBI);
         }
+    }
+    else if(m_scanLine == TOTAL_SCANLINES)
+    {
+        m_scanLine   = 0;
+        m_frameStart = now;
+        StartDisplayList();
 
-        // P/M if DMA enabled
-        if(m_scanLine < VBLANK_SCANLINE && m_RAM->DirectGet(ChipRegisters::DMACTL) & 0b1000)
-        {
-            const word_t pmGraphicsBase = m_RAM->DirectGet(ChipRegisters::PMBASE) << 8;
-            const bool   lowResolution  = !(m_RAM->DirectGet(ChipRegisters::DMACTL) & 0b10000);
-            const auto   sectionLength  = lowResolution ? 128 : 256;
-            const auto   sectionOffset  = lowResolution ? m_scanLine / 2 : m_scanLine;
-            m_RAM->DirectSet(ChipRegisters::GRAFM,
-                             m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 3 + sectionOffset)));
-            m_RAM->DirectSet(ChipRegisters::GRAFP0,
-                             m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 4 + sectionOffset)));
-            m_RAM->DirectSet(ChipRegisters::GRAFP1,
-                             m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 5 + sectionOffset)));
-            m_RAM->DirectSet(ChipRegisters::GRAFP2,
-                             m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 6 + sectionOffset)));
-            m_RAM->DirectSet(ChipRegisters::GRAFP3,
-                             m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 7 + sectionOffset)));
-        }
+        m_rendering = m_skipped >= m_frameSkip;
+        m_skipped   = m_rendering ? 0 : m_skipped + 1;
+    }
+
+    // P/M if DMA enabled
+    if(m_scanLine < VBLANK_SCANLINE && m_RAM->DirectGet(ChipRegisters::DMACTL) & 0b1000)
+    {
+        const word_t pmGraphicsBase = m_RAM->DirectGet(ChipRegisters::PMBASE) << 8;
+        const bool   lowResolution  = !(m_RAM->DirectGet(ChipRegisters::DMACTL) & 0b10000);
+        const auto   sectionLength  = lowResolution ? 128 : 256;
+        const auto   sectionOffset  = lowResolution ? m_scanLine / 2 : m_scanLine;
+        m_RAM->DirectSet(ChipRegisters::GRAFM,
+                         m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 3 + sectionOffset)));
+        m_RAM->DirectSet(ChipRegisters::GRAFP0,
+                         m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 4 + sectionOffset)));
+        m_RAM->DirectSet(ChipRegisters::GRAFP1,
+                         m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 5 + sectionOffset)));
+        m_RAM->DirectSet(ChipRegisters::GRAFP2,
+                         m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 6 + sectionOffset)));
+        m_RAM->DirectSet(ChipRegisters::GRAFP3,
+                         m_RAM->DirectGet(static_cast<word_t>(pmGraphicsBase + sectionLength * 7 + sectionOffset)));
+    }
+
+    // GTIA only draws the line once it's set up
+    m_scanBuffer.lineStart = now;
+    ScheduleLine();
+}
+
+void ANTIC::Sync()
+{
+    SkipTo(getScanLine());
+}
+
+// the lines in between only count up, they are left to SkipTo
+void ANTIC::ScheduleLine()
+{
+    const word_t line   = m_scanLine;
+    const auto   dmactl = m_RAM->DirectGet(ChipRegisters::DMACTL);
+    int          next   = line < VBLANK_SCANLINE ? VBLANK_SCANLINE : TOTAL_SCANLINES;
+    // P/M DMA and GTIA drawing players or missiles need every line
+    if((line + 1 < VBLANK_SCANLINE && (dmactl & 0b1000)) || (m_RAM->DirectGet(ChipRegisters::GRACTL) & 0b11) || m_scanBuffer.players)
+    {
+        next = line + 1;
+    }
+    if(m_triggerDLI && m_renderLine > line + 1)
+    {
+        next = min(next, m_renderLine - 1);
+    }
+    // the display list is stepped from m_renderLine on unless it's off, done or without playfield
+    const bool listIdle = !m_listActive || ((dmactl & 0b100000) && (m_renderLine >= VBLANK_SCANLINE || !(dmactl & 0b11)));
+    if(!listIdle)
+    {
+        next = min(next, max(line + 1, m_renderLine));
+    }
+    m_CPU->m_scheduler.Schedule(ChipEvent::Scanline, m_frameStart + static_cast<uint64_t>(next) * CYCLES_PER_SCANLINE);
+}
+
+// display list steps on skipped lines found nothing to do but still cleared the DLI request
+void ANTIC::SkipTo(word_t line)
+{
+    if(line == m_scanLine)
+    {
+        return;
+    }
+    if(line >= m_renderLine)
+    {
+        m_triggerDLI = false;
     }
+    m_scanLine              = line;
+    m_scanBuffer.lineBuffer = m_renderBuffer + m_scanLine * FRAME_WIDTH;
+    m_scanBuffer.lineStart  = m_frameStart + static_cast<uint64_t>(m_scanLine) * CYCLES_PER_SCANLINE;
 }
 } // namespace atre
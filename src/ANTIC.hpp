@@ -4,8 +4,6 @@
 
 namespace atre
 {
-using time_point = std::chrono::time_point<std::chrono::steady_clock>;
-
 class ANTIC : public Chip
 {
 public:
@@ -15,13 +13,26 @@ public:
     static uint32_t getColor(byte_t color);
     const uint32_t* getDisplayBuffer() const;
     ScanBuffer*     getScanBuffer();
-
-    void   Reset() override;
-    void   Tick() override;
-    void   Write(word_t reg, byte_t val) override;
-    byte_t Read(word_t reg) override;
+    word_t          getScanLine() const;
+    uint64_t        getFrameStart() const;
+
+    void     Reset() override;
+    void     StartScanline();
+    // sets up the lines skipped so far, before GTIA or register access
+    void     Sync();
+    void     ScheduleLine();
+    // draws one frame, then leaves out the given number
+    void     SetFrameSkip(unsigned frames);
+    bool     IsRendering() const;
+    // draws the current frame or leaves it out, the frame skip decides again for the next one
+    void     SetRendering(bool rendering);
+    void     Write(word_t reg, byte_t val) override;
+    byte_t   Read(word_t reg) override;
+    uint64_t StableUntil(word_t reg, uint64_t since) override;
 
 private:
+    friend class Snapshot;
+
     static const uint32_t s_palette[128];
 
     uint32_t   m_renderBuffer[FRAME_HEIGHT * FRAME_WIDTH];
@@ -34,12 +45,16 @@ private:
     bool       m_triggerDLI;
     bool       m_hScroll;
     bool       m_listActive;
-    time_point m_lastFrameTime;
-    word_t     m_scanLine;
+    unsigned   m_frameSkip;
+    unsigned   m_skipped;    // frames left out since the last drawn one
+    bool       m_rendering;  // false while a frame is left out
+    uint64_t   m_frameStart; // master clock at the start of line 0
+    word_t     m_scanLine;   // the last line set up
     ScanBuffer m_scanBuffer;
 
     void StartDisplayList();
     void StepDisplayList();
+    void SkipTo(word_t line);
     void RenderBlankLines(int numBlanks);
     void RenderCharacterLine();
     void RenderMapLine();
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+struct AluResult
+{
+    byte_t value;
+    bool   carry;
+    bool   overflow;
+};
+
+// the binary arithmetic, compares and shifts of the 6502, shared by CPU and
+// Lanes so every lane computes what a CPU does; the N and Z flags come from
+// value and decimal mode stays with the CPU
+struct Alu
+{
+    // ADC, SBC adds the complement of op
+    static constexpr AluResult Add(byte_t a, byte_t op, bool carry)
+    {
+        const unsigned sum = a + op + (carry ? 1u : 0u);
+        const auto     res = static_cast<byte_t>(sum);
+        return {res, sum > 0xFF, ((a ^ res) & (op ^ res) & 0x80) != 0};
+    }
+
+    // CMP, CPX and CPY
+    static constexpr AluResult Compare(byte_t r, byte_t op)
+    {
+        return {static_cast<byte_t>(r - op), op <= r, false};
+    }
+
+    // ASL shifts in a 0, ROL the carry
+    static constexpr AluResult ShiftLeft(byte_t op, bool carry)
+    {
+        return {static_cast<byte_t>((op << 1) | (carry ? 0x01 : 0)), (op & 0x80) != 0, false};
+    }
+
+    // LSR shifts in a 0, ROR the carry
+    static constexpr AluResult ShiftRight(byte_t op, bool carry)
+    {
+        return {static_cast<byte_t>((op >> 1) | (carry ? 0x80 : 0)), (op & 0x01) != 0, false};
+    }
+};
+} // namespace atre
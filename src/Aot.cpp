@@ -0,0 +1,187 @@
+#include "Aot.hpp"
+#include "RAM.hpp"
+#include <iomanip>
+#include <set>
+
+using namespace std;
+
+namespace atre
+{
+map<uint64_t, Aot::Image>& Aot::Images()
+{
+    // generated units register during static initialization
+    static map<uint64_t, Image> s_images;
+    return s_images;
+}
+
+bool Aot::Register(uint64_t cartridgeHash, const AotBlock* blocks, size_t count)
+{
+    auto& image = Images()[cartridgeHash];
+    for(size_t i = 0; i < count; i++)
+    {
+        image[blocks[i].start - CARTRIDGE_START] = blocks[i].native;
+    }
+    return true;
+}
+
+const Aot::Image* Aot::Find(uint64_t cartridgeHash)
+{
+    auto image = Images().find(cartridgeHash);
+    return image == Images().end() ? nullptr : &image->second;
+}
+
+namespace
+{
+bool InCartridge(unsigned addr)
+{
+    return addr >= CARTRIDGE_START && addr < CARTRIDGE_START + CARTRIDGE_SIZE;
+}
+
+bool EndsBlock(byte_t code)
+{
+    switch(code)
+    {
+    case 0x00: // BRK
+    case 0x20: // JSR
+    case 0x40: // RTI
+    case 0x4C: // JMP
+    case 0x60: // RTS
+    case 0x6C: // JMP ()
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+void Aot::Decode(RAM& ram, word_t start, unsigned limit, const Visit& visit)
+{
+    unsigned pc = start;
+    while(pc < limit)
+    {
+        const byte_t code   = ram.Get(static_cast<word_t>(pc));
+        const auto&  opCode = CPU::s_opCodeMap[code];
+        if(opCode.bytes == 0 || !InCartridge(pc + opCode.bytes - 1))
+        {
+            return;
+        }
+        word_t operand = 0;
+        if(opCode.bytes == 2)
+        {
+            operand = ram.Get(static_cast<word_t>(pc + 1));
+        }
+        else if(opCode.bytes == 3)
+        {
+            operand = ram.GetW(static_cast<word_t>(pc + 1));
+        }
+        visit(static_cast<word_t>(pc), code, operand);
+        if(EndsBlock(code) || opCode.adr == AddressingMode::Relative)
+        {
+            return;
+        }
+        pc += opCode.bytes;
+    }
+}
+
+// recovers code reachable from the cartridge start and init vectors; anything
+// not found here, like targets of indirect jumps, is left to the interpreter
+map<word_t, word_t> Aot::FindBlocks(RAM& ram)
+{
+    set<word_t>   visited;
+    set<word_t>   entries;
+    deque<word_t> pending = {ram.GetW(0xBFFA), ram.GetW(0xBFFE)};
+    while(!pending.empty())
+    {
+        const word_t start = pending.front();
+        pending.pop_front();
+        if(!InCartridge(start) || !visited.insert(start).second)
+        {
+            continue;
+        }
+        Decode(ram, start, CARTRIDGE_START + CARTRIDGE_SIZE, [&](word_t pc, byte_t code, word_t operand) {
+            entries.insert(start);
+            const auto next = static_cast<word_t>(pc + CPU::s_opCodeMap[code].bytes);
+            if(CPU::s_opCodeMap[code].adr == AddressingMode::Relative)
+            {
+                pending.push_back(static_cast<word_t>(next + static_cast<sbyte_t>(operand)));
+                pending.push_back(next);
+            }
+            else if(code == 0x20) // JSR
+            {
+                pending.push_back(operand);
+                pending.push_back(next);
+            }
+            else if(code == 0x4C) // JMP
+            {
+                pending.push_back(operand);
+            }
+        });
+    }
+
+    // a block stops where the next one starts, so no instruction is translated
+    // twice and running into another entry goes back to the dispatcher
+    map<word_t, word_t> blocks;
+    for(auto entry = entries.begin(); entry != entries.end(); entry++)
+    {
+        const auto     next  = std::next(entry);
+        const unsigned limit = next == entries.end() ? CARTRIDGE_START + CARTRIDGE_SIZE : *next;
+        unsigned       end   = *entry;
+        Decode(ram, *entry, limit, [&end](word_t pc, byte_t code, word_t) { end = pc + CPU::s_opCodeMap[code].bytes; });
+        blocks[*entry] = static_cast<word_t>(end);
+    }
+    return blocks;
+}
+
+// writes a unit with one function per block found in the cartridge
+void Aot::Translate(const string& romFile, const string& outFile)
+{
+    if(!filesystem::exists(romFile) || filesystem::file_size(romFile) != CARTRIDGE_SIZE)
+    {
+        throw runtime_error("Cartridge ROM must be an 8 kB image");
+    }
+
+    RAM ram;
+    ram.LoadROM("", romFile);
+    ram.Load(romFile, CARTRIDGE_START);
+    const auto blocks = FindBlocks(ram);
+
+    ofstream ofs(outFile);
+    if(!ofs.good())
+    {
+        throw runtime_error("Unable to open file");
+    }
+
+    ofs << hex << uppercase << setfill('0');
+    ofs << "// " << filesystem::path(romFile).filename().string() << " translated by the atre aot command, do not edit" << endl;
+    ofs << "#include \"Aot.hpp\"" << endl << endl;
+    ofs << "namespace atre" << endl << "{" << endl << "namespace" << endl << "{" << endl;
+
+    size_t numOps = 0;
+    for(const auto& block : blocks)
+    {
+        const word_t start = block.first;
+        ofs << "unsigned Block" << setw(4) << start << "(CPU* cpu)" << endl << "{" << endl;
+        ofs << "    unsigned cycles = 0;" << endl;
+        Decode(ram, start, block.second, [&](word_t pc, byte_t code, word_t operand) {
+            ofs << "    if(!Aot::Step<0x" << setw(2) << static_cast<int>(code) << ">(cpu, 0x" << setw(4) << operand << ", " << dec
+                << CPU::s_opCodeMap[code].cycles << hex << ", cycles)) // $" << setw(4) << pc << endl;
+            ofs << "        return cycles;" << endl;
+            numOps++;
+        });
+        ofs << "    return cycles;" << endl << "}" << endl << endl;
+    }
+
+    ofs << "const AotBlock s_blocks[] = {" << endl;
+    for(const auto& block : blocks)
+    {
+        const word_t start = block.first;
+        ofs << "    {0x" << setw(4) << start << ", &Block" << setw(4) << start << "}," << endl;
+    }
+    ofs << "};" << endl << endl;
+    ofs << "const bool s_registered = Aot::Register(0x" << setw(16) << ram.CartridgeHash()
+        << "ull, s_blocks, sizeof(s_blocks) / sizeof(s_blocks[0]));" << endl;
+    ofs << "} // namespace" << endl << "} // namespace atre" << endl;
+
+    cout << dec << "Translated " << blocks.size() << " blocks (" << numOps << " instructions) to " << outFile << endl;
+}
+} // namespace atre
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "BlockCache.hpp"
+#include "CPU.hpp"
+#include "atre.hpp"
+
+namespace atre
+{
+// entry of a cartridge compiled ahead of time
+struct AotBlock
+{
+    word_t      start;
+    NativeBlock native;
+};
+
+// cartridges translated to C++ by the "aot" command; generated units
+// register themselves at startup and are picked by cartridge hash
+class Aot
+{
+public:
+    typedef std::array<NativeBlock, CARTRIDGE_SIZE> Image;
+
+    static bool         Register(uint64_t cartridgeHash, const AotBlock* blocks, size_t count);
+    static const Image* Find(uint64_t cartridgeHash);
+    static void         Translate(const std::string& romFile, const std::string& outFile);
+
+    // runs one instruction for generated code, false when the block has to be left
+    template <byte_t code>
+    static bool Step(CPU* cpu, word_t operand, unsigned opCycles, unsigned& cycles)
+    {
+        const unsigned result = CPU::JitStep<AtariBus, code>(cpu, operand);
+        if(result != CPU::JIT_BAIL)
+        {
+            cycles += opCycles;
+        }
+        return result == CPU::JIT_CONTINUE;
+    }
+
+private:
+    friend class Tests;
+
+    typedef std::function<void(word_t pc, byte_t code, word_t operand)> Visit;
+
+    static std::map<uint64_t, Image>& Images();
+    // decodes straight-line code from start until the end of the block or limit
+    static void Decode(RAM& ram, word_t start, unsigned limit, const Visit& visit);
+    // entries of the blocks found in the cartridge, each to the address past its last instruction
+    static std::map<word_t, word_t> FindBlocks(RAM& ram);
+};
+} // namespace atre
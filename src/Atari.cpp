@@ -26,7 +26,30 @@ void Atari::Boot(const string& osROM, const string& carridgeROM)
     m_CPU->m_enableTraps = true;
     m_CPU->m_showCycles  = true;
     m_CPU->Reset();
-    m_CPU->BreakAt(0xFFFF);
+}
+
+StopReason Atari::RunUntilScanline(word_t scanLine)
+{
+    // the line has to be entered, being on it already doesn't count; a single
+    // step like a WSYNC wait, a skipped poll loop or a native loop may pass it
+    word_t current = m_IO->getScanLine();
+    return m_CPU->RunUntil(StopReason::Frame, [this, scanLine, &current]() {
+        const word_t last = current;
+        current           = m_IO->getScanLine();
+        const int moved   = (current - last + TOTAL_SCANLINES) % TOTAL_SCANLINES;
+        const int ahead   = (scanLine - last + TOTAL_SCANLINES - 1) % TOTAL_SCANLINES + 1;
+        return moved >= ahead;
+    });
+}
+
+StopReason Atari::RunFrame()
+{
+    return RunUntilScanline(0);
+}
+
+StopReason Atari::RunUntilVBlank()
+{
+    return RunUntilScanline(VBLANK_SCANLINE);
 }
 
 } // namespace atre
@@ -29,6 +29,11 @@ public:
     void Reset();
     void Boot(const std::string& osROM, const std::string& carridgeROM);
 
+    // run until ANTIC starts tracing the given line, the next frame or VBLANK
+    StopReason RunUntilScanline(word_t scanLine);
+    StopReason RunFrame();
+    StopReason RunUntilVBlank();
+
 private:
     std::unique_ptr<RAM> m_RAM;
     std::unique_ptr<CPU> m_CPU;
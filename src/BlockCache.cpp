@@ -0,0 +1,183 @@
+#include "BlockCache.hpp"
+
+using namespace std;
+
+namespace atre
+{
+BlockCache::BlockCache(RAM* ram) : m_RAM(ram), m_blocks(MEM_SIZE) {}
+
+void BlockCache::Clear()
+{
+    for(auto& block : m_blocks)
+    {
+        block.reset();
+    }
+}
+
+// returns nullptr when code at pc can't be cached
+Block* BlockCache::Fetch(word_t pc)
+{
+    if(m_RAM->PageBank(pc) == MemoryBank::IO)
+    {
+        return nullptr;
+    }
+
+    auto& block = m_blocks[pc];
+    if(!block)
+    {
+        block        = make_unique<Block>();
+        block->start = pc;
+        Decode(*block);
+    }
+    else if(block->tag != m_RAM->PageTag(pc))
+    {
+        block->ops.clear();
+        Decode(*block);
+    }
+    return block->ops.empty() ? nullptr : block.get();
+}
+
+bool BlockCache::EndsBlock(byte_t code)
+{
+    switch(code)
+    {
+    case 0x00: // BRK
+    case 0x20: // JSR
+    case 0x40: // RTI
+    case 0x4C: // JMP
+    case 0x60: // RTS
+    case 0x6C: // JMP ()
+        return true;
+    default:
+        return CPU::s_opCodeMap[code].adr == AddressingMode::Relative;
+    }
+}
+
+void BlockCache::Decode(Block& block)
+{
+    block.tag       = m_RAM->PageTag(block.start);
+    block.runs      = 0;
+    block.native    = nullptr;
+    const auto page = block.start >> 8;
+
+    word_t pc = block.start;
+    while(block.ops.size() < MAX_BLOCK_OPS)
+    {
+        const byte_t code   = m_RAM->Get(pc);
+        const auto&  opCode = CPU::s_opCodeMap[code];
+        if(opCode.bytes == 0 || (pc + opCode.bytes - 1) >> 8 != page)
+        {
+            // unsupported or crossing into the next page, leave to the interpreter
+            break;
+        }
+
+        MicroOp op;
+        op.pc      = pc;
+        op.code    = code;
+        op.bytes   = static_cast<byte_t>(opCode.bytes);
+        op.cycles  = static_cast<byte_t>(opCode.cycles);
+        op.adr     = opCode.adr;
+        op.operand = 0;
+        if(opCode.bytes == 2)
+        {
+            op.operand = m_RAM->Get(static_cast<word_t>(pc + 1));
+        }
+        else if(opCode.bytes == 3)
+        {
+            op.operand = m_RAM->GetW(static_cast<word_t>(pc + 1));
+        }
+        block.ops.push_back(op);
+
+        if(EndsBlock(code))
+        {
+            break;
+        }
+        pc = static_cast<word_t>(pc + opCode.bytes);
+    }
+    block.idiom = Recognize(block);
+}
+
+// immediate, zero page and absolute reads that only set registers and flags,
+// so a round of them leaves the same state as the one before
+bool BlockCache::IsPollRead(byte_t code)
+{
+    switch(code)
+    {
+    case 0xA9: // LDA
+    case 0xA5:
+    case 0xAD:
+    case 0xA2: // LDX
+    case 0xA6:
+    case 0xAE:
+    case 0xA0: // LDY
+    case 0xA4:
+    case 0xAC:
+    case 0xC9: // CMP
+    case 0xC5:
+    case 0xCD:
+    case 0xE0: // CPX
+    case 0xE4:
+    case 0xEC:
+    case 0xC0: // CPY
+    case 0xC4:
+    case 0xCC:
+    case 0x24: // BIT
+    case 0x2C:
+    case 0x29: // AND #
+        return true;
+    default:
+        return false;
+    }
+}
+
+Idiom BlockCache::Recognize(const Block& block)
+{
+    const auto& ops = block.ops;
+    const auto  num = ops.size();
+    if(num >= 2 && ops[num - 1].adr == AddressingMode::Relative &&
+       static_cast<word_t>(ops[num - 1].pc + ops[num - 1].bytes + static_cast<sbyte_t>(ops[num - 1].operand)) == block.start &&
+       all_of(ops.begin(), ops.end() - 1, [](const MicroOp& op) { return IsPollRead(op.code); }))
+    {
+        return Idiom::Poll;
+    }
+    if(num < 3 || num > 4)
+    {
+        return Idiom::None;
+    }
+
+    const MicroOp& branch = ops[num - 1];
+    if(branch.code != 0xD0 || static_cast<word_t>(branch.pc + branch.bytes + static_cast<sbyte_t>(branch.operand)) != block.start)
+    {
+        return Idiom::None;
+    }
+
+    bool byX;
+    switch(ops[num - 2].code)
+    {
+    case 0xE8: // INX
+    case 0xCA: // DEX
+        byX = true;
+        break;
+    case 0xC8: // INY
+    case 0x88: // DEY
+        byX = false;
+        break;
+    default:
+        return Idiom::None;
+    }
+
+    // abs,X or abs,Y matching the counter, (zp),Y only exists for Y
+    auto indexed = [byX](const MicroOp& op, byte_t absX, byte_t absY, byte_t indirectY) {
+        return op.code == (byX ? absX : absY) || (!byX && op.code == indirectY);
+    };
+    if(!indexed(ops[num - 3], 0x9D, 0x99, 0x91)) // STA
+    {
+        return Idiom::None;
+    }
+    if(num == 3)
+    {
+        return Idiom::Fill;
+    }
+    return indexed(ops[0], 0xBD, 0xB9, 0xB1) ? Idiom::Copy : Idiom::None; // LDA
+}
+} // namespace atre
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "CPU.hpp"
+#include "RAM.hpp"
+
+namespace atre
+{
+// single pre-decoded instruction
+struct MicroOp
+{
+    word_t         pc;
+    word_t         operand;
+    byte_t         code;
+    byte_t         bytes;
+    byte_t         cycles;
+    AddressingMode adr;
+};
+
+// loops at the block start that CPU::RunIdiom executes straight on memory
+// or CPU::SkipPoll skips while nothing they read can change
+enum class Idiom : byte_t
+{
+    None,
+    Fill, // STA abs,X / abs,Y / (zp),Y, INX / DEX / INY / DEY, BNE start
+    Copy, // LDA and STA indexed by the same register, then as Fill
+    Poll  // LDA, LDX, LDY, CMP, CPX, CPY, BIT and AND #, any branch to start
+};
+
+// straight-line run of instructions within one page, ending at the first
+// change of flow
+struct Block
+{
+    word_t               start;
+    uint32_t             tag;
+    std::vector<MicroOp> ops;
+    unsigned             runs;
+    NativeBlock          native;
+    unsigned             epoch;
+    Idiom                idiom;
+};
+
+class BlockCache
+{
+public:
+    BlockCache(RAM* ram);
+
+    Block* Fetch(word_t pc);
+    void   Clear();
+
+private:
+    const static size_t MAX_BLOCK_OPS = 32;
+
+    RAM*                                m_RAM;
+    std::vector<std::unique_ptr<Block>> m_blocks;
+
+    static bool  EndsBlock(byte_t code);
+    static bool  IsPollRead(byte_t code);
+    static Idiom Recognize(const Block& block);
+
+    void Decode(Block& block);
+};
+} // namespace atre
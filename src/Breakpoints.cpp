@@ -0,0 +1,102 @@
+#include "Breakpoints.hpp"
+
+using namespace std;
+
+namespace atre
+{
+Breakpoints::Breakpoints() : m_pages(), m_counts(), m_conditionals() {}
+
+void Breakpoints::Add(Access access, word_t start, word_t end)
+{
+    if(access == Access::Execute)
+    {
+        m_conditionals.erase(m_conditionals.lower_bound(start), m_conditionals.upper_bound(end));
+    }
+    Update(access, start, end, true);
+}
+
+void Breakpoints::AddConditional(word_t addr, Condition condition)
+{
+    Add(Access::Execute, addr, addr);
+    m_conditionals.insert_or_assign(addr, Conditional {move(condition), 0});
+}
+
+Breakpoints::Conditional* Breakpoints::FindConditional(word_t addr)
+{
+    if(m_conditionals.empty())
+    {
+        return nullptr;
+    }
+    const auto conditional = m_conditionals.find(addr);
+    return conditional == m_conditionals.end() ? nullptr : &conditional->second;
+}
+
+void Breakpoints::Remove(Access access, word_t start, word_t end)
+{
+    if(access == Access::Execute)
+    {
+        m_conditionals.erase(m_conditionals.lower_bound(start), m_conditionals.upper_bound(end));
+    }
+    Update(access, start, end, false);
+}
+
+void Breakpoints::Clear()
+{
+    m_pages     = {};
+    m_counts[0] = m_counts[1] = m_counts[2] = 0;
+    m_conditionals.clear();
+}
+
+void Breakpoints::Update(Access access, word_t start, word_t end, bool set)
+{
+    if(end < start)
+    {
+        throw runtime_error("Invalid address range");
+    }
+    for(unsigned addr = start; addr <= end; addr++)
+    {
+        Page&          page = m_pages[static_cast<int>(access)][addr >> 8];
+        uint64_t&      word = page.bits[(addr & 0xFF) >> 6];
+        const uint64_t bit  = uint64_t(1) << (addr & 63);
+        if(static_cast<bool>(word & bit) == set)
+        {
+            continue;
+        }
+        word ^= bit;
+        if(set)
+        {
+            page.count++;
+            m_counts[static_cast<int>(access)]++;
+        }
+        else
+        {
+            page.count--;
+            m_counts[static_cast<int>(access)]--;
+        }
+    }
+}
+
+// ranges past the end of memory are cut off
+bool Breakpoints::Any(Access access, unsigned start, unsigned end) const
+{
+    if(!m_counts[static_cast<int>(access)])
+    {
+        return false;
+    }
+    end = min(end, static_cast<unsigned>(MEM_SIZE - 1));
+    for(unsigned addr = start; addr <= end; addr++)
+    {
+        if(!m_pages[static_cast<int>(access)][addr >> 8].count)
+        {
+            // skip to the next page
+            addr |= 0xFF;
+            continue;
+        }
+        if(IsSet(access, static_cast<word_t>(addr)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace atre
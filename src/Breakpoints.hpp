@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Condition.hpp"
+#include "atre.hpp"
+
+namespace atre
+{
+enum class Access : byte_t
+{
+    Execute,
+    Read,
+    Write
+};
+
+// PC breakpoints and memory watchpoints with one bit per address and access
+// kind; a per-page count lets lookups on unwatched pages skip the bitmap.
+// PC breakpoints can have a condition, only looked up once the PC matches
+class Breakpoints
+{
+public:
+    struct Conditional
+    {
+        Condition condition;
+        unsigned  hits;
+    };
+
+    Breakpoints();
+
+    // inclusive address ranges
+    void Add(Access access, word_t start, word_t end);
+    void Remove(Access access, word_t start, word_t end);
+    bool Any(Access access, unsigned start, unsigned end) const;
+    void Clear();
+    // replaces the condition of a breakpoint at addr
+    void         AddConditional(word_t addr, Condition condition);
+    Conditional* FindConditional(word_t addr);
+
+    inline bool IsArmed() const
+    {
+        return m_counts[0] || m_counts[1] || m_counts[2];
+    }
+
+    inline bool IsWatching() const
+    {
+        return m_counts[static_cast<int>(Access::Read)] || m_counts[static_cast<int>(Access::Write)];
+    }
+
+    inline bool IsSet(Access access, word_t addr) const
+    {
+        const Page& page = m_pages[static_cast<int>(access)][addr >> 8];
+        return page.count && (page.bits[(addr & 0xFF) >> 6] >> (addr & 63) & 1);
+    }
+
+private:
+    struct Page
+    {
+        unsigned count;
+        uint64_t bits[4];
+    };
+
+    std::array<std::array<Page, 256>, 3> m_pages;
+    unsigned                             m_counts[3];
+    std::map<word_t, Conditional>        m_conditionals;
+
+    void Update(Access access, word_t start, word_t end, bool set);
+};
+} // namespace atre
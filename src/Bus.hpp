@@ -0,0 +1,64 @@
+#pragma once
+
+#include "RAM.hpp"
+#include "atre.hpp"
+
+namespace atre
+{
+enum class BusType : byte_t
+{
+    Atari,
+    Flat
+};
+
+// the Atari memory map: banked ROMs, chip registers and feedback registers
+struct AtariBus
+{
+    static constexpr bool DEBUG = false;
+
+    static inline byte_t Get(RAM* ram, word_t addr)
+    {
+        return ram->Get(addr);
+    }
+
+    static inline void Set(RAM* ram, word_t addr, byte_t val)
+    {
+        ram->Set(addr, val);
+    }
+
+    static inline word_t GetW(RAM* ram, word_t addr)
+    {
+        return ram->GetW(addr);
+    }
+};
+
+// 64 kB of plain memory for CPU-only workloads like the test ROMs, every
+// access compiles to an array access
+struct FlatBus
+{
+    static constexpr bool DEBUG = false;
+
+    static inline byte_t Get(RAM* ram, word_t addr)
+    {
+        return ram->DirectGet(addr);
+    }
+
+    static inline void Set(RAM* ram, word_t addr, byte_t val)
+    {
+        ram->DirectSet(addr, val);
+    }
+
+    static inline word_t GetW(RAM* ram, word_t addr)
+    {
+        return static_cast<word_t>((ram->DirectGet(static_cast<word_t>(addr + 1)) << 8) + ram->DirectGet(addr));
+    }
+};
+
+// same memory as Bus, run while breakpoints, watchpoints, traps or step
+// dumps are armed so the plain variants don't check for any of them
+template <class Bus>
+struct DebugBus : Bus
+{
+    static constexpr bool DEBUG = true;
+};
+} // namespace atre
@@ -1,31 +1,96 @@
+#include "Alu.hpp"
+#include "Aot.hpp"
+#include "BlockCache.hpp"
 #include "CPU.hpp"
 #include "Chips.hpp"
+#include "Coverage.hpp"
 #include "IO.hpp"
+#include "Jit.hpp"
+#include "MathPack.hpp"
+#include "Profiler.hpp"
+#include "Trace.hpp"
 
 using namespace std;
 
+// expands X(code) for each of the 256 opcodes
+#define ATRE_OPCODES16(X, c)                                                                                                       \
+    X(c + 0x0) X(c + 0x1) X(c + 0x2) X(c + 0x3) X(c + 0x4) X(c + 0x5) X(c + 0x6) X(c + 0x7) X(c + 0x8) X(c + 0x9) X(c + 0xA) \
+        X(c + 0xB) X(c + 0xC) X(c + 0xD) X(c + 0xE) X(c + 0xF)
+#define ATRE_OPCODES(X)                                                                                                         \
+    ATRE_OPCODES16(X, 0x00)                                                                                                     \
+    ATRE_OPCODES16(X, 0x10)                                                                                                     \
+    ATRE_OPCODES16(X, 0x20)                                                                                                     \
+    ATRE_OPCODES16(X, 0x30)                                                                                                     \
+    ATRE_OPCODES16(X, 0x40)                                                                                                     \
+    ATRE_OPCODES16(X, 0x50)                                                                                                     \
+    ATRE_OPCODES16(X, 0x60)                                                                                                     \
+    ATRE_OPCODES16(X, 0x70)                                                                                                     \
+    ATRE_OPCODES16(X, 0x80)                                                                                                     \
+    ATRE_OPCODES16(X, 0x90)                                                                                                     \
+    ATRE_OPCODES16(X, 0xA0)                                                                                                     \
+    ATRE_OPCODES16(X, 0xB0)                                                                                                     \
+    ATRE_OPCODES16(X, 0xC0)                                                                                                     \
+    ATRE_OPCODES16(X, 0xD0)                                                                                                     \
+    ATRE_OPCODES16(X, 0xE0)                                                                                                     \
+    ATRE_OPCODES16(X, 0xF0)
+
 namespace atre
 {
-CPU::CPU(RAM* ram) :
-    m_showCycles(), m_enableTraps(), m_showSteps(), m_callStack(), m_opCodeMap(), A(), X(), Y(), S(), PC(), F(), BRK(), m_cycles(0),
-    m_seconds(0), m_irqPending(), m_nmiPending(), m_waitCycles(0), m_RAM(ram), m_callbacks(), m_IO()
-{
-    InitializeOPCodes();
-}
+CPU::CPU(RAM* ram, BusType busType) :
+    m_showCycles(), m_enableTraps(), m_showSteps(), m_enableJIT(), m_enableMathPack(), m_callStack(), m_breakpoints(), m_interrupts(),
+    m_scheduler(), A(), X(), Y(), S(), PC(), F(), m_nResult(), m_zResult(1), BRK(), m_cycles(0), m_seconds(0), m_clockMultiplier(1),
+    m_clockPhase(), m_waitCycles(0), m_stopReason(), m_watchHit(), m_watchAddr(), m_watchAccess(), m_traceAddr(), m_RAM(ram),
+    m_busType(busType), m_callbacks(), m_trace(), m_profiler(), m_coverage(), m_IO(), m_blockCache(make_unique<BlockCache>(ram)),
+    m_nextOp(), m_blockEnd(), m_blockPage(), m_blockTag(), m_pollStart(), m_pollCycles(), m_pollTime(),
+    m_jit(make_unique<Jit>(this, ram, busType == BusType::Flat ? s_jitThunks<FlatBus>.data() : s_jitThunks<AtariBus>.data())),
+    m_aotBlocks(), m_mathPack(make_unique<MathPack>(ram))
+{}
+
+CPU::~CPU() {}
 
 void CPU::Attach(Callbacks* callbacks)
 {
     m_callbacks = callbacks;
 }
 
+// records every instruction while attached, nullptr detaches
+void CPU::AttachTrace(Trace* trace)
+{
+    m_trace = trace;
+}
+
+// counts cycles per instruction and call while attached, nullptr detaches
+void CPU::AttachProfiler(Profiler* profiler)
+{
+    m_profiler = profiler;
+}
+
+// marks executed bytes while attached, nullptr detaches
+void CPU::AttachCoverage(Coverage* coverage)
+{
+    m_coverage = coverage;
+}
+
 void CPU::Connect(IO* io)
 {
     m_IO = io;
 }
 
+// cycles of the chips, which run at the stock clock
 void CPU::Wait(unsigned cycles)
 {
-    m_waitCycles = cycles;
+    m_waitCycles = cycles * m_clockMultiplier;
+}
+
+// the chips tick once every multiplier CPU cycles, 1 is the stock clock
+void CPU::SetClockMultiplier(unsigned multiplier)
+{
+    if(!multiplier || multiplier > MAX_CLOCK_MULTIPLIER)
+    {
+        throw runtime_error("Unsupported clock multiplier");
+    }
+    m_clockMultiplier = multiplier;
+    m_clockPhase      = 0;
 }
 
 void CPU::Reset()
@@ -35,16 +100,17 @@ void CPU::Reset()
         m_callbacks->OnReset();
     }
     A = X = Y    = 0;
-    F            = CPU::IGNORED_FLAG;
     S            = 0xFF;
     PC           = m_RAM->GetW(0xFFFC);
-    BRK          = 0xFFFC;
     m_cycles     = 0;
     m_seconds    = 0;
-    m_irqPending = false;
-    m_nmiPending = false;
-    m_callStack.clear();
-    m_callStack.push_back(make_pair(PC, "Entry"));
+    m_interrupts.Reset();
+    SetF(CPU::IGNORED_FLAG);
+    m_callStack.Clear();
+    m_callStack.Push(PC, CallKind::Entry, S);
+
+    const Aot::Image* image = Aot::Find(m_RAM->CartridgeHash());
+    m_aotBlocks             = image ? image->data() : nullptr;
 }
 
 void CPU::SetFlag(flag_t flag)
@@ -59,7 +125,26 @@ void CPU::ClearFlag(flag_t flag)
 
 bool CPU::IsSetFlag(flag_t flag) const
 {
-    return F & flag;
+    return GetF() & flag;
+}
+
+// N and Z are kept as the last result and only folded into F on demand
+byte_t CPU::GetF() const
+{
+    return (F & ~(CPU::NEGATIVE_FLAG | CPU::ZERO_FLAG)) | (m_nResult & CPU::NEGATIVE_FLAG) | (m_zResult ? 0 : CPU::ZERO_FLAG);
+}
+
+void CPU::SetF(byte_t f)
+{
+    F         = f;
+    m_nResult = f;
+    m_zResult = (f & CPU::ZERO_FLAG) ? 0 : 1;
+}
+
+void CPU::SetNZ(byte_t result)
+{
+    m_nResult = result;
+    m_zResult = result;
 }
 
 void CPU::SetFlag(flag_t flag, bool isSet)
@@ -74,16 +159,63 @@ void CPU::SetFlag(flag_t flag, bool isSet)
     }
 }
 
+template <class Bus>
+byte_t CPU::Read(word_t addr)
+{
+    if constexpr(Bus::DEBUG)
+    {
+        CheckWatch(Access::Read, addr);
+        m_traceAddr = addr;
+    }
+    return Bus::Get(m_RAM, addr);
+}
+
+template <class Bus>
+word_t CPU::ReadW(word_t addr)
+{
+    if constexpr(Bus::DEBUG)
+    {
+        CheckWatch(Access::Read, addr);
+        CheckWatch(Access::Read, static_cast<word_t>(addr + 1));
+        m_traceAddr = addr;
+    }
+    return Bus::GetW(m_RAM, addr);
+}
+
+template <class Bus>
+void CPU::Write(word_t addr, byte_t val)
+{
+    if constexpr(Bus::DEBUG)
+    {
+        CheckWatch(Access::Write, addr);
+        m_traceAddr = addr;
+    }
+    Bus::Set(m_RAM, addr, val);
+}
+
+// remembered until the instruction completes
+void CPU::CheckWatch(Access access, word_t addr)
+{
+    if(m_breakpoints.IsSet(access, addr))
+    {
+        m_watchHit    = true;
+        m_watchAddr   = addr;
+        m_watchAccess = access;
+    }
+}
+
+template <class Bus>
 void CPU::StackPush(byte_t val)
 {
-    m_RAM->Set(0x100 + S, val);
+    Write<Bus>(0x100 + S, val);
     S--;
 }
 
+template <class Bus>
 byte_t CPU::StackPull()
 {
     S++;
-    return m_RAM->Get(0x100 + S);
+    return Read<Bus>(0x100 + S);
 }
 
 void CPU::Cycles(unsigned long cycles)
@@ -91,9 +223,18 @@ void CPU::Cycles(unsigned long cycles)
     m_cycles += cycles;
     if(m_IO)
     {
-        while(cycles-- > 0)
+        if(m_clockMultiplier != 1)
+        {
+            m_clockPhase += cycles;
+            cycles = m_clockPhase / m_clockMultiplier;
+            m_clockPhase %= m_clockMultiplier;
+        }
+        // the chips only run when one of their events is due
+        const uint64_t until = m_scheduler.Now() + cycles;
+        ChipEvent      event;
+        while(m_scheduler.Next(until, event))
         {
-            m_IO->Tick();
+            m_IO->Dispatch(event);
         }
     }
     if(m_cycles >= CYCLES_PER_SEC)
@@ -107,134 +248,119 @@ void CPU::Cycles(unsigned long cycles)
     }
 }
 
-byte_t CPU::GetOP(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+byte_t CPU::GetOP(word_t operand)
 {
-    switch(adr)
+    if constexpr(adr == AddressingMode::Accumulator)
     {
-    case AddressingMode::Accumulator: {
         return A;
     }
-    case AddressingMode::Immediate: {
-        return m_RAM->Get(opIndex);
-    }
-    case AddressingMode::Absolute: {
-        word_t addr = m_RAM->GetW(opIndex);
-        return m_RAM->Get(addr);
+    else if constexpr(adr == AddressingMode::Immediate)
+    {
+        return static_cast<byte_t>(operand);
     }
-    case AddressingMode::ZeroPage: {
-        return m_RAM->Get(m_RAM->Get(opIndex));
+    else if constexpr(adr == AddressingMode::Absolute || adr == AddressingMode::ZeroPage)
+    {
+        return Read<Bus>(operand);
     }
-    case AddressingMode::ZeroPageX: {
-        return m_RAM->Get((m_RAM->Get(opIndex) + X) & 0xFF);
+    else if constexpr(adr == AddressingMode::ZeroPageX)
+    {
+        return Read<Bus>((operand + X) & 0xFF);
     }
-    case AddressingMode::ZeroPageY: {
-        return m_RAM->Get((m_RAM->Get(opIndex) + Y) & 0xFF);
+    else if constexpr(adr == AddressingMode::ZeroPageY)
+    {
+        return Read<Bus>((operand + Y) & 0xFF);
     }
-    case AddressingMode::AbsoluteX:
-    case AddressingMode::AbsoluteXPaged: {
-        word_t baseAddr  = m_RAM->GetW(opIndex);
-        auto   finalAddr = static_cast<word_t>(baseAddr + X);
-        if(adr == AddressingMode::AbsoluteXPaged && baseAddr >> 8 != finalAddr >> 8)
+    else if constexpr(adr == AddressingMode::AbsoluteX || adr == AddressingMode::AbsoluteXPaged)
+    {
+        auto finalAddr = static_cast<word_t>(operand + X);
+        if(adr == AddressingMode::AbsoluteXPaged && operand >> 8 != finalAddr >> 8)
         {
             Cycles(1);
         }
-        return m_RAM->Get(finalAddr);
+        return Read<Bus>(finalAddr);
     }
-    case AddressingMode::AbsoluteY:
-    case AddressingMode::AbsoluteYPaged: {
-        word_t baseAddr  = m_RAM->GetW(opIndex);
-        auto   finalAddr = static_cast<word_t>(baseAddr + Y);
-        if(adr == AddressingMode::AbsoluteYPaged && baseAddr >> 8 != finalAddr >> 8)
+    else if constexpr(adr == AddressingMode::AbsoluteY || adr == AddressingMode::AbsoluteYPaged)
+    {
+        auto finalAddr = static_cast<word_t>(operand + Y);
+        if(adr == AddressingMode::AbsoluteYPaged && operand >> 8 != finalAddr >> 8)
         {
             Cycles(1);
         }
-        return m_RAM->Get(finalAddr);
+        return Read<Bus>(finalAddr);
     }
-    case AddressingMode::IndexedIndirect: {
-        word_t baseAddr = (m_RAM->Get(opIndex) + X) & 0xFF;
-        word_t loTarget = m_RAM->Get(baseAddr);
-        word_t hiTarget = m_RAM->Get((baseAddr + 1) & 0xFF);
+    else if constexpr(adr == AddressingMode::IndexedIndirect)
+    {
+        word_t baseAddr = (operand + X) & 0xFF;
+        word_t loTarget = Read<Bus>(baseAddr);
+        word_t hiTarget = Read<Bus>((baseAddr + 1) & 0xFF);
         word_t addr     = loTarget + (hiTarget << 8);
-        return m_RAM->Get(addr);
+        return Read<Bus>(addr);
     }
-    case AddressingMode::IndirectIndexed:
-    case AddressingMode::IndirectIndexedPaged: {
-        byte_t basePointer  = m_RAM->Get(opIndex);
-        word_t loTarget     = m_RAM->Get(basePointer);
-        word_t hiTarget     = m_RAM->Get((basePointer + 1) & 0xFF);
+    else if constexpr(adr == AddressingMode::IndirectIndexed || adr == AddressingMode::IndirectIndexedPaged)
+    {
+        word_t loTarget     = Read<Bus>(operand);
+        word_t hiTarget     = Read<Bus>((operand + 1) & 0xFF);
         word_t baseAddress  = loTarget + (hiTarget << 8);
         word_t finalAddress = baseAddress + Y;
         if(adr == AddressingMode::IndirectIndexedPaged && baseAddress >> 8 != finalAddress >> 8)
         {
             Cycles(1);
         }
-        return m_RAM->Get(finalAddress);
+        return Read<Bus>(finalAddress);
     }
-    default:
-        throw runtime_error("Not supported addressing mode");
+    else
+    {
+        static_assert(adr != adr, "Not supported addressing mode");
     }
 }
 
-void CPU::SetOP(word_t opIndex, AddressingMode adr, byte_t val)
+template <class Bus, AddressingMode adr>
+void CPU::SetOP(word_t operand, byte_t val)
 {
-    switch(adr)
+    if constexpr(adr == AddressingMode::Accumulator)
     {
-    case AddressingMode::Accumulator: {
         A = val;
-        break;
-    }
-    case AddressingMode::Immediate: {
-        m_RAM->Set(opIndex, val);
-        break;
-    }
-    case AddressingMode::Absolute: {
-        word_t addr = m_RAM->GetW(opIndex);
-        m_RAM->Set(addr, val);
-        break;
     }
-    case AddressingMode::ZeroPage: {
-        m_RAM->Set(m_RAM->Get(opIndex), val);
-        break;
+    else if constexpr(adr == AddressingMode::Absolute || adr == AddressingMode::ZeroPage)
+    {
+        Write<Bus>(operand, val);
     }
-    case AddressingMode::ZeroPageX: {
-        m_RAM->Set((m_RAM->Get(opIndex) + X) & 0xFF, val);
-        break;
+    else if constexpr(adr == AddressingMode::ZeroPageX)
+    {
+        Write<Bus>((operand + X) & 0xFF, val);
     }
-    case AddressingMode::ZeroPageY: {
-        m_RAM->Set((m_RAM->Get(opIndex) + Y) & 0xFF, val);
-        break;
+    else if constexpr(adr == AddressingMode::ZeroPageY)
+    {
+        Write<Bus>((operand + Y) & 0xFF, val);
     }
-    case AddressingMode::AbsoluteX: {
-        word_t baseAddr  = m_RAM->GetW(opIndex);
-        auto   finalAddr = static_cast<word_t>(baseAddr + X);
-        m_RAM->Set(finalAddr, val);
-        break;
+    else if constexpr(adr == AddressingMode::AbsoluteX)
+    {
+        Write<Bus>(static_cast<word_t>(operand + X), val);
     }
-    case AddressingMode::AbsoluteY: {
-        word_t baseAddr  = m_RAM->GetW(opIndex);
-        auto   finalAddr = static_cast<word_t>(baseAddr + Y);
-        m_RAM->Set(finalAddr, val);
-        break;
+    else if constexpr(adr == AddressingMode::AbsoluteY)
+    {
+        Write<Bus>(static_cast<word_t>(operand + Y), val);
     }
-    case AddressingMode::IndexedIndirect: {
-        word_t baseAddr = (m_RAM->Get(opIndex) + X) & 0xFF;
-        word_t loTarget = m_RAM->Get(baseAddr);
-        word_t hiTarget = m_RAM->Get((baseAddr + 1) & 0xFF);
+    else if constexpr(adr == AddressingMode::IndexedIndirect)
+    {
+        word_t baseAddr = (operand + X) & 0xFF;
+        word_t loTarget = Read<Bus>(baseAddr);
+        word_t hiTarget = Read<Bus>((baseAddr + 1) & 0xFF);
         word_t addr     = loTarget + (hiTarget << 8);
-        m_RAM->Set(addr, val);
-        break;
+        Write<Bus>(addr, val);
     }
-    case AddressingMode::IndirectIndexed: {
-        byte_t basePointer  = m_RAM->Get(opIndex);
-        word_t loTarget     = m_RAM->Get(basePointer);
-        word_t hiTarget     = m_RAM->Get((basePointer + 1) & 0xFF);
+    else if constexpr(adr == AddressingMode::IndirectIndexed)
+    {
+        word_t loTarget     = Read<Bus>(operand);
+        word_t hiTarget     = Read<Bus>((operand + 1) & 0xFF);
         word_t baseAddress  = loTarget + (hiTarget << 8);
         word_t finalAddress = baseAddress + Y;
-        m_RAM->Set(finalAddress, val);
-        break;
+        Write<Bus>(finalAddress, val);
     }
-    default:
-        throw runtime_error("Not supported addressing mode");
+    else
+    {
+        static_assert(adr != adr, "Not supported addressing mode");
     }
 }
 
@@ -248,60 +374,57 @@ void CPU::ADC(byte_t op)
         SetFlag(CPU::CARRY_FLAG, res > 99);
         res %= 100;
         A = static_cast<byte_t>(((res / 10) << 4) + (res % 10));
-        SetFlag(CPU::NEGATIVE_FLAG, IsNegative(static_cast<byte_t>(res)));
-        SetFlag(CPU::ZERO_FLAG, IsZero(static_cast<byte_t>(res)));
+        SetNZ(static_cast<byte_t>(res));
     }
     else
     {
-        word_t wresult = A + op + (IsSetFlag(CPU::CARRY_FLAG) ? 1 : 0);
-        byte_t res     = (byte_t)wresult;
-        SetFlag(CPU::CARRY_FLAG, wresult > 255);
-        SetFlag(CPU::NEGATIVE_FLAG, IsNegative(res));
-        SetFlag(CPU::ZERO_FLAG, IsZero(res));
-        SetFlag(CPU::OVERFLOW_FLAG, IsNegative(static_cast<byte_t>(A ^ res)) & IsNegative(static_cast<byte_t>(op ^ res)));
-        A = res;
+        const AluResult res = Alu::Add(A, op, IsSetFlag(CPU::CARRY_FLAG));
+        SetFlag(CPU::CARRY_FLAG, res.carry);
+        SetNZ(res.value);
+        SetFlag(CPU::OVERFLOW_FLAG, res.overflow);
+        A = res.value;
     }
 }
 
-void CPU::opADC(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opADC(word_t operand)
 {
-    ADC(GetOP(opIndex, adr));
+    ADC(GetOP<Bus, adr>(operand));
 }
 
 void CPU::AND(byte_t op)
 {
     A &= op;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(A));
-    SetFlag(CPU::ZERO_FLAG, IsZero(A));
+    SetNZ(A);
 }
 
-void CPU::opAND(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opAND(word_t operand)
 {
-    AND(GetOP(opIndex, adr));
+    AND(GetOP<Bus, adr>(operand));
 }
 
 byte_t CPU::ASL(byte_t op)
 {
-    auto res = op << 1;
-    SetFlag(CPU::CARRY_FLAG, res & 0x100);
-    op = static_cast<byte_t>(res & 0xFF);
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(op));
-    SetFlag(CPU::ZERO_FLAG, IsZero(op));
-    return op;
+    const AluResult res = Alu::ShiftLeft(op, false);
+    SetFlag(CPU::CARRY_FLAG, res.carry);
+    SetNZ(res.value);
+    return res.value;
 }
 
 // Arithmetic Shift Left
-void CPU::opASL(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opASL(word_t operand)
 {
-    SetOP(opIndex, adr, ASL(GetOP(opIndex, adr)));
+    SetOP<Bus, adr>(operand, ASL(GetOP<Bus, adr>(operand)));
 }
 
-void CPU::Branch(word_t opIndex, bool condition)
+void CPU::Branch(word_t operand, bool condition)
 {
     if(condition)
     {
         Cycles(1);
-        const auto target = static_cast<word_t>(PC + static_cast<sbyte_t>(m_RAM->Get(opIndex)));
+        const auto target = static_cast<word_t>(PC + static_cast<sbyte_t>(operand));
         if(PC >> 8 != target >> 8)
         {
             Cycles(1);
@@ -311,385 +434,373 @@ void CPU::Branch(word_t opIndex, bool condition)
 }
 
 // Branch on Carry Clear
-void CPU::opBCC(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBCC(word_t operand)
 {
-    Branch(opIndex, !IsSetFlag(CPU::CARRY_FLAG));
+    Branch(operand, !IsSetFlag(CPU::CARRY_FLAG));
 }
 
 // Branch on Carry Set
-void CPU::opBCS(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBCS(word_t operand)
 {
-    Branch(opIndex, IsSetFlag(CPU::CARRY_FLAG));
+    Branch(operand, IsSetFlag(CPU::CARRY_FLAG));
 }
 
 // Branch on Result Zero
-void CPU::opBEQ(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBEQ(word_t operand)
 {
-    Branch(opIndex, IsSetFlag(CPU::ZERO_FLAG));
+    Branch(operand, IsZero(m_zResult));
 }
 
 // Branch on Result Minus
-void CPU::opBMI(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBMI(word_t operand)
 {
-    Branch(opIndex, IsSetFlag(CPU::NEGATIVE_FLAG));
+    Branch(operand, IsNegative(m_nResult));
 }
 
 // Branch on Result not Zero
-void CPU::opBNE(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBNE(word_t operand)
 {
-    Branch(opIndex, !IsSetFlag(CPU::ZERO_FLAG));
+    Branch(operand, !IsZero(m_zResult));
 }
 
 // Branch on Result Plus
-void CPU::opBPL(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBPL(word_t operand)
 {
-    Branch(opIndex, !IsSetFlag(CPU::NEGATIVE_FLAG));
+    Branch(operand, !IsNegative(m_nResult));
 }
 
 // Branch on Overflow Clear
-void CPU::opBVC(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBVC(word_t operand)
 {
-    Branch(opIndex, !IsSetFlag(CPU::OVERFLOW_FLAG));
+    Branch(operand, !IsSetFlag(CPU::OVERFLOW_FLAG));
 }
 
 // Branch on Overflow Set
-void CPU::opBVS(word_t opIndex, AddressingMode /*adr*/)
+void CPU::opBVS(word_t operand)
 {
-    Branch(opIndex, IsSetFlag(CPU::OVERFLOW_FLAG));
+    Branch(operand, IsSetFlag(CPU::OVERFLOW_FLAG));
 }
 
 // Test Bits in getRAM with Accumulator
-void CPU::opBIT(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opBIT(word_t operand)
 {
-    byte_t op = GetOP(opIndex, adr);
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(op));
+    byte_t op = GetOP<Bus, adr>(operand);
     SetFlag(CPU::OVERFLOW_FLAG, op & 0b01000000);
-    byte_t res = (A & op);
-    SetFlag(CPU::ZERO_FLAG, IsZero(res));
+    m_nResult = op;
+    m_zResult = A & op;
 }
 
+// single interrupts from outside the chips, which drive the controller directly
 void CPU::IRQ()
 {
-    m_irqPending = true;
+    m_interrupts.RequestIRQ(IRQSource::EXTERNAL);
 }
 
 void CPU::NMI()
 {
-    m_nmiPending = true;
+    m_interrupts.RaiseNMI(NMISource::EXTERNAL);
 }
 
 // external interrupt
+template <class Bus>
 void CPU::doIRQ()
 {
     if(m_callbacks)
     {
         m_callbacks->OnIRQ();
     }
-    StackPush(PC >> 8);
-    StackPush(PC & 0xFF);
-    StackPush(F);
+    StackPush<Bus>(PC >> 8);
+    StackPush<Bus>(PC & 0xFF);
+    StackPush<Bus>(GetF());
     SetFlag(CPU::INTERRUPT_FLAG);
     PC = m_RAM->GetW(0xFFFE); // jump to vector
-    m_callStack.push_back(make_pair(PC, "IRQ"));
+    m_callStack.Push(PC, CallKind::IRQ, S);
 }
 
 // non-masked interrupt
+template <class Bus>
 void CPU::doNMI()
 {
     if(m_callbacks)
     {
         m_callbacks->OnNMI();
     }
-    StackPush(PC >> 8);
-    StackPush(PC & 0xFF);
-    StackPush(F);
+    StackPush<Bus>(PC >> 8);
+    StackPush<Bus>(PC & 0xFF);
+    StackPush<Bus>(GetF());
     SetFlag(CPU::INTERRUPT_FLAG);
     PC = m_RAM->GetW(0xFFFA); // jump to vector
-    m_callStack.push_back(make_pair(PC, "NMI"));
+    m_callStack.Push(PC, CallKind::NMI, S);
 }
 
 // Force Break
-void CPU::opBRK(word_t /*opIndex*/, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opBRK(word_t /*operand*/)
 {
     if(m_callbacks)
     {
         m_callbacks->OnBRK();
     }
     PC++;
-    StackPush(PC >> 8);
-    StackPush(PC & 0xFF);
-    auto f = F;
+    StackPush<Bus>(PC >> 8);
+    StackPush<Bus>(PC & 0xFF);
+    auto f = GetF();
     f |= BREAK_FLAG;
-    StackPush(f);
+    StackPush<Bus>(f);
     SetFlag(CPU::INTERRUPT_FLAG);
     PC = m_RAM->GetW(0xFFFE); // jump to vector
-    m_callStack.push_back(make_pair(PC, "BRK"));
+    m_callStack.Push(PC, CallKind::BRK, S);
 }
 
-void CPU::opCLC(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opCLC(word_t /*operand*/)
 {
     ClearFlag(CPU::CARRY_FLAG);
 }
 
-void CPU::opCLD(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opCLD(word_t /*operand*/)
 {
     ClearFlag(CPU::DECIMAL_FLAG);
 }
 
-void CPU::opCLI(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opCLI(word_t /*operand*/)
 {
     ClearFlag(CPU::INTERRUPT_FLAG);
 }
 
-void CPU::opCLV(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opCLV(word_t /*operand*/)
 {
     ClearFlag(CPU::OVERFLOW_FLAG);
 }
 
 void CPU::Compare(byte_t r, byte_t op)
 {
-    auto res = static_cast<byte_t>((r - op) & 0xFF);
-    SetFlag(CPU::ZERO_FLAG, IsZero(res));
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(res));
-    SetFlag(CPU::CARRY_FLAG, op <= r);
+    const AluResult res = Alu::Compare(r, op);
+    SetNZ(res.value);
+    SetFlag(CPU::CARRY_FLAG, res.carry);
 }
 
-void CPU::opCMP(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opCMP(word_t operand)
 {
-    Compare(A, GetOP(opIndex, adr));
+    Compare(A, GetOP<Bus, adr>(operand));
 }
 
-void CPU::opCPX(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opCPX(word_t operand)
 {
-    Compare(X, GetOP(opIndex, adr));
+    Compare(X, GetOP<Bus, adr>(operand));
 }
 
-void CPU::opCPY(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opCPY(word_t operand)
 {
-    Compare(Y, GetOP(opIndex, adr));
+    Compare(Y, GetOP<Bus, adr>(operand));
 }
 
-void CPU::opDEC(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opDEC(word_t operand)
 {
-    auto res = GetOP(opIndex, adr);
+    auto res = GetOP<Bus, adr>(operand);
     res--;
-    SetFlag(CPU::ZERO_FLAG, IsZero(res));
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(res));
-    SetOP(opIndex, adr, res);
+    SetNZ(res);
+    SetOP<Bus, adr>(operand, res);
 }
 
-void CPU::opDEX(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opDEX(word_t /*operand*/)
 {
     X--;
-    SetFlag(CPU::ZERO_FLAG, IsZero(X));
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(X));
+    SetNZ(X);
 }
 
-void CPU::opDEY(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opDEY(word_t /*operand*/)
 {
     Y--;
-    SetFlag(CPU::ZERO_FLAG, IsZero(Y));
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(Y));
+    SetNZ(Y);
 }
 
-void CPU::opINC(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opINC(word_t operand)
 {
-    auto res = GetOP(opIndex, adr);
+    auto res = GetOP<Bus, adr>(operand);
     res++;
-    SetFlag(CPU::ZERO_FLAG, IsZero(res));
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(res));
-    SetOP(opIndex, adr, res);
+    SetNZ(res);
+    SetOP<Bus, adr>(operand, res);
 }
 
-void CPU::opINX(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opINX(word_t /*operand*/)
 {
     X++;
-    SetFlag(CPU::ZERO_FLAG, IsZero(X));
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(X));
+    SetNZ(X);
 }
 
-void CPU::opINY(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opINY(word_t /*operand*/)
 {
     Y++;
-    SetFlag(CPU::ZERO_FLAG, IsZero(Y));
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(Y));
+    SetNZ(Y);
 }
 
 void CPU::EOR(byte_t op)
 {
     A ^= op;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(A));
-    SetFlag(CPU::ZERO_FLAG, IsZero(A));
+    SetNZ(A);
 }
 
-void CPU::opEOR(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opEOR(word_t operand)
 {
-    EOR(GetOP(opIndex, adr));
+    EOR(GetOP<Bus, adr>(operand));
 }
 
-void CPU::opJMP(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opJMP(word_t operand)
 {
-    switch(adr)
+    if constexpr(adr == AddressingMode::Absolute)
     {
-    case AddressingMode::Absolute: {
-        PC = m_RAM->GetW(opIndex);
-        break;
-    }
-    case AddressingMode::Indirect: {
-        auto addr = m_RAM->GetW(opIndex);
-        PC        = m_RAM->GetW(addr);
-        break;
+        PC = operand;
     }
-    default:
-        throw runtime_error("Not supported addressing mode");
+    else
+    {
+        static_assert(adr == AddressingMode::Indirect, "Not supported addressing mode");
+        PC = ReadW<Bus>(operand);
     }
 }
 
-void CPU::opJSR(word_t opIndex, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opJSR(word_t operand)
 {
     const auto retAddress = static_cast<word_t>(PC - 1); // next instruction - 1
-    StackPush(retAddress >> 8);
-    StackPush(retAddress & 0xFF);
-    PC = m_RAM->GetW(opIndex);
-    m_callStack.push_back(make_pair(PC, "JSR"));
+    StackPush<Bus>(retAddress >> 8);
+    StackPush<Bus>(retAddress & 0xFF);
+    PC = operand;
+    m_callStack.Push(PC, CallKind::JSR, S);
 }
 
-void CPU::opRTS(word_t /*opIndex*/, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opRTS(word_t /*operand*/)
 {
-    if(m_callStack.size())
-    {
-        m_callStack.pop_back();
-    }
-    word_t retAddress = StackPull();
-    retAddress += (StackPull() << 8);
+    word_t retAddress = StackPull<Bus>();
+    retAddress += (StackPull<Bus>() << 8);
+    m_callStack.Sync(S);
     retAddress++; // we pushed next instruction - 1
     PC = retAddress;
 }
 
-void CPU::opLDA(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opLDA(word_t operand)
 {
-    A = GetOP(opIndex, adr);
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(A));
-    SetFlag(CPU::ZERO_FLAG, IsZero(A));
+    A = GetOP<Bus, adr>(operand);
+    SetNZ(A);
 }
 
-void CPU::opLDX(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opLDX(word_t operand)
 {
-    X = GetOP(opIndex, adr);
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(X));
-    SetFlag(CPU::ZERO_FLAG, IsZero(X));
+    X = GetOP<Bus, adr>(operand);
+    SetNZ(X);
 }
 
-void CPU::opLDY(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opLDY(word_t operand)
 {
-    Y = GetOP(opIndex, adr);
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(Y));
-    SetFlag(CPU::ZERO_FLAG, IsZero(Y));
+    Y = GetOP<Bus, adr>(operand);
+    SetNZ(Y);
 }
 
 byte_t CPU::LSR(byte_t op)
 {
-    SetFlag(CPU::CARRY_FLAG, op & 0x01);
-    op >>= 1;
-    ClearFlag(CPU::NEGATIVE_FLAG);
-    SetFlag(CPU::ZERO_FLAG, IsZero(op));
-    return op;
+    const AluResult res = Alu::ShiftRight(op, false);
+    SetFlag(CPU::CARRY_FLAG, res.carry);
+    SetNZ(res.value);
+    return res.value;
 }
 
-void CPU::opLSR(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opLSR(word_t operand)
 {
-    SetOP(opIndex, adr, LSR(GetOP(opIndex, adr)));
+    SetOP<Bus, adr>(operand, LSR(GetOP<Bus, adr>(operand)));
 }
 
-void CPU::opNOP(word_t /*opIndex*/, AddressingMode /*adr*/) {}
+void CPU::opNOP(word_t /*operand*/) {}
 
 void CPU::ORA(byte_t op)
 {
     A |= op;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(A));
-    SetFlag(CPU::ZERO_FLAG, IsZero(A));
+    SetNZ(A);
 }
 
-void CPU::opORA(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opORA(word_t operand)
 {
-    ORA(GetOP(opIndex, adr));
+    ORA(GetOP<Bus, adr>(operand));
 }
 
-void CPU::opPHA(word_t /*opIndex*/, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opPHA(word_t /*operand*/)
 {
-    StackPush(A);
+    StackPush<Bus>(A);
 }
 
-void CPU::opPHP(word_t /*opIndex*/, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opPHP(word_t /*operand*/)
 {
-    auto f = F;
+    auto f = GetF();
     f |= CPU::BREAK_FLAG;
-    StackPush(f);
+    StackPush<Bus>(f);
 }
 
-void CPU::opPLA(word_t /*opIndex*/, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opPLA(word_t /*operand*/)
 {
-    A = StackPull();
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(A));
-    SetFlag(CPU::ZERO_FLAG, IsZero(A));
+    A = StackPull<Bus>();
+    SetNZ(A);
 }
 
-void CPU::opPLP(word_t /*opIndex*/, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opPLP(word_t /*operand*/)
 {
-    F = StackPull();
+    SetF(StackPull<Bus>());
     ClearFlag(CPU::BREAK_FLAG);
     SetFlag(CPU::IGNORED_FLAG);
 }
 
 byte_t CPU::ROL(byte_t op)
 {
-    auto hadCarry = IsSetFlag(CPU::CARRY_FLAG);
-    SetFlag(CPU::CARRY_FLAG, op & 0x80);
-    op <<= 1;
-    if(hadCarry)
-    {
-        op++;
-    }
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(op));
-    SetFlag(CPU::ZERO_FLAG, IsZero(op));
-    return op;
+    const AluResult res = Alu::ShiftLeft(op, IsSetFlag(CPU::CARRY_FLAG));
+    SetFlag(CPU::CARRY_FLAG, res.carry);
+    SetNZ(res.value);
+    return res.value;
 }
 
-void CPU::opROL(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opROL(word_t operand)
 {
-    SetOP(opIndex, adr, ROL(GetOP(opIndex, adr)));
+    SetOP<Bus, adr>(operand, ROL(GetOP<Bus, adr>(operand)));
 }
 
 byte_t CPU::ROR(byte_t op)
 {
-    auto hadCarry = IsSetFlag(CPU::CARRY_FLAG);
-    SetFlag(CPU::CARRY_FLAG, op & 0x01);
-    op >>= 1;
-    if(hadCarry)
-    {
-        op += 0x80;
-    }
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(op));
-    SetFlag(CPU::ZERO_FLAG, IsZero(op));
-    return op;
+    const AluResult res = Alu::ShiftRight(op, IsSetFlag(CPU::CARRY_FLAG));
+    SetFlag(CPU::CARRY_FLAG, res.carry);
+    SetNZ(res.value);
+    return res.value;
 }
 
-void CPU::opROR(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opROR(word_t operand)
 {
-    SetOP(opIndex, adr, ROR(GetOP(opIndex, adr)));
+    SetOP<Bus, adr>(operand, ROR(GetOP<Bus, adr>(operand)));
 }
 
-void CPU::opRTI(word_t /*opIndex*/, AddressingMode /*adr*/)
+template <class Bus>
+void CPU::opRTI(word_t /*operand*/)
 {
-    if(m_callStack.size())
-    {
-        m_callStack.pop_back();
-    }
-    F = StackPull();
+    SetF(StackPull<Bus>());
     // ClearFlag(getCPU::INTERRUPT_FLAG);
-    word_t retAddress = StackPull();
-    retAddress += (StackPull() << 8);
+    word_t retAddress = StackPull<Bus>();
+    retAddress += (StackPull<Bus>() << 8);
     PC = retAddress;
+    m_callStack.Sync(S);
 }
 
 void CPU::SBC(byte_t op)
@@ -705,8 +816,7 @@ void CPU::SBC(byte_t op)
             res += 100;
         }
         A = static_cast<byte_t>(((res / 10) << 4) + (res % 10));
-        SetFlag(CPU::NEGATIVE_FLAG, IsNegative(static_cast<byte_t>(res)));
-        SetFlag(CPU::ZERO_FLAG, IsZero(static_cast<byte_t>(res)));
+        SetNZ(static_cast<byte_t>(res));
     }
     else
     {
@@ -714,79 +824,78 @@ void CPU::SBC(byte_t op)
     }
 }
 
-void CPU::opSBC(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opSBC(word_t operand)
 {
-    SBC(GetOP(opIndex, adr));
+    SBC(GetOP<Bus, adr>(operand));
 }
 
-void CPU::opSEC(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opSEC(word_t /*operand*/)
 {
     SetFlag(CPU::CARRY_FLAG);
 }
 
-void CPU::opSED(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opSED(word_t /*operand*/)
 {
     SetFlag(CPU::DECIMAL_FLAG);
 }
 
-void CPU::opSEI(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opSEI(word_t /*operand*/)
 {
     SetFlag(CPU::INTERRUPT_FLAG);
 }
 
-void CPU::opSTA(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opSTA(word_t operand)
 {
-    SetOP(opIndex, adr, A);
+    SetOP<Bus, adr>(operand, A);
 }
 
-void CPU::opSTX(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opSTX(word_t operand)
 {
-    SetOP(opIndex, adr, X);
+    SetOP<Bus, adr>(operand, X);
 }
 
-void CPU::opSTY(word_t opIndex, AddressingMode adr)
+template <class Bus, AddressingMode adr>
+void CPU::opSTY(word_t operand)
 {
-    SetOP(opIndex, adr, Y);
+    SetOP<Bus, adr>(operand, Y);
 }
 
-void CPU::opTAX(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opTAX(word_t /*operand*/)
 {
     X = A;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(X));
-    SetFlag(CPU::ZERO_FLAG, IsZero(X));
+    SetNZ(X);
 }
 
-void CPU::opTAY(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opTAY(word_t /*operand*/)
 {
     Y = A;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(Y));
-    SetFlag(CPU::ZERO_FLAG, IsZero(Y));
+    SetNZ(Y);
 }
 
-void CPU::opTSX(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opTSX(word_t /*operand*/)
 {
     X = S;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(X));
-    SetFlag(CPU::ZERO_FLAG, IsZero(X));
+    SetNZ(X);
 }
 
-void CPU::opTXA(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opTXA(word_t /*operand*/)
 {
     A = X;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(A));
-    SetFlag(CPU::ZERO_FLAG, IsZero(A));
+    SetNZ(A);
 }
 
-void CPU::opTXS(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opTXS(word_t /*operand*/)
 {
     S = X;
 }
 
-void CPU::opTYA(word_t /*opIndex*/, AddressingMode /*adr*/)
+void CPU::opTYA(word_t /*operand*/)
 {
     A = Y;
-    SetFlag(CPU::NEGATIVE_FLAG, IsNegative(A));
-    SetFlag(CPU::ZERO_FLAG, IsZero(A));
+    SetNZ(A);
 }
 
 bool CPU::IsNegative(byte_t op)
@@ -799,206 +908,223 @@ bool CPU::IsZero(byte_t op)
     return op == 0;
 }
 
-void CPU::InitializeOPCodes()
+template <class Bus>
+constexpr array<CPU::OPCode, 256> CPU::InitializeOPCodes()
 {
+    array<OPCode, 256> opCodes {};
+
     // ADC
-    m_opCodeMap[0x69] = make_tuple(&atre::CPU::opADC, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0x65] = make_tuple(&atre::CPU::opADC, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x75] = make_tuple(&atre::CPU::opADC, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0x6D] = make_tuple(&atre::CPU::opADC, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0x7D] = make_tuple(&atre::CPU::opADC, AddressingMode::AbsoluteXPaged, 3, 4);
-    m_opCodeMap[0x79] = make_tuple(&atre::CPU::opADC, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0x61] = make_tuple(&atre::CPU::opADC, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0x71] = make_tuple(&atre::CPU::opADC, AddressingMode::IndirectIndexedPaged, 2, 5);
+    opCodes[0x69] = {&atre::CPU::opADC<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0x65] = {&atre::CPU::opADC<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x75] = {&atre::CPU::opADC<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0x6D] = {&atre::CPU::opADC<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0x7D] = {&atre::CPU::opADC<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
+    opCodes[0x79] = {&atre::CPU::opADC<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0x61] = {&atre::CPU::opADC<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0x71] = {&atre::CPU::opADC<Bus, AddressingMode::IndirectIndexedPaged>, AddressingMode::IndirectIndexedPaged, 2, 5};
 
     // AND
-    m_opCodeMap[0x29] = make_tuple(&atre::CPU::opAND, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0x25] = make_tuple(&atre::CPU::opAND, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x35] = make_tuple(&atre::CPU::opAND, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0x2D] = make_tuple(&atre::CPU::opAND, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0x3D] = make_tuple(&atre::CPU::opAND, AddressingMode::AbsoluteXPaged, 3, 4);
-    m_opCodeMap[0x39] = make_tuple(&atre::CPU::opAND, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0x21] = make_tuple(&atre::CPU::opAND, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0x31] = make_tuple(&atre::CPU::opAND, AddressingMode::IndirectIndexedPaged, 2, 5);
+    opCodes[0x29] = {&atre::CPU::opAND<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0x25] = {&atre::CPU::opAND<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x35] = {&atre::CPU::opAND<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0x2D] = {&atre::CPU::opAND<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0x3D] = {&atre::CPU::opAND<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
+    opCodes[0x39] = {&atre::CPU::opAND<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0x21] = {&atre::CPU::opAND<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0x31] = {&atre::CPU::opAND<Bus, AddressingMode::IndirectIndexedPaged>, AddressingMode::IndirectIndexedPaged, 2, 5};
 
     // ASL
-    m_opCodeMap[0x0A] = make_tuple(&atre::CPU::opASL, AddressingMode::Accumulator, 1, 2);
-    m_opCodeMap[0x06] = make_tuple(&atre::CPU::opASL, AddressingMode::ZeroPage, 2, 5);
-    m_opCodeMap[0x16] = make_tuple(&atre::CPU::opASL, AddressingMode::ZeroPageX, 2, 6);
-    m_opCodeMap[0x0E] = make_tuple(&atre::CPU::opASL, AddressingMode::Absolute, 3, 6);
-    m_opCodeMap[0x1E] = make_tuple(&atre::CPU::opASL, AddressingMode::AbsoluteX, 3, 7);
+    opCodes[0x0A] = {&atre::CPU::opASL<Bus, AddressingMode::Accumulator>, AddressingMode::Accumulator, 1, 2};
+    opCodes[0x06] = {&atre::CPU::opASL<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 5};
+    opCodes[0x16] = {&atre::CPU::opASL<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 6};
+    opCodes[0x0E] = {&atre::CPU::opASL<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 6};
+    opCodes[0x1E] = {&atre::CPU::opASL<Bus, AddressingMode::AbsoluteX>, AddressingMode::AbsoluteX, 3, 7};
 
     // branching
-    m_opCodeMap[0x90] = make_tuple(&atre::CPU::opBCC, AddressingMode::Relative, 2, 2);
-    m_opCodeMap[0xB0] = make_tuple(&atre::CPU::opBCS, AddressingMode::Relative, 2, 2);
-    m_opCodeMap[0xF0] = make_tuple(&atre::CPU::opBEQ, AddressingMode::Relative, 2, 2);
-    m_opCodeMap[0x30] = make_tuple(&atre::CPU::opBMI, AddressingMode::Relative, 2, 2);
-    m_opCodeMap[0xD0] = make_tuple(&atre::CPU::opBNE, AddressingMode::Relative, 2, 2);
-    m_opCodeMap[0x10] = make_tuple(&atre::CPU::opBPL, AddressingMode::Relative, 2, 2);
-    m_opCodeMap[0x50] = make_tuple(&atre::CPU::opBVC, AddressingMode::Relative, 2, 2);
-    m_opCodeMap[0x70] = make_tuple(&atre::CPU::opBVS, AddressingMode::Relative, 2, 2);
+    opCodes[0x90] = {&atre::CPU::opBCC, AddressingMode::Relative, 2, 2};
+    opCodes[0xB0] = {&atre::CPU::opBCS, AddressingMode::Relative, 2, 2};
+    opCodes[0xF0] = {&atre::CPU::opBEQ, AddressingMode::Relative, 2, 2};
+    opCodes[0x30] = {&atre::CPU::opBMI, AddressingMode::Relative, 2, 2};
+    opCodes[0xD0] = {&atre::CPU::opBNE, AddressingMode::Relative, 2, 2};
+    opCodes[0x10] = {&atre::CPU::opBPL, AddressingMode::Relative, 2, 2};
+    opCodes[0x50] = {&atre::CPU::opBVC, AddressingMode::Relative, 2, 2};
+    opCodes[0x70] = {&atre::CPU::opBVS, AddressingMode::Relative, 2, 2};
 
     // BIT
-    m_opCodeMap[0x24] = make_tuple(&atre::CPU::opBIT, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x2C] = make_tuple(&atre::CPU::opBIT, AddressingMode::Absolute, 3, 4);
+    opCodes[0x24] = {&atre::CPU::opBIT<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x2C] = {&atre::CPU::opBIT<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
 
     // BRK
-    m_opCodeMap[0x00] = make_tuple(&atre::CPU::opBRK, AddressingMode::None, 1, 7);
+    opCodes[0x00] = {&atre::CPU::opBRK<Bus>, AddressingMode::None, 1, 7};
 
     // clear flags
-    m_opCodeMap[0x18] = make_tuple(&atre::CPU::opCLC, AddressingMode::None, 1, 2);
-    m_opCodeMap[0xD8] = make_tuple(&atre::CPU::opCLD, AddressingMode::None, 1, 2);
-    m_opCodeMap[0x58] = make_tuple(&atre::CPU::opCLI, AddressingMode::None, 1, 2);
-    m_opCodeMap[0xB8] = make_tuple(&atre::CPU::opCLV, AddressingMode::None, 1, 2);
+    opCodes[0x18] = {&atre::CPU::opCLC, AddressingMode::None, 1, 2};
+    opCodes[0xD8] = {&atre::CPU::opCLD, AddressingMode::None, 1, 2};
+    opCodes[0x58] = {&atre::CPU::opCLI, AddressingMode::None, 1, 2};
+    opCodes[0xB8] = {&atre::CPU::opCLV, AddressingMode::None, 1, 2};
 
     // comparisons
-    m_opCodeMap[0xC9] = make_tuple(&atre::CPU::opCMP, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0xC5] = make_tuple(&atre::CPU::opCMP, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0xD5] = make_tuple(&atre::CPU::opCMP, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0xCD] = make_tuple(&atre::CPU::opCMP, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0xDD] = make_tuple(&atre::CPU::opCMP, AddressingMode::AbsoluteXPaged, 3, 4);
-    m_opCodeMap[0xD9] = make_tuple(&atre::CPU::opCMP, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0xC1] = make_tuple(&atre::CPU::opCMP, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0xD1] = make_tuple(&atre::CPU::opCMP, AddressingMode::IndirectIndexedPaged, 2, 5);
-    m_opCodeMap[0xE0] = make_tuple(&atre::CPU::opCPX, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0xE4] = make_tuple(&atre::CPU::opCPX, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0xEC] = make_tuple(&atre::CPU::opCPX, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0xC0] = make_tuple(&atre::CPU::opCPY, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0xC4] = make_tuple(&atre::CPU::opCPY, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0xCC] = make_tuple(&atre::CPU::opCPY, AddressingMode::Absolute, 3, 4);
+    opCodes[0xC9] = {&atre::CPU::opCMP<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0xC5] = {&atre::CPU::opCMP<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0xD5] = {&atre::CPU::opCMP<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0xCD] = {&atre::CPU::opCMP<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0xDD] = {&atre::CPU::opCMP<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
+    opCodes[0xD9] = {&atre::CPU::opCMP<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0xC1] = {&atre::CPU::opCMP<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0xD1] = {&atre::CPU::opCMP<Bus, AddressingMode::IndirectIndexedPaged>, AddressingMode::IndirectIndexedPaged, 2, 5};
+    opCodes[0xE0] = {&atre::CPU::opCPX<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0xE4] = {&atre::CPU::opCPX<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0xEC] = {&atre::CPU::opCPX<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0xC0] = {&atre::CPU::opCPY<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0xC4] = {&atre::CPU::opCPY<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0xCC] = {&atre::CPU::opCPY<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
 
     // increment/decrement
-    m_opCodeMap[0xE6] = make_tuple(&atre::CPU::opINC, AddressingMode::ZeroPage, 2, 5);
-    m_opCodeMap[0xF6] = make_tuple(&atre::CPU::opINC, AddressingMode::ZeroPageX, 2, 6);
-    m_opCodeMap[0xEE] = make_tuple(&atre::CPU::opINC, AddressingMode::Absolute, 3, 6);
-    m_opCodeMap[0xFE] = make_tuple(&atre::CPU::opINC, AddressingMode::AbsoluteX, 3, 7);
-    m_opCodeMap[0xE8] = make_tuple(&atre::CPU::opINX, AddressingMode::None, 1, 2);
-    m_opCodeMap[0xC8] = make_tuple(&atre::CPU::opINY, AddressingMode::None, 1, 2);
-    m_opCodeMap[0xC6] = make_tuple(&atre::CPU::opDEC, AddressingMode::ZeroPage, 2, 5);
-    m_opCodeMap[0xD6] = make_tuple(&atre::CPU::opDEC, AddressingMode::ZeroPageX, 2, 6);
-    m_opCodeMap[0xCE] = make_tuple(&atre::CPU::opDEC, AddressingMode::Absolute, 3, 6);
-    m_opCodeMap[0xDE] = make_tuple(&atre::CPU::opDEC, AddressingMode::AbsoluteX, 3, 7);
-    m_opCodeMap[0xCA] = make_tuple(&atre::CPU::opDEX, AddressingMode::None, 1, 2);
-    m_opCodeMap[0x88] = make_tuple(&atre::CPU::opDEY, AddressingMode::None, 1, 2);
+    opCodes[0xE6] = {&atre::CPU::opINC<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 5};
+    opCodes[0xF6] = {&atre::CPU::opINC<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 6};
+    opCodes[0xEE] = {&atre::CPU::opINC<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 6};
+    opCodes[0xFE] = {&atre::CPU::opINC<Bus, AddressingMode::AbsoluteX>, AddressingMode::AbsoluteX, 3, 7};
+    opCodes[0xE8] = {&atre::CPU::opINX, AddressingMode::None, 1, 2};
+    opCodes[0xC8] = {&atre::CPU::opINY, AddressingMode::None, 1, 2};
+    opCodes[0xC6] = {&atre::CPU::opDEC<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 5};
+    opCodes[0xD6] = {&atre::CPU::opDEC<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 6};
+    opCodes[0xCE] = {&atre::CPU::opDEC<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 6};
+    opCodes[0xDE] = {&atre::CPU::opDEC<Bus, AddressingMode::AbsoluteX>, AddressingMode::AbsoluteX, 3, 7};
+    opCodes[0xCA] = {&atre::CPU::opDEX, AddressingMode::None, 1, 2};
+    opCodes[0x88] = {&atre::CPU::opDEY, AddressingMode::None, 1, 2};
 
     // EOR
-    m_opCodeMap[0x49] = make_tuple(&atre::CPU::opEOR, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0x45] = make_tuple(&atre::CPU::opEOR, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x55] = make_tuple(&atre::CPU::opEOR, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0x4D] = make_tuple(&atre::CPU::opEOR, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0x5D] = make_tuple(&atre::CPU::opEOR, AddressingMode::AbsoluteXPaged, 3, 4);
-    m_opCodeMap[0x59] = make_tuple(&atre::CPU::opEOR, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0x41] = make_tuple(&atre::CPU::opEOR, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0x51] = make_tuple(&atre::CPU::opEOR, AddressingMode::IndirectIndexedPaged, 2, 5);
+    opCodes[0x49] = {&atre::CPU::opEOR<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0x45] = {&atre::CPU::opEOR<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x55] = {&atre::CPU::opEOR<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0x4D] = {&atre::CPU::opEOR<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0x5D] = {&atre::CPU::opEOR<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
+    opCodes[0x59] = {&atre::CPU::opEOR<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0x41] = {&atre::CPU::opEOR<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0x51] = {&atre::CPU::opEOR<Bus, AddressingMode::IndirectIndexedPaged>, AddressingMode::IndirectIndexedPaged, 2, 5};
 
     // JMP
-    m_opCodeMap[0x4C] = make_tuple(&atre::CPU::opJMP, AddressingMode::Absolute, 3, 3);
-    m_opCodeMap[0x6C] = make_tuple(&atre::CPU::opJMP, AddressingMode::Indirect, 3, 5);
+    opCodes[0x4C] = {&atre::CPU::opJMP<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 3};
+    opCodes[0x6C] = {&atre::CPU::opJMP<Bus, AddressingMode::Indirect>, AddressingMode::Indirect, 3, 5};
 
     // subroutine
-    m_opCodeMap[0x20] = make_tuple(&atre::CPU::opJSR, AddressingMode::Absolute, 3, 6);
-    m_opCodeMap[0x60] = make_tuple(&atre::CPU::opRTS, AddressingMode::Absolute, 1, 6);
+    opCodes[0x20] = {&atre::CPU::opJSR<Bus>, AddressingMode::Absolute, 3, 6};
+    opCodes[0x60] = {&atre::CPU::opRTS<Bus>, AddressingMode::None, 1, 6};
 
     // load
-    m_opCodeMap[0xA9] = make_tuple(&atre::CPU::opLDA, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0xA5] = make_tuple(&atre::CPU::opLDA, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0xB5] = make_tuple(&atre::CPU::opLDA, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0xAD] = make_tuple(&atre::CPU::opLDA, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0xBD] = make_tuple(&atre::CPU::opLDA, AddressingMode::AbsoluteXPaged, 3, 4);
-    m_opCodeMap[0xB9] = make_tuple(&atre::CPU::opLDA, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0xA1] = make_tuple(&atre::CPU::opLDA, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0xB1] = make_tuple(&atre::CPU::opLDA, AddressingMode::IndirectIndexedPaged, 2, 5);
-    m_opCodeMap[0xA2] = make_tuple(&atre::CPU::opLDX, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0xA6] = make_tuple(&atre::CPU::opLDX, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0xB6] = make_tuple(&atre::CPU::opLDX, AddressingMode::ZeroPageY, 2, 4);
-    m_opCodeMap[0xAE] = make_tuple(&atre::CPU::opLDX, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0xBE] = make_tuple(&atre::CPU::opLDX, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0xA0] = make_tuple(&atre::CPU::opLDY, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0xA4] = make_tuple(&atre::CPU::opLDY, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0xB4] = make_tuple(&atre::CPU::opLDY, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0xAC] = make_tuple(&atre::CPU::opLDY, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0xBC] = make_tuple(&atre::CPU::opLDY, AddressingMode::AbsoluteXPaged, 3, 4);
+    opCodes[0xA9] = {&atre::CPU::opLDA<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0xA5] = {&atre::CPU::opLDA<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0xB5] = {&atre::CPU::opLDA<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0xAD] = {&atre::CPU::opLDA<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0xBD] = {&atre::CPU::opLDA<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
+    opCodes[0xB9] = {&atre::CPU::opLDA<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0xA1] = {&atre::CPU::opLDA<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0xB1] = {&atre::CPU::opLDA<Bus, AddressingMode::IndirectIndexedPaged>, AddressingMode::IndirectIndexedPaged, 2, 5};
+    opCodes[0xA2] = {&atre::CPU::opLDX<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0xA6] = {&atre::CPU::opLDX<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0xB6] = {&atre::CPU::opLDX<Bus, AddressingMode::ZeroPageY>, AddressingMode::ZeroPageY, 2, 4};
+    opCodes[0xAE] = {&atre::CPU::opLDX<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0xBE] = {&atre::CPU::opLDX<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0xA0] = {&atre::CPU::opLDY<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0xA4] = {&atre::CPU::opLDY<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0xB4] = {&atre::CPU::opLDY<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0xAC] = {&atre::CPU::opLDY<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0xBC] = {&atre::CPU::opLDY<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
 
     // LSR
-    m_opCodeMap[0x4A] = make_tuple(&atre::CPU::opLSR, AddressingMode::Accumulator, 1, 2);
-    m_opCodeMap[0x46] = make_tuple(&atre::CPU::opLSR, AddressingMode::ZeroPage, 2, 5);
-    m_opCodeMap[0x56] = make_tuple(&atre::CPU::opLSR, AddressingMode::ZeroPageX, 2, 6);
-    m_opCodeMap[0x4E] = make_tuple(&atre::CPU::opLSR, AddressingMode::Absolute, 3, 6);
-    m_opCodeMap[0x5E] = make_tuple(&atre::CPU::opLSR, AddressingMode::AbsoluteX, 3, 7);
+    opCodes[0x4A] = {&atre::CPU::opLSR<Bus, AddressingMode::Accumulator>, AddressingMode::Accumulator, 1, 2};
+    opCodes[0x46] = {&atre::CPU::opLSR<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 5};
+    opCodes[0x56] = {&atre::CPU::opLSR<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 6};
+    opCodes[0x4E] = {&atre::CPU::opLSR<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 6};
+    opCodes[0x5E] = {&atre::CPU::opLSR<Bus, AddressingMode::AbsoluteX>, AddressingMode::AbsoluteX, 3, 7};
 
     // NOP
-    m_opCodeMap[0xEA] = make_tuple(&atre::CPU::opNOP, AddressingMode::None, 1, 2);
+    opCodes[0xEA] = {&atre::CPU::opNOP, AddressingMode::None, 1, 2};
 
     // ORA
-    m_opCodeMap[0x09] = make_tuple(&atre::CPU::opORA, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0x05] = make_tuple(&atre::CPU::opORA, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x15] = make_tuple(&atre::CPU::opORA, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0x0D] = make_tuple(&atre::CPU::opORA, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0x1D] = make_tuple(&atre::CPU::opORA, AddressingMode::AbsoluteXPaged, 3, 4);
-    m_opCodeMap[0x19] = make_tuple(&atre::CPU::opORA, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0x01] = make_tuple(&atre::CPU::opORA, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0x11] = make_tuple(&atre::CPU::opORA, AddressingMode::IndirectIndexedPaged, 2, 5);
+    opCodes[0x09] = {&atre::CPU::opORA<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0x05] = {&atre::CPU::opORA<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x15] = {&atre::CPU::opORA<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0x0D] = {&atre::CPU::opORA<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0x1D] = {&atre::CPU::opORA<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
+    opCodes[0x19] = {&atre::CPU::opORA<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0x01] = {&atre::CPU::opORA<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0x11] = {&atre::CPU::opORA<Bus, AddressingMode::IndirectIndexedPaged>, AddressingMode::IndirectIndexedPaged, 2, 5};
 
     // push/pull
-    m_opCodeMap[0x48] = make_tuple(&atre::CPU::opPHA, AddressingMode::IndirectIndexed, 1, 3);
-    m_opCodeMap[0x08] = make_tuple(&atre::CPU::opPHP, AddressingMode::IndirectIndexed, 1, 3);
-    m_opCodeMap[0x68] = make_tuple(&atre::CPU::opPLA, AddressingMode::IndirectIndexed, 1, 4);
-    m_opCodeMap[0x28] = make_tuple(&atre::CPU::opPLP, AddressingMode::IndirectIndexed, 1, 4);
+    opCodes[0x48] = {&atre::CPU::opPHA<Bus>, AddressingMode::None, 1, 3};
+    opCodes[0x08] = {&atre::CPU::opPHP<Bus>, AddressingMode::None, 1, 3};
+    opCodes[0x68] = {&atre::CPU::opPLA<Bus>, AddressingMode::None, 1, 4};
+    opCodes[0x28] = {&atre::CPU::opPLP<Bus>, AddressingMode::None, 1, 4};
 
     // ROL
-    m_opCodeMap[0x2A] = make_tuple(&atre::CPU::opROL, AddressingMode::Accumulator, 1, 2);
-    m_opCodeMap[0x26] = make_tuple(&atre::CPU::opROL, AddressingMode::ZeroPage, 2, 5);
-    m_opCodeMap[0x36] = make_tuple(&atre::CPU::opROL, AddressingMode::ZeroPageX, 2, 6);
-    m_opCodeMap[0x2E] = make_tuple(&atre::CPU::opROL, AddressingMode::Absolute, 3, 6);
-    m_opCodeMap[0x3E] = make_tuple(&atre::CPU::opROL, AddressingMode::AbsoluteX, 3, 7);
+    opCodes[0x2A] = {&atre::CPU::opROL<Bus, AddressingMode::Accumulator>, AddressingMode::Accumulator, 1, 2};
+    opCodes[0x26] = {&atre::CPU::opROL<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 5};
+    opCodes[0x36] = {&atre::CPU::opROL<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 6};
+    opCodes[0x2E] = {&atre::CPU::opROL<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 6};
+    opCodes[0x3E] = {&atre::CPU::opROL<Bus, AddressingMode::AbsoluteX>, AddressingMode::AbsoluteX, 3, 7};
 
     // ROR
-    m_opCodeMap[0x6A] = make_tuple(&atre::CPU::opROR, AddressingMode::Accumulator, 1, 2);
-    m_opCodeMap[0x66] = make_tuple(&atre::CPU::opROR, AddressingMode::ZeroPage, 2, 5);
-    m_opCodeMap[0x76] = make_tuple(&atre::CPU::opROR, AddressingMode::ZeroPageX, 2, 6);
-    m_opCodeMap[0x6E] = make_tuple(&atre::CPU::opROR, AddressingMode::Absolute, 3, 6);
-    m_opCodeMap[0x7E] = make_tuple(&atre::CPU::opROR, AddressingMode::AbsoluteX, 3, 7);
+    opCodes[0x6A] = {&atre::CPU::opROR<Bus, AddressingMode::Accumulator>, AddressingMode::Accumulator, 1, 2};
+    opCodes[0x66] = {&atre::CPU::opROR<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 5};
+    opCodes[0x76] = {&atre::CPU::opROR<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 6};
+    opCodes[0x6E] = {&atre::CPU::opROR<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 6};
+    opCodes[0x7E] = {&atre::CPU::opROR<Bus, AddressingMode::AbsoluteX>, AddressingMode::AbsoluteX, 3, 7};
 
     // RTI
-    m_opCodeMap[0x40] = make_tuple(&atre::CPU::opRTI, AddressingMode::None, 1, 6);
+    opCodes[0x40] = {&atre::CPU::opRTI<Bus>, AddressingMode::None, 1, 6};
 
     // SBC
-    m_opCodeMap[0xE9] = make_tuple(&atre::CPU::opSBC, AddressingMode::Immediate, 2, 2);
-    m_opCodeMap[0xE5] = make_tuple(&atre::CPU::opSBC, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0xF5] = make_tuple(&atre::CPU::opSBC, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0xED] = make_tuple(&atre::CPU::opSBC, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0xFD] = make_tuple(&atre::CPU::opSBC, AddressingMode::AbsoluteXPaged, 3, 4);
-    m_opCodeMap[0xF9] = make_tuple(&atre::CPU::opSBC, AddressingMode::AbsoluteYPaged, 3, 4);
-    m_opCodeMap[0xE1] = make_tuple(&atre::CPU::opSBC, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0xF1] = make_tuple(&atre::CPU::opSBC, AddressingMode::IndirectIndexedPaged, 2, 5);
+    opCodes[0xE9] = {&atre::CPU::opSBC<Bus, AddressingMode::Immediate>, AddressingMode::Immediate, 2, 2};
+    opCodes[0xE5] = {&atre::CPU::opSBC<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0xF5] = {&atre::CPU::opSBC<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0xED] = {&atre::CPU::opSBC<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0xFD] = {&atre::CPU::opSBC<Bus, AddressingMode::AbsoluteXPaged>, AddressingMode::AbsoluteXPaged, 3, 4};
+    opCodes[0xF9] = {&atre::CPU::opSBC<Bus, AddressingMode::AbsoluteYPaged>, AddressingMode::AbsoluteYPaged, 3, 4};
+    opCodes[0xE1] = {&atre::CPU::opSBC<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0xF1] = {&atre::CPU::opSBC<Bus, AddressingMode::IndirectIndexedPaged>, AddressingMode::IndirectIndexedPaged, 2, 5};
 
     // set flags
-    m_opCodeMap[0x38] = make_tuple(&atre::CPU::opSEC, AddressingMode::None, 1, 2);
-    m_opCodeMap[0xF8] = make_tuple(&atre::CPU::opSED, AddressingMode::None, 1, 2);
-    m_opCodeMap[0x78] = make_tuple(&atre::CPU::opSEI, AddressingMode::None, 1, 2);
+    opCodes[0x38] = {&atre::CPU::opSEC, AddressingMode::None, 1, 2};
+    opCodes[0xF8] = {&atre::CPU::opSED, AddressingMode::None, 1, 2};
+    opCodes[0x78] = {&atre::CPU::opSEI, AddressingMode::None, 1, 2};
 
     // store
-    m_opCodeMap[0x85] = make_tuple(&atre::CPU::opSTA, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x95] = make_tuple(&atre::CPU::opSTA, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0x8D] = make_tuple(&atre::CPU::opSTA, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0x9D] = make_tuple(&atre::CPU::opSTA, AddressingMode::AbsoluteX, 3, 5);
-    m_opCodeMap[0x99] = make_tuple(&atre::CPU::opSTA, AddressingMode::AbsoluteY, 3, 5);
-    m_opCodeMap[0x81] = make_tuple(&atre::CPU::opSTA, AddressingMode::IndexedIndirect, 2, 6);
-    m_opCodeMap[0x91] = make_tuple(&atre::CPU::opSTA, AddressingMode::IndirectIndexed, 2, 6);
-    m_opCodeMap[0x86] = make_tuple(&atre::CPU::opSTX, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x96] = make_tuple(&atre::CPU::opSTX, AddressingMode::ZeroPageY, 2, 4);
-    m_opCodeMap[0x8E] = make_tuple(&atre::CPU::opSTX, AddressingMode::Absolute, 3, 4);
-    m_opCodeMap[0x84] = make_tuple(&atre::CPU::opSTY, AddressingMode::ZeroPage, 2, 3);
-    m_opCodeMap[0x94] = make_tuple(&atre::CPU::opSTY, AddressingMode::ZeroPageX, 2, 4);
-    m_opCodeMap[0x8C] = make_tuple(&atre::CPU::opSTY, AddressingMode::Absolute, 3, 4);
+    opCodes[0x85] = {&atre::CPU::opSTA<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x95] = {&atre::CPU::opSTA<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0x8D] = {&atre::CPU::opSTA<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0x9D] = {&atre::CPU::opSTA<Bus, AddressingMode::AbsoluteX>, AddressingMode::AbsoluteX, 3, 5};
+    opCodes[0x99] = {&atre::CPU::opSTA<Bus, AddressingMode::AbsoluteY>, AddressingMode::AbsoluteY, 3, 5};
+    opCodes[0x81] = {&atre::CPU::opSTA<Bus, AddressingMode::IndexedIndirect>, AddressingMode::IndexedIndirect, 2, 6};
+    opCodes[0x91] = {&atre::CPU::opSTA<Bus, AddressingMode::IndirectIndexed>, AddressingMode::IndirectIndexed, 2, 6};
+    opCodes[0x86] = {&atre::CPU::opSTX<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x96] = {&atre::CPU::opSTX<Bus, AddressingMode::ZeroPageY>, AddressingMode::ZeroPageY, 2, 4};
+    opCodes[0x8E] = {&atre::CPU::opSTX<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
+    opCodes[0x84] = {&atre::CPU::opSTY<Bus, AddressingMode::ZeroPage>, AddressingMode::ZeroPage, 2, 3};
+    opCodes[0x94] = {&atre::CPU::opSTY<Bus, AddressingMode::ZeroPageX>, AddressingMode::ZeroPageX, 2, 4};
+    opCodes[0x8C] = {&atre::CPU::opSTY<Bus, AddressingMode::Absolute>, AddressingMode::Absolute, 3, 4};
 
     // transfer
-    m_opCodeMap[0xAA] = make_tuple(&atre::CPU::opTAX, AddressingMode::None, 1, 2);
-    m_opCodeMap[0xA8] = make_tuple(&atre::CPU::opTAY, AddressingMode::None, 1, 2);
-    m_opCodeMap[0xBA] = make_tuple(&atre::CPU::opTSX, AddressingMode::None, 1, 2);
-    m_opCodeMap[0x8A] = make_tuple(&atre::CPU::opTXA, AddressingMode::None, 1, 2);
-    m_opCodeMap[0x9A] = make_tuple(&atre::CPU::opTXS, AddressingMode::None, 1, 2);
-    m_opCodeMap[0x98] = make_tuple(&atre::CPU::opTYA, AddressingMode::None, 1, 2);
+    opCodes[0xAA] = {&atre::CPU::opTAX, AddressingMode::None, 1, 2};
+    opCodes[0xA8] = {&atre::CPU::opTAY, AddressingMode::None, 1, 2};
+    opCodes[0xBA] = {&atre::CPU::opTSX, AddressingMode::None, 1, 2};
+    opCodes[0x8A] = {&atre::CPU::opTXA, AddressingMode::None, 1, 2};
+    opCodes[0x9A] = {&atre::CPU::opTXS, AddressingMode::None, 1, 2};
+    opCodes[0x98] = {&atre::CPU::opTYA, AddressingMode::None, 1, 2};
+
+    return opCodes;
+}
+
+template <class Bus>
+constexpr array<CPU::OPCode, 256> CPU::s_opCodes = CPU::InitializeOPCodes<Bus>();
+
+// lengths, addressing modes and timings are the same on every bus
+constexpr array<CPU::OPCode, 256> CPU::s_opCodeMap = CPU::s_opCodes<AtariBus>;
+
+StopReason CPU::RunCycles(unsigned long cycles)
+{
+    const uint64_t end = TotalCycles() + cycles;
+    return RunUntil(StopReason::Budget, [this, end]() { return TotalCycles() >= end; });
 }
 
 void CPU::JumpTo(word_t startAddr)
@@ -1006,73 +1132,628 @@ void CPU::JumpTo(word_t startAddr)
     PC = startAddr;
 }
 
+// moves the break address, breakpoints added otherwise stay
 void CPU::BreakAt(word_t breakAddr)
 {
+    m_breakpoints.Remove(Access::Execute, BRK, BRK);
     BRK = breakAddr;
+    m_breakpoints.Add(Access::Execute, BRK, BRK);
 }
 
-void CPU::Execute()
+// one instantiation per opcode, with all addressing mode, length
+// and timing decisions made at compile time
+template <class Bus, byte_t code>
+void CPU::Step()
 {
-    if(m_waitCycles)
+    constexpr OPCode opCode = s_opCodeMap[code];
+    word_t           operand = 0;
+    if constexpr(opCode.bytes == 2)
     {
-        Cycles(1);
-        m_waitCycles--;
-        return;
+        operand = Bus::Get(m_RAM, static_cast<word_t>(PC + 1));
     }
-    if(m_nmiPending)
+    else if constexpr(opCode.bytes == 3)
     {
-        if(m_showSteps)
+        operand = Bus::GetW(m_RAM, static_cast<word_t>(PC + 1));
+    }
+    Run<Bus, code>(operand);
+}
+
+template <class Bus, byte_t code>
+void CPU::Run(word_t operand)
+{
+    constexpr OPCode opCode = s_opCodes<Bus>[code];
+    if constexpr(opCode.bytes == 0)
+    {
+        throw runtime_error("Unsupported OPcode");
+    }
+    else
+    {
+        const word_t   instrAddress = PC;
+        const uint64_t start        = Bus::DEBUG ? TotalCycles() : 0;
+        if constexpr(Bus::DEBUG)
         {
-            cout << "NMI" << endl;
+            m_traceAddr = 0;
+            if(m_profiler)
+            {
+                m_profiler->Sample(instrAddress, code, start, m_callStack);
+            }
+            if(m_coverage)
+            {
+                m_coverage->Hit(m_RAM->PageBank(instrAddress), instrAddress, opCode.bytes);
+            }
         }
-        doNMI();
-        m_nmiPending = false;
-        return;
+
+        // PC already points to next instruction
+        PC += static_cast<word_t>(opCode.bytes);
+        (this->*opCode.func)(operand);
+
+        if constexpr(Bus::DEBUG)
+        {
+            CheckCallbacks(instrAddress);
+            if(m_trace)
+            {
+                // taken branches and page crossings already charged their extra cycles
+                m_trace->Record({start, instrAddress, m_traceAddr, code, A, X, Y, S, GetF()});
+            }
+        }
+        Cycles(opCode.cycles);
+    }
+}
+
+// returns true when a break, watchpoint or trap was reported
+bool CPU::CheckCallbacks(word_t instrAddress)
+{
+    if(!m_callbacks)
+    {
+        m_watchHit = false;
+        return false;
+    }
+
+    bool stopped = false;
+    if(m_showSteps)
+    {
+        m_callbacks->DumpState();
+    }
+    if(m_watchHit)
+    {
+        m_watchHit = false;
+        m_callbacks->OnWatch(m_watchAddr, m_watchAccess);
+        m_stopReason = StopReason::Watch;
+        stopped      = true;
+    }
+    if(m_breakpoints.IsSet(Access::Execute, PC) && IsBreakHit(PC))
+    {
+        m_callbacks->OnBreak();
+        m_stopReason = StopReason::Break;
+        stopped      = true;
+    }
+    if(PC == instrAddress && m_enableTraps)
+    {
+        // jump to self: trap
+        m_callbacks->OnTrap();
+        m_stopReason = StopReason::Trap;
+        stopped      = true;
+    }
+    return stopped;
+}
+
+// counts the hit and evaluates the condition of a conditional breakpoint
+bool CPU::IsBreakHit(word_t addr)
+{
+    auto* conditional = m_breakpoints.FindConditional(addr);
+    if(!conditional)
+    {
+        return true;
+    }
+    return conditional->condition.Evaluate(*this, ++conditional->hits);
+}
+
+// effective address of the instruction without touching any registers
+template <class Bus, AddressingMode adr>
+bool CPU::AccessesIO(word_t operand)
+{
+    word_t addr;
+    if constexpr(adr == AddressingMode::Absolute)
+    {
+        addr = operand;
+    }
+    else if constexpr(adr == AddressingMode::AbsoluteX || adr == AddressingMode::AbsoluteXPaged)
+    {
+        addr = static_cast<word_t>(operand + X);
+    }
+    else if constexpr(adr == AddressingMode::AbsoluteY || adr == AddressingMode::AbsoluteYPaged)
+    {
+        addr = static_cast<word_t>(operand + Y);
+    }
+    else if constexpr(adr == AddressingMode::IndexedIndirect)
+    {
+        word_t baseAddr = (operand + X) & 0xFF;
+        addr            = static_cast<word_t>(Bus::Get(m_RAM, baseAddr) + (Bus::Get(m_RAM, (baseAddr + 1) & 0xFF) << 8));
+    }
+    else if constexpr(adr == AddressingMode::IndirectIndexed || adr == AddressingMode::IndirectIndexedPaged)
+    {
+        addr = static_cast<word_t>(Bus::Get(m_RAM, operand) + (Bus::Get(m_RAM, (operand + 1) & 0xFF) << 8) + Y);
+    }
+    else if constexpr(adr == AddressingMode::Indirect)
+    {
+        return m_RAM->PageBank(operand) == MemoryBank::IO || m_RAM->PageBank(static_cast<word_t>(operand + 1)) == MemoryBank::IO;
+    }
+    else
+    {
+        // registers, zero page and stack
+        return false;
+    }
+    return m_RAM->PageBank(addr) == MemoryBank::IO;
+}
+
+// step dumps, traces and profiles need every instruction interpreted
+bool CPU::MustStep() const
+{
+    return m_showSteps || m_trace || m_profiler;
+}
+
+// coverage of code the interpreter doesn't step through one instruction at a time
+void CPU::Cover(const Block& block)
+{
+    for(const auto& op : block.ops)
+    {
+        m_coverage->Hit(m_RAM->PageBank(op.pc), op.pc, op.bytes);
+    }
+}
+
+// interrupts, WSYNC and self-modifying code end a native block early
+bool CPU::MustLeaveNative() const
+{
+    const unsigned ready = m_interrupts.Ready();
+    return (ready & InterruptController::NMI_READY) || ((ready & InterruptController::IRQ_READY) && !IsSetFlag(CPU::INTERRUPT_FLAG)) ||
+           m_waitCycles || m_RAM->PageTag(static_cast<word_t>(m_blockPage << 8)) != m_blockTag;
+}
+
+// like Run<code> but with cycles left to the block exit
+template <class Bus, byte_t code>
+unsigned CPU::JitStep(CPU* cpu, word_t operand)
+{
+    constexpr OPCode opCode = s_opCodes<Bus>[code];
+    if constexpr(opCode.bytes == 0)
+    {
+        return JIT_BAIL;
     }
-    if(m_irqPending && !CPU::IsSetFlag(CPU::INTERRUPT_FLAG))
+    else
     {
-        if(m_showSteps)
+        // JSR and JMP don't access their operand address
+        if constexpr(code != 0x20 && code != 0x4C)
         {
-            cout << "IRQ" << endl;
+            if(cpu->AccessesIO<Bus, opCode.adr>(operand))
+            {
+                return JIT_BAIL;
+            }
+        }
+
+        const word_t instrAddress = cpu->PC;
+        if(cpu->m_coverage)
+        {
+            // AOT code has no block to cover when it is entered
+            cpu->m_coverage->Hit(cpu->m_RAM->PageBank(instrAddress), instrAddress, opCode.bytes);
+        }
+        cpu->PC += static_cast<word_t>(opCode.bytes);
+        (cpu->*opCode.func)(operand);
+
+        if(cpu->CheckCallbacks(instrAddress) || cpu->MustLeaveNative())
+        {
+            return JIT_STOP;
+        }
+        return JIT_CONTINUE;
+    }
+}
+
+#define ATRE_JIT_THUNK(c) &CPU::JitStep<Bus, c>,
+
+template <class Bus>
+const array<CPU::JitThunk, 256> CPU::s_jitThunks = {ATRE_OPCODES(ATRE_JIT_THUNK)};
+
+#undef ATRE_JIT_THUNK
+
+// fetches and decodes straight from memory
+template <class Bus>
+void CPU::StepUncached()
+{
+#define ATRE_STEP(c)    \
+    case c:             \
+        Step<Bus, c>(); \
+        break;
+
+    const byte_t code = Bus::Get(m_RAM, PC);
+    if constexpr(!Bus::DEBUG)
+    {
+        if(m_coverage)
+        {
+            m_coverage->Hit(m_RAM->PageBank(PC), PC, s_opCodeMap[code].bytes);
         }
-        m_irqPending = false;
-        doIRQ();
-        return;
     }
-    const byte_t code   = m_RAM->Get(PC);
-    const auto&  opCode = m_opCodeMap[code];
-    if(get<2>(opCode) > 0)
+    switch(code)
     {
-        const auto adr     = get<1>(opCode);
-        const auto func    = get<0>(opCode);
-        const auto opIndex = static_cast<word_t>(PC + 1);
+        ATRE_OPCODES(ATRE_STEP)
+    }
 
-        // PC already points to next instruction
-        PC += static_cast<word_t>(get<2>(opCode));
-        (this->*func)(opIndex, adr);
+#undef ATRE_STEP
+}
+
+void CPU::Execute()
+{
+    // anything the callbacks could be told about needs the checking variant
+    const bool debug = MustStep() || (m_callbacks && (m_breakpoints.IsArmed() || m_enableTraps));
+    if(m_busType == BusType::Flat)
+    {
+        debug ? Execute<DebugBus<FlatBus>>() : Execute<FlatBus>();
+    }
+    else
+    {
+        debug ? Execute<DebugBus<AtariBus>>() : Execute<AtariBus>();
+    }
+}
 
-        if(m_callbacks)
+template <class Bus>
+void CPU::Execute()
+{
+    if(m_waitCycles)
+    {
+        // the chips run through the whole wait, interrupts are taken after it
+        const unsigned cycles = m_waitCycles;
+        m_waitCycles          = 0;
+        Cycles(cycles);
+        return;
+    }
+    // one check covers every source while none is pending
+    if(const unsigned ready = m_interrupts.Ready())
+    {
+        if(ready & InterruptController::NMI_READY)
         {
             if(m_showSteps)
             {
-                m_callbacks->DumpState();
+                cout << "NMI" << endl;
             }
-            if(PC == BRK)
+            doNMI<Bus>();
+            m_interrupts.AcknowledgeNMI();
+            return;
+        }
+        if(!CPU::IsSetFlag(CPU::INTERRUPT_FLAG))
+        {
+            if(m_showSteps)
             {
-                m_callbacks->OnBreak();
+                cout << "IRQ" << endl;
             }
-            if(PC == opIndex - 1 && m_enableTraps)
+            m_interrupts.AcknowledgeIRQ();
+            doIRQ<Bus>();
+            return;
+        }
+    }
+
+    // continue the current block unless we left it or its page was modified
+    if(m_nextOp == m_blockEnd || m_nextOp->pc != PC || m_RAM->PageTag(m_blockPage << 8) != m_blockTag)
+    {
+        if(m_enableMathPack && RunMathPack())
+        {
+            return;
+        }
+        if(m_aotBlocks && RunAot())
+        {
+            return;
+        }
+        Block* block = m_blockCache->Fetch(PC);
+        if(!block)
+        {
+            m_nextOp = m_blockEnd = nullptr;
+            StepUncached<Bus>();
+            return;
+        }
+        if(block->idiom != Idiom::None && RunIdiom(*block))
+        {
+            return;
+        }
+        if(m_enableJIT && RunNative(*block))
+        {
+            return;
+        }
+        if constexpr(!Bus::DEBUG)
+        {
+            // the debug variant covers each instruction it runs
+            if(m_coverage)
             {
-                // jump to self: trap
-                m_callbacks->OnTrap();
+                Cover(*block);
             }
         }
-        Cycles(get<3>(opCode));
+        m_nextOp    = block->ops.data();
+        m_blockEnd  = m_nextOp + block->ops.size();
+        m_blockPage = block->start >> 8;
+        m_blockTag  = block->tag;
     }
-    else
+
+#define ATRE_RUN(c)              \
+    case c:                      \
+        Run<Bus, c>(op.operand); \
+        break;
+
+    const MicroOp& op = *m_nextOp++;
+    switch(op.code)
     {
-        throw runtime_error("Unsupported OPcode");
+        ATRE_OPCODES(ATRE_RUN)
+    }
+
+#undef ATRE_RUN
+}
+
+// runs the whole block as native code once it got hot,
+// returns false to have the interpreter step through it instead
+bool CPU::RunNative(Block& block)
+{
+    if(MustStep())
+    {
+        return false;
+    }
+    if(!m_jit->IsCompiled(block))
+    {
+        if(++block.runs < Jit::COMPILE_THRESHOLD || !m_jit->Compile(block))
+        {
+            return false;
+        }
+    }
+    if(m_callbacks)
+    {
+        // compiled code only reports breaks on the instructions it calls out for
+        const MicroOp& last   = block.ops.back();
+        const unsigned next   = last.pc + last.bytes;
+        unsigned       target = next;
+        if(last.adr == AddressingMode::Relative)
+        {
+            target = static_cast<word_t>(next + static_cast<sbyte_t>(last.operand));
+        }
+        else if(last.code == 0x4C) // JMP
+        {
+            target = last.operand;
+        }
+        if(m_breakpoints.IsWatching() || m_breakpoints.Any(Access::Execute, block.start + 1, next) ||
+           m_breakpoints.IsSet(Access::Execute, static_cast<word_t>(target)))
+        {
+            return false;
+        }
+    }
+
+    if(m_coverage)
+    {
+        Cover(block);
+    }
+    return EnterNative(block.native);
+}
+
+// runs a recognized fill or copy loop straight on memory; iterations still
+// charge cycles per instruction so interrupts, WSYNC and the IO chips see
+// the same timing as in the interpreter, and an interrupt leaves PC at the
+// next instruction. Returns false when the loop touches anything but plain
+// RAM or would overwrite its own code or pointers
+bool CPU::RunIdiom(const Block& block)
+{
+    if(block.idiom == Idiom::Poll)
+    {
+        return SkipPoll(block);
+    }
+
+    const auto&    ops    = block.ops;
+    const MicroOp* load   = block.idiom == Idiom::Copy ? &ops[0] : nullptr;
+    const MicroOp& store  = ops[ops.size() - 3];
+    const MicroOp& step   = ops[ops.size() - 2];
+    const MicroOp& branch = ops[ops.size() - 1];
+    const auto     next   = static_cast<word_t>(branch.pc + branch.bytes);
+    if(MustStep() ||
+       (m_callbacks && (m_breakpoints.IsWatching() || m_breakpoints.Any(Access::Execute, block.start, next))))
+    {
+        return false;
+    }
+
+    const bool   countX = step.code == 0xE8 || step.code == 0xCA; // INX, DEX
+    byte_t&      index  = countX ? X : Y;
+    const bool   up     = step.code == 0xE8 || step.code == 0xC8; // INX, INY
+    const auto   delta  = static_cast<byte_t>(up ? 1 : -1);
+    const byte_t first  = up ? index : (index ? 1 : 0);
+    // counting up ends at 0, counting down stops before 0
+    const unsigned count = up ? 256 - index : (index ? index : 256);
+
+    auto isIndirect = [](const MicroOp& op) {
+        return op.adr == AddressingMode::IndirectIndexed || op.adr == AddressingMode::IndirectIndexedPaged;
+    };
+    auto baseOf = [this, &isIndirect](const MicroOp& op) {
+        if(isIndirect(op))
+        {
+            return static_cast<word_t>(m_RAM->Get(op.operand) + (m_RAM->Get((op.operand + 1) & 0xFF) << 8));
+        }
+        return op.operand;
+    };
+
+    const word_t storeBase  = baseOf(store);
+    const auto   storeFirst = static_cast<word_t>(storeBase + first);
+    auto         storesTo   = [storeFirst, count](word_t addr, unsigned size) {
+        return static_cast<word_t>(addr - storeFirst) < count || static_cast<word_t>(storeFirst - addr) < size;
+    };
+    if(!m_RAM->IsPlainRAM(storeFirst, count) || storesTo(block.start & 0xFF00, 256))
+    {
+        return false;
+    }
+    for(const auto& op : ops)
+    {
+        if(isIndirect(op) && (storesTo(op.operand, 1) || storesTo((op.operand + 1) & 0xFF, 1)))
+        {
+            return false;
+        }
+    }
+    const word_t loadBase = load ? baseOf(*load) : 0;
+    if(load && !m_RAM->IsPlainRAM(static_cast<word_t>(loadBase + first), count))
+    {
+        return false;
+    }
+
+    if(m_coverage)
+    {
+        Cover(block);
+    }
+    m_nextOp = m_blockEnd = nullptr;
+    m_blockPage           = block.start >> 8;
+    m_blockTag            = block.tag;
+
+    const unsigned taken = branch.cycles + (next >> 8 != block.start >> 8 ? 2 : 1);
+    for(unsigned i = 0; i < count; i++)
+    {
+        if(load)
+        {
+            const auto addr = static_cast<word_t>(loadBase + index);
+            if(loadBase >> 8 != addr >> 8) // all indexed LDA modes are paged
+            {
+                Cycles(1);
+            }
+            A = m_RAM->DirectGet(addr);
+            SetNZ(A);
+            Cycles(load->cycles);
+            if(MustLeaveNative())
+            {
+                PC = store.pc;
+                return true;
+            }
+        }
+
+        m_RAM->DirectSet(static_cast<word_t>(storeBase + index), A);
+        Cycles(store.cycles);
+        if(MustLeaveNative())
+        {
+            PC = step.pc;
+            return true;
+        }
+
+        index = static_cast<byte_t>(index + delta);
+        SetNZ(index);
+        Cycles(step.cycles);
+        if(MustLeaveNative())
+        {
+            PC = branch.pc;
+            return true;
+        }
+
+        PC = index ? block.start : next;
+        Cycles(index ? taken : branch.cycles);
+        if(MustLeaveNative())
+        {
+            return true;
+        }
+    }
+    return true;
+}
+
+// a poll loop that ran a whole round since it was last entered, with no
+// interrupt and no chip event in between, ends each further round in the
+// same state until an event is due or a chip register it reads changes. Those
+// rounds are charged at once, which lets the chips jump ahead to their next
+// event; returns false to have the next round run as usual
+bool CPU::SkipPoll(const Block& block)
+{
+    const MicroOp& branch = block.ops.back();
+    const auto     next   = static_cast<word_t>(branch.pc + branch.bytes);
+    if(!m_IO || MustStep() || (m_callbacks && (m_breakpoints.IsWatching() || m_breakpoints.Any(Access::Execute, block.start, next))))
+    {
+        return false;
+    }
+
+    unsigned round = branch.cycles + (next >> 8 != block.start >> 8 ? 2 : 1);
+    for(auto op = block.ops.begin(); op != block.ops.end() - 1; op++)
+    {
+        round += op->cycles;
+    }
+
+    // a whole round takes exactly this long, interrupts or leaving the loop take longer
+    const uint64_t now       = m_scheduler.Now();
+    const bool     confirmed = m_pollStart == block.start && TotalCycles() - m_pollCycles == round && m_scheduler.LastEvent() < m_pollTime;
+    uint64_t       quiet     = m_scheduler.NextDeadline();
+    for(auto op = block.ops.begin(); confirmed && op != block.ops.end() - 1; op++)
+    {
+        if(op->adr != AddressingMode::Immediate && m_RAM->PageBank(op->operand) == MemoryBank::IO)
+        {
+            quiet = min(quiet, m_IO->StableUntil(op->operand, m_pollTime));
+        }
+    }
+    m_pollStart  = block.start;
+    m_pollCycles = TotalCycles();
+    m_pollTime   = now;
+    if(!confirmed || quiet <= now)
+    {
+        return false;
+    }
+
+    // whole rounds the chips finish before quiet, they tick once every multiplier cycles
+    const uint64_t cycles = min<uint64_t>(quiet - now, MAX_SKIP_CYCLES) * m_clockMultiplier - m_clockPhase - 1;
+    const uint64_t rounds = min<uint64_t>(cycles, MAX_SKIP_CYCLES) / round;
+    if(!rounds)
+    {
+        return false;
+    }
+    Cycles(rounds * round);
+    m_pollCycles = TotalCycles();
+    m_pollTime   = m_scheduler.Now();
+    return true;
+}
+
+// calls into the OS floating point package return straight away with the
+// result computed natively and the routine's typical cycle count
+bool CPU::RunMathPack()
+{
+    if(PC < MathPack::ROM_START || PC >= MathPack::ROM_END || MustStep() || m_RAM->PageBank(PC) != MemoryBank::OS ||
+       (m_callbacks && (m_breakpoints.IsWatching() || m_breakpoints.Any(Access::Execute, MathPack::ROM_START, MathPack::ROM_END - 1))))
+    {
+        return false;
+    }
+
+    const word_t   entry  = PC;
+    bool           error  = false;
+    const unsigned cycles = m_mathPack->Call(entry, error);
+    if(!cycles)
+    {
+        return false;
+    }
+    if(m_coverage)
+    {
+        // the routine itself doesn't run, only the instruction it was called at is covered
+        m_coverage->Hit(MemoryBank::OS, entry, s_opCodeMap[m_RAM->Get(entry)].bytes);
+    }
+    SetFlag(CPU::CARRY_FLAG, error);
+    opRTS<AtariBus>(0);
+    m_nextOp = m_blockEnd = nullptr;
+
+    CheckCallbacks(entry);
+    Cycles(cycles);
+    return true;
+}
+
+// cartridge code translated by the "aot" command
+bool CPU::RunAot()
+{
+    if(PC < CARTRIDGE_START || PC >= CARTRIDGE_START + CARTRIDGE_SIZE || MustStep() || m_RAM->PageBank(PC) != MemoryBank::Cartridge ||
+       (m_callbacks && m_breakpoints.IsWatching()))
+    {
+        return false;
+    }
+    const NativeBlock native = m_aotBlocks[PC - CARTRIDGE_START];
+    return native && EnterNative(native);
+}
+
+bool CPU::EnterNative(NativeBlock native)
+{
+    m_nextOp = m_blockEnd = nullptr;
+    m_blockPage           = PC >> 8;
+    m_blockTag            = m_RAM->PageTag(PC);
+
+    const unsigned cycles = native(this);
+    if(!cycles)
+    {
+        // bailed out on the first instruction
+        return false;
     }
+    Cycles(cycles);
+    return true;
 }
 
 } // namespace atre
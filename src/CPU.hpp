@@ -1,13 +1,41 @@
 #pragma once
 
+#include "Breakpoints.hpp"
+#include "Bus.hpp"
+#include "CallStack.hpp"
 #include "Debugger.hpp"
+#include "Interrupts.hpp"
 #include "RAM.hpp"
+#include "Scheduler.hpp"
 #include "atre.hpp"
 
 namespace atre
 {
 class Tests;
 class IO;
+class CPU;
+class BlockCache;
+class Jit;
+class MathPack;
+class Coverage;
+class Profiler;
+class Trace;
+struct Block;
+struct MicroOp;
+
+// entry point of natively compiled code, returns the cycles it took
+typedef unsigned (*NativeBlock)(CPU* cpu);
+
+// why a batch run returned
+enum class StopReason
+{
+    None,
+    Budget, // ran the requested number of cycles
+    Frame,  // reached the requested scanline
+    Break,
+    Watch,
+    Trap
+};
 
 enum class AddressingMode
 {
@@ -32,9 +60,14 @@ enum class AddressingMode
 class CPU
 {
 public:
-    CPU(RAM* ram);
+    // the flat bus only suits memory without IO, banking or feedback registers
+    CPU(RAM* ram, BusType busType = BusType::Atari);
+    ~CPU();
 
     void Attach(Callbacks* callbacks);
+    void AttachTrace(Trace* trace);
+    void AttachProfiler(Profiler* profiler);
+    void AttachCoverage(Coverage* coverage);
     void Connect(IO* io);
     void Reset();
     void IRQ();
@@ -43,40 +76,118 @@ public:
     void BreakAt(word_t startAddr);
     void Execute();
     void Wait(unsigned cycles);
+    void SetClockMultiplier(unsigned multiplier);
+
+    // executes at least the given number of cycles; breaks, watchpoints and traps reported
+    // to the attached callbacks end the run after their instruction
+    StopReason RunCycles(unsigned long cycles);
+
+    // executes until done() holds, checked after every instruction
+    template <typename Done>
+    StopReason RunUntil(StopReason reason, Done done)
+    {
+        m_stopReason = StopReason::None;
+        while(!done())
+        {
+            Execute();
+            if(m_stopReason != StopReason::None)
+            {
+                return m_stopReason;
+            }
+        }
+        return reason;
+    }
 
     inline unsigned long Cycles() const
     {
         return m_cycles;
     }
 
-    bool                                        m_showCycles;
-    bool                                        m_enableTraps;
-    bool                                        m_showSteps;
-    std::vector<std::pair<word_t, std::string>> m_callStack;
+    inline uint64_t TotalCycles() const
+    {
+        return static_cast<uint64_t>(m_seconds) * CYCLES_PER_SEC + m_cycles;
+    }
+
+    // what "unlimited" maps to, the chips only advance with CPU cycles
+    const static unsigned MAX_CLOCK_MULTIPLIER = 64;
+
+    bool                m_showCycles;
+    bool                m_enableTraps;
+    bool                m_showSteps;
+    bool                m_enableJIT;
+    bool                m_enableMathPack;
+    CallStack           m_callStack;
+    Breakpoints         m_breakpoints;
+    InterruptController m_interrupts;
+    Scheduler           m_scheduler;
 
 private:
     friend class Debugger;
     friend class Tests;
+    friend class BlockCache;
+    friend class Jit;
+    friend class Aot;
+    friend class Condition;
+    friend class Coverage;
+    friend class Lanes;
+    friend class Snapshot;
+
+    typedef void (atre::CPU::*OPFunction)(word_t);
+    typedef unsigned (*JitThunk)(CPU* cpu, word_t operand);
+
+    struct OPCode
+    {
+        OPFunction     func;
+        AddressingMode adr;
+        int            bytes;
+        int            cycles;
+    };
+
+    // shared by all instances, built at compile time, one table per bus
+    template <class Bus>
+    static const std::array<OPCode, 256> s_opCodes;
+    static const std::array<OPCode, 256> s_opCodeMap;
+    // per-opcode entry points called from JIT generated code
+    template <class Bus>
+    static const std::array<JitThunk, 256> s_jitThunks;
 
-    typedef void (atre::CPU::*OPFunction)(word_t, AddressingMode);
-    typedef std::tuple<OPFunction, AddressingMode, int /*bytes*/, int /*cycles*/> OPCode;
-
-    OPCode        m_opCodeMap[256];
-    byte_t        A;
-    byte_t        X;
-    byte_t        Y;
-    byte_t        S;
-    word_t        PC;
-    byte_t        F;
-    word_t        BRK;
-    unsigned long m_cycles;
-    unsigned long m_seconds;
-    bool          m_irqPending;
-    bool          m_nmiPending;
-    unsigned      m_waitCycles;
-    RAM*          m_RAM;
-    Callbacks*    m_callbacks;
-    IO*           m_IO;
+    byte_t                      A;
+    byte_t                      X;
+    byte_t                      Y;
+    byte_t                      S;
+    word_t                      PC;
+    byte_t                      F;
+    byte_t                      m_nResult; // N is bit 7 of the last result
+    byte_t                      m_zResult; // Z is set while the last result is 0
+    word_t                      BRK;
+    unsigned long               m_cycles;
+    unsigned long               m_seconds;
+    unsigned                    m_clockMultiplier;
+    unsigned                    m_clockPhase; // CPU cycles since the last chip tick
+    unsigned                    m_waitCycles;
+    StopReason                  m_stopReason;
+    bool                        m_watchHit;
+    word_t                      m_watchAddr;
+    Access                      m_watchAccess;
+    word_t                      m_traceAddr; // last data address of the instruction
+    RAM*                        m_RAM;
+    BusType                     m_busType;
+    Callbacks*                  m_callbacks;
+    Trace*                      m_trace;
+    Profiler*                   m_profiler;
+    Coverage*                   m_coverage;
+    IO*                         m_IO;
+    std::unique_ptr<BlockCache> m_blockCache;
+    const MicroOp*              m_nextOp;
+    const MicroOp*              m_blockEnd;
+    word_t                      m_blockPage;
+    uint32_t                    m_blockTag;
+    word_t                      m_pollStart;  // the poll loop entered last
+    uint64_t                    m_pollCycles; // TotalCycles() on entering it
+    uint64_t                    m_pollTime;   // the master clock on entering it
+    std::unique_ptr<Jit>        m_jit;
+    const NativeBlock*          m_aotBlocks;
+    std::unique_ptr<MathPack>   m_mathPack;
 
     const static flag_t NEGATIVE_FLAG  = 0b10000000;
     const static flag_t OVERFLOW_FLAG  = 0b01000000;
@@ -87,88 +198,166 @@ private:
     const static flag_t ZERO_FLAG      = 0b00000010;
     const static flag_t CARRY_FLAG     = 0b00000001;
 
+    const static unsigned JIT_CONTINUE = 0;
+    const static unsigned JIT_STOP     = 1; // executed, leave the block
+    const static unsigned JIT_BAIL     = 2; // not executed, interpret it
+
+    // CPU cycles skipped at once, keeps the seconds count to one step per skip
+    const static unsigned MAX_SKIP_CYCLES = CYCLES_PER_FRAME;
+
     static bool IsNegative(byte_t op);
     static bool IsZero(byte_t op);
 
-    void   InitializeOPCodes();
+    template <class Bus>
+    static constexpr std::array<OPCode, 256> InitializeOPCodes();
+
     void   SetFlag(flag_t flag);
     void   SetFlag(flag_t flag, bool isSet);
     void   ClearFlag(flag_t flag);
     bool   IsSetFlag(flag_t flag) const;
+    byte_t GetF() const;
+    void   SetF(byte_t f);
+    void   SetNZ(byte_t result);
+    template <class Bus>
     void   doIRQ();
+    template <class Bus>
     void   doNMI();
     void   Cycles(unsigned long cycles);
+    template <class Bus>
+    byte_t Read(word_t addr);
+    template <class Bus>
+    word_t ReadW(word_t addr);
+    template <class Bus>
+    void   Write(word_t addr, byte_t val);
+    void   CheckWatch(Access access, word_t addr);
+    template <class Bus>
     void   StackPush(byte_t val);
+    template <class Bus>
     byte_t StackPull();
-    byte_t GetOP(word_t opIndex, AddressingMode adr);
-    void   SetOP(word_t opIndex, AddressingMode adr, byte_t val);
+    template <class Bus>
+    void   Execute();
+    template <class Bus, byte_t code>
+    void   Step();
+    template <class Bus, byte_t code>
+    void   Run(word_t operand);
+    template <class Bus>
+    void   StepUncached();
+    bool   CheckCallbacks(word_t instrAddress);
+    bool   IsBreakHit(word_t addr);
+    bool   RunNative(Block& block);
+    bool   RunIdiom(const Block& block);
+    bool   SkipPoll(const Block& block);
+    bool   RunAot();
+    bool   RunMathPack();
+    bool   EnterNative(NativeBlock native);
+    void   Cover(const Block& block);
+    bool   MustStep() const;
+    bool   MustLeaveNative() const;
+    template <class Bus, byte_t code>
+    static unsigned JitStep(CPU* cpu, word_t operand);
+    template <class Bus, AddressingMode adr>
+    bool   AccessesIO(word_t operand);
+    template <class Bus, AddressingMode adr>
+    byte_t GetOP(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   SetOP(word_t operand, byte_t val);
 
     void   ADC(byte_t op);
-    void   opADC(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opADC(word_t operand);
     void   AND(byte_t op);
-    void   opAND(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opAND(word_t operand);
     byte_t ASL(byte_t op);
-    void   opASL(word_t opIndex, AddressingMode adr);
-    void   Branch(word_t opIndex, bool condition);
-    void   opBCC(word_t opIndex, AddressingMode adr);
-    void   opBCS(word_t opIndex, AddressingMode adr);
-    void   opBEQ(word_t opIndex, AddressingMode adr);
-    void   opBMI(word_t opIndex, AddressingMode adr);
-    void   opBNE(word_t opIndex, AddressingMode adr);
-    void   opBPL(word_t opIndex, AddressingMode adr);
-    void   opBVC(word_t opIndex, AddressingMode adr);
-    void   opBVS(word_t opIndex, AddressingMode adr);
-    void   opBIT(word_t opIndex, AddressingMode adr);
-    void   opBRK(word_t opIndex, AddressingMode adr);
-    void   opCLC(word_t opIndex, AddressingMode adr);
-    void   opCLD(word_t opIndex, AddressingMode adr);
-    void   opCLI(word_t opIndex, AddressingMode adr);
-    void   opCLV(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opASL(word_t operand);
+    void   Branch(word_t operand, bool condition);
+    void   opBCC(word_t operand);
+    void   opBCS(word_t operand);
+    void   opBEQ(word_t operand);
+    void   opBMI(word_t operand);
+    void   opBNE(word_t operand);
+    void   opBPL(word_t operand);
+    void   opBVC(word_t operand);
+    void   opBVS(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opBIT(word_t operand);
+    template <class Bus>
+    void   opBRK(word_t operand);
+    void   opCLC(word_t operand);
+    void   opCLD(word_t operand);
+    void   opCLI(word_t operand);
+    void   opCLV(word_t operand);
     void   Compare(byte_t r, byte_t op);
-    void   opCMP(word_t opIndex, AddressingMode adr);
-    void   opCPX(word_t opIndex, AddressingMode adr);
-    void   opCPY(word_t opIndex, AddressingMode adr);
-    void   opDEC(word_t opIndex, AddressingMode adr);
-    void   opDEX(word_t opIndex, AddressingMode adr);
-    void   opDEY(word_t opIndex, AddressingMode adr);
-    void   opINC(word_t opIndex, AddressingMode adr);
-    void   opINX(word_t opIndex, AddressingMode adr);
-    void   opINY(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opCMP(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opCPX(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opCPY(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opDEC(word_t operand);
+    void   opDEX(word_t operand);
+    void   opDEY(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opINC(word_t operand);
+    void   opINX(word_t operand);
+    void   opINY(word_t operand);
     void   EOR(byte_t op);
-    void   opEOR(word_t opIndex, AddressingMode adr);
-    void   opJMP(word_t opIndex, AddressingMode adr);
-    void   opJSR(word_t opIndex, AddressingMode adr);
-    void   opRTS(word_t opIndex, AddressingMode adr);
-    void   opLDA(word_t opIndex, AddressingMode adr);
-    void   opLDX(word_t opIndex, AddressingMode adr);
-    void   opLDY(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opEOR(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opJMP(word_t operand);
+    template <class Bus>
+    void   opJSR(word_t operand);
+    template <class Bus>
+    void   opRTS(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opLDA(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opLDX(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opLDY(word_t operand);
     byte_t LSR(byte_t op);
-    void   opLSR(word_t opIndex, AddressingMode adr);
-    void   opNOP(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opLSR(word_t operand);
+    void   opNOP(word_t operand);
     void   ORA(byte_t op);
-    void   opORA(word_t opIndex, AddressingMode adr);
-    void   opPHA(word_t opIndex, AddressingMode adr);
-    void   opPHP(word_t opIndex, AddressingMode adr);
-    void   opPLA(word_t opIndex, AddressingMode adr);
-    void   opPLP(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opORA(word_t operand);
+    template <class Bus>
+    void   opPHA(word_t operand);
+    template <class Bus>
+    void   opPHP(word_t operand);
+    template <class Bus>
+    void   opPLA(word_t operand);
+    template <class Bus>
+    void   opPLP(word_t operand);
     byte_t ROL(byte_t op);
-    void   opROL(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opROL(word_t operand);
     byte_t ROR(byte_t op);
-    void   opROR(word_t opIndex, AddressingMode adr);
-    void   opRTI(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opROR(word_t operand);
+    template <class Bus>
+    void   opRTI(word_t operand);
     void   SBC(byte_t op);
-    void   opSBC(word_t opIndex, AddressingMode adr);
-    void   opSEC(word_t opIndex, AddressingMode adr);
-    void   opSED(word_t opIndex, AddressingMode adr);
-    void   opSEI(word_t opIndex, AddressingMode adr);
-    void   opSTA(word_t opIndex, AddressingMode adr);
-    void   opSTX(word_t opIndex, AddressingMode adr);
-    void   opSTY(word_t opIndex, AddressingMode adr);
-    void   opTAX(word_t opIndex, AddressingMode adr);
-    void   opTAY(word_t opIndex, AddressingMode adr);
-    void   opTSX(word_t opIndex, AddressingMode adr);
-    void   opTXA(word_t opIndex, AddressingMode adr);
-    void   opTXS(word_t opIndex, AddressingMode adr);
-    void   opTYA(word_t opIndex, AddressingMode adr);
+    template <class Bus, AddressingMode adr>
+    void   opSBC(word_t operand);
+    void   opSEC(word_t operand);
+    void   opSED(word_t operand);
+    void   opSEI(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opSTA(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opSTX(word_t operand);
+    template <class Bus, AddressingMode adr>
+    void   opSTY(word_t operand);
+    void   opTAX(word_t operand);
+    void   opTAY(word_t operand);
+    void   opTSX(word_t operand);
+    void   opTXA(word_t operand);
+    void   opTXS(word_t operand);
+    void   opTYA(word_t operand);
 };
 } // namespace atre
@@ -0,0 +1,33 @@
+#include "CallStack.hpp"
+
+using namespace std;
+
+namespace atre
+{
+CallStack::CallStack() : m_frames(), m_top(), m_size(), m_changes() {}
+
+void CallStack::Clear()
+{
+    m_top  = 0;
+    m_size = 0;
+    m_changes++;
+}
+
+const char* CallStack::Name(CallKind kind)
+{
+    switch(kind)
+    {
+    case CallKind::Entry:
+        return "Entry";
+    case CallKind::JSR:
+        return "JSR";
+    case CallKind::IRQ:
+        return "IRQ";
+    case CallKind::NMI:
+        return "NMI";
+    case CallKind::BRK:
+        return "BRK";
+    }
+    return "";
+}
+} // namespace atre
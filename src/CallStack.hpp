@@ -0,0 +1,82 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+enum class CallKind : byte_t
+{
+    Entry,
+    JSR,
+    IRQ,
+    NMI,
+    BRK
+};
+
+// shadow of the calls on the 6502 stack in a fixed ring; a frame is dropped
+// once S moves above the return address it pushed, checked on every call and
+// return, so code leaving through stack manipulation instead of RTS doesn't
+// leave stale frames behind
+class CallStack
+{
+public:
+    struct Frame
+    {
+        word_t   target;
+        CallKind kind;
+        byte_t   s; // after pushing the return address
+    };
+
+    const static unsigned CAPACITY = 256;
+
+    CallStack();
+
+    void               Clear();
+    static const char* Name(CallKind kind);
+
+    inline void Push(word_t target, CallKind kind, byte_t s)
+    {
+        Sync(s);
+        m_frames[m_top++] = {target, kind, s};
+        m_changes++;
+        if(m_size < CAPACITY)
+        {
+            m_size++;
+        }
+    }
+
+    // drops the frames whose return address was pulled to reach s
+    inline void Sync(byte_t s)
+    {
+        while(m_size && m_frames[static_cast<byte_t>(m_top - 1)].s < s)
+        {
+            m_top--;
+            m_size--;
+            m_changes++;
+        }
+    }
+
+    inline unsigned Size() const
+    {
+        return m_size;
+    }
+
+    // bumped whenever a frame is pushed or dropped
+    inline unsigned Changes() const
+    {
+        return m_changes;
+    }
+
+    // 0 is the outermost frame still recorded
+    inline const Frame& Get(unsigned index) const
+    {
+        return m_frames[static_cast<byte_t>(m_top - m_size + index)];
+    }
+
+private:
+    std::array<Frame, CAPACITY> m_frames;
+    byte_t                      m_top; // wraps around with the ring
+    unsigned                    m_size;
+    unsigned                    m_changes;
+};
+} // namespace atre
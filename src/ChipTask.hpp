@@ -0,0 +1,98 @@
+#pragma once
+
+#ifdef ATRE_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace atre
+{
+// the timed work of a chip written as a coroutine: it runs its event, waits
+// for the next one and runs again. The state stays in the chip, so the
+// scheduler's deadlines are all a snapshot has to keep; a task ended by an
+// exception throws it from Resume
+class ChipTask
+{
+public:
+    struct promise_type
+    {
+        std::exception_ptr error;
+
+        ChipTask get_return_object()
+        {
+            return ChipTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception()
+        {
+            error = std::current_exception();
+        }
+    };
+
+    // suspends the task until the scheduler takes its event off the queue
+    typedef std::suspend_always NextEvent;
+
+    ChipTask() : m_handle() {}
+
+    ChipTask(ChipTask&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+
+    ChipTask& operator=(ChipTask&& other) noexcept
+    {
+        if(this != &other)
+        {
+            Destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    ~ChipTask()
+    {
+        Destroy();
+    }
+
+    // not started yet, or ended
+    inline bool IsDone() const
+    {
+        return !m_handle || m_handle.done();
+    }
+
+    // runs the task up to its next co_await
+    inline void Resume()
+    {
+        m_handle.resume();
+        if(m_handle.done() && m_handle.promise().error)
+        {
+            std::rethrow_exception(m_handle.promise().error);
+        }
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit ChipTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    inline void Destroy()
+    {
+        if(m_handle)
+        {
+            m_handle.destroy();
+        }
+    }
+};
+} // namespace atre
+
+#endif
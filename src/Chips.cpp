@@ -79,6 +79,7 @@ byte_t POKEY::Read(word_t addr)
     {
     case ChipRegisters::KBCODE:
         m_irqStatus &= ~(0b01000000);
+        UpdateIRQLines();
         return m_scanCode;
     case ChipRegisters::SKSTAT:
         return ~m_kbStat;
@@ -91,17 +92,25 @@ byte_t POKEY::Read(word_t addr)
     return m_RAM->DirectGet(addr);
 }
 
+// IRQST only changes with events and writes, the keyboard follows the host
+uint64_t POKEY::StableUntil(word_t reg, uint64_t since)
+{
+    return reg == ChipRegisters::IRQST ? Scheduler::NEVER : since;
+}
+
 void POKEY::Write(word_t addr, byte_t val)
 {
     switch(addr)
     {
-    case ChipRegisters::SEROUT:
+    case ChipRegisters::SEROUT: {
+        // the byte is shifted out after the ones still queued
+        auto&          scheduler = m_CPU->m_scheduler;
+        const uint64_t start     = scheduler.IsScheduled(ChipEvent::SerialOut) ? scheduler.Deadline(ChipEvent::SerialOut) : scheduler.Now();
+        scheduler.Schedule(ChipEvent::SerialOut, start + SERIAL_BYTE_CYCLES);
         m_sioComplete = false;
-        for(int i = 0; i < 20; i++)
-        {
-            m_serialOut.push_back(val);
-        }
+        UpdateIRQLines();
         break;
+    }
     case ChipRegisters::IRQEN:
         m_irqStatus &= val; // clear any pendng interrupts
         if(m_sioComplete)
@@ -109,6 +118,15 @@ void POKEY::Write(word_t addr, byte_t val)
             m_irqStatus |= 0b1000; // always set serial status
         }
         m_RAM->DirectSet(addr, val);
+        m_CPU->m_interrupts.SetIRQMask(IRQSource::POKEY, val);
+        UpdateIRQLines();
+        ScheduleTimers();
+        break;
+    case ChipRegisters::AUDF1:
+    case ChipRegisters::AUDF2:
+    case ChipRegisters::AUDF4:
+        m_RAM->DirectSet(addr, val);
+        ScheduleTimers();
         break;
     case ChipRegisters::STIMER:
     default:
@@ -118,8 +136,27 @@ void POKEY::Write(word_t addr, byte_t val)
 }
 
 POKEY::POKEY(CPU* cpu, RAM* ram) :
-    Chip(cpu, ram), m_serialOut(), m_irqStatus(0), m_scanCode(), m_kbStat(), m_sioComplete(), m_keyPressed(), m_breakPressed(), m_cycles()
-{}
+    Chip(cpu, ram), m_irqStatus(0), m_scanCode(), m_kbStat(), m_sioComplete(), m_keyPressed(), m_breakPressed()
+{
+    Reset();
+}
+
+// IRQEN and the timer frequencies are cleared with the RAM
+void POKEY::Reset()
+{
+    m_CPU->m_interrupts.SetIRQMask(IRQSource::POKEY, 0);
+    m_CPU->m_scheduler.Schedule(ChipEvent::Keyboard, m_CPU->m_scheduler.Now() + KEYBOARD_SCAN_CYCLES);
+    ScheduleTimers();
+}
+
+// the latched IRQST bits and the serial output complete level drive the
+// CPU's IRQ lines until IRQEN or the chip clears them, the timers still
+// only show in IRQST
+void POKEY::UpdateIRQLines()
+{
+    const unsigned latched = IRQSource::SERIAL_OUT_READY | IRQSource::KEYBOARD | IRQSource::BREAK_KEY;
+    m_CPU->m_interrupts.SetIRQLines(IRQSource::POKEY, (m_irqStatus & latched) | (m_sioComplete ? IRQSource::SERIAL_OUT_COMPLETE : 0));
+}
 
 void POKEY::KeyDown(byte_t scanCode, bool shiftStatus, bool ctrlStatus)
 {
@@ -166,33 +203,27 @@ void POKEY::ShiftKey(bool shiftStatus)
     }
 }
 
-void POKEY::Tick()
+void POKEY::SerialOutDone()
 {
-    auto irqen = m_RAM->DirectGet(ChipRegisters::IRQEN);
-    if(m_serialOut.size() > 1)
-    {
-        m_serialOut.pop_back();
-    }
-    else if(m_serialOut.size() == 1)
+    m_sioComplete = true; // serial output complete
+    if(m_RAM->DirectGet(ChipRegisters::IRQEN) & 0b10000)
     {
-        m_serialOut.clear();
-        m_sioComplete = true;
-        if(irqen & 0b10000)
-        {
-            m_irqStatus |= 0b10000;
-            m_CPU->IRQ(); // serial output ready
-        }
-    }
-    if(m_sioComplete && (irqen & 0b1000))
-    {
-        m_CPU->IRQ(); // serial output complete
+        m_irqStatus |= 0b10000; // serial output ready
     }
+    UpdateIRQLines();
+}
+
+// keys come from the IO thread and are picked up once per frame
+void POKEY::ScanKeyboard()
+{
+    auto irqen   = m_RAM->DirectGet(ChipRegisters::IRQEN);
+    bool changed = false;
     if(m_keyPressed)
     {
         if((irqen & 0b1000000))
         {
-            m_irqStatus |= 0b1000000;
-            m_CPU->IRQ(); // keypress
+            m_irqStatus |= 0b1000000; // keypress
+            changed = true;
         }
         m_keyPressed = false;
     }
@@ -200,54 +231,101 @@ void POKEY::Tick()
     {
         if((irqen & 0b10000000))
         {
-            m_irqStatus |= 0b10000000;
-            m_CPU->IRQ(); // break
+            m_irqStatus |= 0b10000000; // break
+            changed = true;
         }
         m_breakPressed = false;
     }
+    if(changed)
+    {
+        UpdateIRQLines();
+    }
+    m_CPU->m_scheduler.Schedule(ChipEvent::Keyboard, m_CPU->m_scheduler.Now() + KEYBOARD_SCAN_CYCLES);
+}
 
-    m_cycles++;
-    if(m_cycles == CYCLES_PER_SEC)
+// the 64kHz tick, counted from the start of each second
+void POKEY::UpdateTimers()
+{
+    auto irqen    = m_RAM->DirectGet(ChipRegisters::IRQEN);
+    auto numTicks = m_CPU->m_scheduler.Now() % CYCLES_PER_SEC / TIMER_CYCLES;
+    auto freq1    = m_RAM->DirectGet(ChipRegisters::AUDF1);
+    if(freq1 && (irqen & 1) && numTicks % freq1 == 0)
     {
-        m_cycles = 0;
+        m_irqStatus |= 1;
     }
-    if(m_cycles % 28 == 0)
+    else
     {
-        // 64kHz tick
-        bool trigger  = false;
-        auto numTicks = m_cycles / 28;
-        auto freq1    = m_RAM->DirectGet(ChipRegisters::AUDF1);
-        if(freq1 && (irqen & 1) && numTicks % freq1 == 0)
-        {
-            m_irqStatus |= 1;
-        }
-        else
-        {
-            m_irqStatus &= ~1;
-        }
-        auto freq2 = m_RAM->DirectGet(ChipRegisters::AUDF2);
-        if(freq2 && (irqen & 2) && numTicks % freq2 == 0)
-        {
-            m_irqStatus |= 2;
-        }
-        else
-        {
-            m_irqStatus &= ~2;
-        }
-        auto freq4 = m_RAM->DirectGet(ChipRegisters::AUDF4);
-        if(freq4 && (irqen & 4) && numTicks % freq4 == 0)
-        {
-            m_irqStatus |= 4;
-        }
-        else
-        {
-            m_irqStatus &= ~4;
-        }
-        if(trigger)
-        {
-            m_CPU->IRQ();
-        }
+        m_irqStatus &= ~1;
+    }
+    auto freq2 = m_RAM->DirectGet(ChipRegisters::AUDF2);
+    if(freq2 && (irqen & 2) && numTicks % freq2 == 0)
+    {
+        m_irqStatus |= 2;
+    }
+    else
+    {
+        m_irqStatus &= ~2;
+    }
+    auto freq4 = m_RAM->DirectGet(ChipRegisters::AUDF4);
+    if(freq4 && (irqen & 4) && numTicks % freq4 == 0)
+    {
+        m_irqStatus |= 4;
+    }
+    else
+    {
+        m_irqStatus &= ~4;
+    }
+    ScheduleTimers();
+}
+
+// the ticks in between would leave the bits as they are, until IRQEN or AUDF
+// is written and this runs again
+void POKEY::ScheduleTimers()
+{
+    const uint64_t now    = m_CPU->m_scheduler.Now();
+    const uint64_t second = now - now % CYCLES_PER_SEC;
+    const auto     tick   = static_cast<unsigned>(now % CYCLES_PER_SEC / TIMER_CYCLES + 1);
+    const auto     irqen  = m_RAM->DirectGet(ChipRegisters::IRQEN);
+    uint64_t       change = Scheduler::NEVER;
+    for(auto timer : {make_pair(1, ChipRegisters::AUDF1), make_pair(2, ChipRegisters::AUDF2), make_pair(4, ChipRegisters::AUDF4)})
+    {
+        const unsigned freq = (irqen & timer.first) ? m_RAM->DirectGet(timer.second) : 0;
+        change              = min(change, NextTimerChange(second, tick, freq, m_irqStatus & timer.first));
+    }
+    m_CPU->m_scheduler.Schedule(ChipEvent::Timers, change);
+}
+
+// the first tick from the given one on that flips a timer bit; the bit is set
+// on ticks that are a multiple of its frequency and cleared on the others,
+// or on all of them when the timer is off
+uint64_t POKEY::NextTimerChange(uint64_t second, unsigned tick, unsigned freq, bool set)
+{
+    // ticks start over with 0 every second
+    if(tick > LAST_TICK)
+    {
+        second += CYCLES_PER_SEC;
+        tick = 0;
+    }
+    if(!freq)
+    {
+        return set ? second + tick * TIMER_CYCLES : Scheduler::NEVER;
+    }
+    if(!set)
+    {
+        tick = (tick + freq - 1) / freq * freq;
+        return tick > LAST_TICK ? second + CYCLES_PER_SEC : second + tick * TIMER_CYCLES;
+    }
+    if(freq == 1)
+    {
+        return Scheduler::NEVER;
+    }
+    if(tick % freq == 0 && ++tick > LAST_TICK)
+    {
+        // tick 0 of the next second keeps the bit set
+        second += CYCLES_PER_SEC;
+        tick = 1;
     }
+    return second + tick * TIMER_CYCLES;
 }
 
 byte_t PIA::Read(word_t addr)
@@ -287,7 +365,7 @@ void PIA::Write(word_t addr, byte_t val)
     switch(addr)
     {
     case ChipRegisters::PORTB:
-        m_RAM->DirectSet(addr, val | 1);
+        m_RAM->SetPortB(val | 1);
         break;
     default:
         m_RAM->DirectSet(addr, val);
@@ -300,21 +378,44 @@ PIA::PIA(CPU* cpu, RAM* ram) : Chip(cpu, ram), m_joyUp(), m_joyDown(), m_joyLeft
 void PIA::Reset()
 {
     // enable all ROMs by default
-    m_RAM->DirectSet(ChipRegisters::PORTB, 0b00000001);
+    m_RAM->SetPortB(0b00000001);
 }
 
 GTIA::GTIA(CPU* cpu, RAM* memory, ScanBuffer* scanBuffer) :
-    Chip(cpu, memory), m_scanBuffer(scanBuffer), m_optionKey(), m_selectKey(), m_startKey(), m_joyFire(), m_collisions(), m_playerPos()
+    Chip(cpu, memory), m_scanBuffer(scanBuffer), m_synced(scanBuffer->lineStart), m_scanCycle(), m_optionKey(), m_selectKey(),
+    m_startKey(), m_joyFire(), m_collisions(), m_playerPos()
 {
     memset(m_collisions, 0, sizeof(m_collisions));
     memset(m_playerPos, 0, sizeof(m_playerPos));
 }
 
+void GTIA::Sync(uint64_t until)
+{
+    until = min(until, m_scanBuffer->lineStart + CYCLES_PER_SCANLINE - 1);
+    if(until <= m_synced)
+    {
+        return;
+    }
+    if(!(m_RAM->DirectGet(ChipRegisters::GRACTL) & 0b11) && !m_scanBuffer->players)
+    {
+        // nothing to draw and nothing to collide with, ANTIC may skip lines
+        m_synced = until;
+        return;
+    }
+    while(m_synced < until)
+    {
+        m_synced++;
+        m_scanCycle = static_cast<word_t>(m_synced - m_scanBuffer->lineStart);
+        Tick();
+    }
+}
+
 void GTIA::Tick()
 {
-    if(m_scanBuffer->scanCycle == 0)
+    if(m_scanCycle == 0)
     {
         memset(m_playerPos, 0, sizeof(m_playerPos));
+        m_scanBuffer->players = false;
     }
 
     if(m_RAM->DirectGet(ChipRegisters::GRACTL) & 0b10)
@@ -336,7 +437,7 @@ void GTIA::Tick()
         m3 = DrawMissile(ChipRegisters::HPOSM3, ChipRegisters::COLPM3, 6, ChipRegisters::M3PF);
     }
 
-    const auto distFromCenter = (m_scanBuffer->scanCycle * 2) - 0x80;
+    const auto distFromCenter = (m_scanCycle * 2) - 0x80;
     const auto framePos       = (FRAME_WIDTH / 2) + distFromCenter * 2;
 
     bool p0 = false, p1 = false, p2 = false, p3 = false;
@@ -406,7 +507,7 @@ bool GTIA::DrawMissile(word_t posRegister, word_t colorRegister, int shift, word
     const auto hPos = m_RAM->DirectGet(posRegister);
 
     bool missileDrawn = false;
-    if(m_scanBuffer->scanCycle == hPos / 2)
+    if(m_scanCycle == hPos / 2)
     {
         const auto distFromCenter = hPos - 0x80;
         const auto framePos       = (FRAME_WIDTH / 2) + distFromCenter * 2;
@@ -414,42 +515,40 @@ bool GTIA::DrawMissile(word_t posRegister, word_t colorRegister, int shift, word
         const auto bitMask        = (m_RAM->DirectGet(ChipRegisters::GRAFM) >> shift) & 0b11;
         if(bitMask & 0b10)
         {
-            missileDrawn                           = true;
-            m_scanBuffer->lineBuffer[framePos]     = color;
-            m_scanBuffer->lineBuffer[framePos + 1] = color;
-            if(m_scanBuffer->playfield[framePos])
-            {
-                m_collisions[collisionRegister & 0xF] |= (1 << (m_scanBuffer->playfield[framePos] - 1));
-            }
-            if(m_scanBuffer->playfield[framePos + 1])
-            {
-                m_collisions[collisionRegister & 0xF] |= (1 << (m_scanBuffer->playfield[framePos + 1] - 1));
-            }
+            missileDrawn = true;
+            DrawMissilePixel(framePos, color, collisionRegister);
+            DrawMissilePixel(framePos + 1, color, collisionRegister);
         }
         if(bitMask & 0b1)
         {
-            missileDrawn                           = true;
-            m_scanBuffer->lineBuffer[framePos + 2] = color;
-            m_scanBuffer->lineBuffer[framePos + 3] = color;
-            if(m_scanBuffer->playfield[framePos + 2])
-            {
-                m_collisions[collisionRegister & 0xF] |= (1 << (m_scanBuffer->playfield[framePos + 2] - 1));
-            }
-            if(m_scanBuffer->playfield[framePos + 3])
-            {
-                m_collisions[collisionRegister & 0xF] |= (1 << (m_scanBuffer->playfield[framePos + 3] - 1));
-            }
+            missileDrawn = true;
+            DrawMissilePixel(framePos + 2, color, collisionRegister);
+            DrawMissilePixel(framePos + 3, color, collisionRegister);
         }
     }
     return missileDrawn;
 }
 
+// missiles near the edges of the horizontal range are partly off the frame
+void GTIA::DrawMissilePixel(int framePos, uint32_t color, word_t collisionRegister)
+{
+    if(framePos < 0 || framePos >= FRAME_WIDTH)
+    {
+        return;
+    }
+    m_scanBuffer->lineBuffer[framePos] = color;
+    if(m_scanBuffer->playfield[framePos])
+    {
+        m_collisions[collisionRegister & 0xF] |= (1 << (m_scanBuffer->playfield[framePos] - 1));
+    }
+}
+
 bool GTIA::DrawPlayer(word_t posRegister, word_t colorRegister, word_t maskRegister, word_t sizeRegister, word_t collisionRegister, int pNo)
 {
     const auto hPos = m_RAM->DirectGet(posRegister);
 
     bool playerDrawn = false;
-    if(m_scanBuffer->scanCycle == hPos / 2)
+    if(m_scanCycle == hPos / 2)
     {
         const auto distFromCenter = hPos - 0x80;
         const auto framePos       = (FRAME_WIDTH / 2) + distFromCenter * 2;
@@ -488,6 +587,7 @@ bool GTIA::DrawPlayer(word_t posRegister, word_t colorRegister, word_t maskRegis
                         {
                             m_collisions[collisionRegister & 0xF] |= (1 << (m_scanBuffer->playfield[offset] - 1));
                             m_playerPos[offset] |= (1 << pNo);
+                            m_scanBuffer->players = true;
                         }
                     }
                 }
@@ -94,9 +94,10 @@ enum ChipRegisters
 
 struct ScanBuffer
 {
-    word_t    scanCycle;
+    uint64_t  lineStart; // master clock at cycle 0 of the line
     byte_t    playfield[FRAME_WIDTH];
     uint32_t* lineBuffer;
+    bool      players; // GTIA placed players on the line
 };
 
 class Chip
@@ -106,9 +107,16 @@ public:
 
     virtual void   Write(word_t reg, byte_t val) = 0;
     virtual byte_t Read(word_t reg)              = 0;
-    virtual void   Tick() {}
     virtual void   Reset() {}
 
+    // the master clock until which reads of reg keep returning what they returned
+    // since the given time, events aside; no later than since while reads have side
+    // effects or follow the host's input
+    virtual uint64_t StableUntil(word_t /*reg*/, uint64_t since)
+    {
+        return since;
+    }
+
     virtual ~Chip() {}
 
 protected:
@@ -121,7 +129,8 @@ class GTIA : public Chip
 public:
     GTIA(CPU* cpu, RAM* ram, ScanBuffer* scanBuffer);
 
-    void   Tick() override;
+    // draws the cycles up to until, never past the line ANTIC set up last
+    void   Sync(uint64_t until);
     void   Write(word_t reg, byte_t val) override;
     byte_t Read(word_t reg) override;
 
@@ -143,7 +152,11 @@ public:
     }
 
 private:
+    friend class Snapshot;
+
     ScanBuffer* m_scanBuffer;
+    uint64_t    m_synced; // last cycle drawn
+    word_t      m_scanCycle;
     bool        m_optionKey;
     bool        m_selectKey;
     bool        m_startKey;
@@ -151,7 +164,10 @@ private:
     byte_t      m_collisions[16];
     byte_t      m_playerPos[FRAME_WIDTH];
 
+    void Tick();
+
     bool DrawMissile(word_t posRegister, word_t colorRegister, int shift, word_t collisionRegister);
+    void DrawMissilePixel(int framePos, uint32_t color, word_t collisionRegister);
     bool DrawPlayer(word_t posRegister, word_t colorRegister, word_t maskRegister, word_t sizeRegister, word_t collisionRegister, int num);
 };
 
@@ -165,19 +181,36 @@ public:
     void Break();
     void ShiftKey(bool shiftStatus);
 
-    void   Write(word_t reg, byte_t val) override;
-    byte_t Read(word_t reg) override;
-    void   Tick() override;
+    void     Write(word_t reg, byte_t val) override;
+    byte_t   Read(word_t reg) override;
+    void     Reset() override;
+    uint64_t StableUntil(word_t reg, uint64_t since) override;
+
+    // scheduled events
+    void SerialOutDone();
+    void ScanKeyboard();
+    void UpdateTimers();
 
 private:
-    std::vector<byte_t> m_serialOut;
-    byte_t              m_irqStatus;
-    byte_t              m_scanCode;
-    byte_t              m_kbStat;
-    bool                m_sioComplete;
-    bool                m_keyPressed;
-    bool                m_breakPressed;
-    unsigned long       m_cycles;
+    friend class Snapshot;
+    friend class Tests;
+
+    const static unsigned SERIAL_BYTE_CYCLES   = 20;
+    const static unsigned TIMER_CYCLES         = 28; // 64 kHz
+    const static unsigned LAST_TICK            = (CYCLES_PER_SEC - 1) / TIMER_CYCLES;
+    const static unsigned KEYBOARD_SCAN_CYCLES = CYCLES_PER_FRAME;
+
+    byte_t m_irqStatus;
+    byte_t m_scanCode;
+    byte_t m_kbStat;
+    bool   m_sioComplete;
+    bool   m_keyPressed;
+    bool   m_breakPressed;
+
+    void UpdateIRQLines();
+    void ScheduleTimers();
+
+    static uint64_t NextTimerChange(uint64_t second, unsigned tick, unsigned freq, bool set);
 };
 
 class PIA : public Chip
@@ -207,6 +240,8 @@ public:
     byte_t Read(word_t reg) override;
 
 private:
+    friend class Snapshot;
+
     bool m_joyUp;
     bool m_joyDown;
     bool m_joyLeft;
@@ -0,0 +1,467 @@
+#include "Condition.hpp"
+#include "CPU.hpp"
+
+using namespace std;
+
+namespace atre
+{
+class Condition::Compiler
+{
+public:
+    Compiler(const string& text, vector<Instruction>& code) : m_text(text), m_pos(), m_code(code), m_depth() {}
+
+    void Compile()
+    {
+        LogicalOr();
+        SkipSpaces();
+        if(m_pos != m_text.size())
+        {
+            Fail("unexpected character");
+        }
+    }
+
+private:
+    const string&        m_text;
+    size_t               m_pos;
+    vector<Instruction>& m_code;
+    unsigned             m_depth;
+
+    [[noreturn]] void Fail(const string& message) const
+    {
+        throw runtime_error("Condition: " + message + " at column " + to_string(m_pos + 1));
+    }
+
+    // change is what the instruction does to the stack depth
+    void Emit(Op op, int change, int32_t value = 0)
+    {
+        m_code.push_back({op, value});
+        m_depth = static_cast<unsigned>(static_cast<int>(m_depth) + change);
+        if(m_depth > STACK_SIZE)
+        {
+            Fail("expression too deep");
+        }
+    }
+
+    void SkipSpaces()
+    {
+        while(m_pos < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_pos])))
+        {
+            m_pos++;
+        }
+    }
+
+    bool Peek(const char* token)
+    {
+        SkipSpaces();
+        return m_text.compare(m_pos, strlen(token), token) == 0;
+    }
+
+    bool Accept(const char* token)
+    {
+        if(Peek(token))
+        {
+            m_pos += strlen(token);
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(const char* token)
+    {
+        if(!Accept(token))
+        {
+            Fail(string("expected ") + token);
+        }
+    }
+
+    // both short-circuit, leaving 0 or 1
+    void LogicalOr()
+    {
+        LogicalAnd();
+        vector<size_t> jumps;
+        while(Accept("||"))
+        {
+            jumps.push_back(m_code.size());
+            Emit(Op::JumpIfTrue, -1);
+            LogicalAnd();
+        }
+        Resolve(jumps);
+    }
+
+    void LogicalAnd()
+    {
+        Equality();
+        vector<size_t> jumps;
+        while(Accept("&&"))
+        {
+            jumps.push_back(m_code.size());
+            Emit(Op::JumpIfFalse, -1);
+            Equality();
+        }
+        Resolve(jumps);
+    }
+
+    void Resolve(const vector<size_t>& jumps)
+    {
+        if(jumps.empty())
+        {
+            return;
+        }
+        Emit(Op::Bool, 0);
+        for(auto jump : jumps)
+        {
+            m_code[jump].value = static_cast<int32_t>(m_code.size());
+        }
+    }
+
+    void Equality()
+    {
+        Relational();
+        while(true)
+        {
+            if(Accept("=="))
+            {
+                Relational();
+                Emit(Op::Equal, -1);
+            }
+            else if(Accept("!="))
+            {
+                Relational();
+                Emit(Op::NotEqual, -1);
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    void Relational()
+    {
+        BitOr();
+        while(true)
+        {
+            Op op;
+            if(Accept("<="))
+            {
+                op = Op::LessEqual;
+            }
+            else if(Accept(">="))
+            {
+                op = Op::GreaterEqual;
+            }
+            else if(Accept("<"))
+            {
+                op = Op::Less;
+            }
+            else if(Accept(">"))
+            {
+                op = Op::Greater;
+            }
+            else
+            {
+                return;
+            }
+            BitOr();
+            Emit(op, -1);
+        }
+    }
+
+    void BitOr()
+    {
+        BitXor();
+        while(!Peek("||") && Accept("|"))
+        {
+            BitXor();
+            Emit(Op::Or, -1);
+        }
+    }
+
+    void BitXor()
+    {
+        BitAnd();
+        while(Accept("^"))
+        {
+            BitAnd();
+            Emit(Op::Xor, -1);
+        }
+    }
+
+    void BitAnd()
+    {
+        Additive();
+        while(!Peek("&&") && Accept("&"))
+        {
+            Additive();
+            Emit(Op::And, -1);
+        }
+    }
+
+    void Additive()
+    {
+        Multiplicative();
+        while(true)
+        {
+            if(Accept("+"))
+            {
+                Multiplicative();
+                Emit(Op::Add, -1);
+            }
+            else if(Accept("-"))
+            {
+                Multiplicative();
+                Emit(Op::Subtract, -1);
+            }
+            else
+            {
+                return;
+            }
+        }
+    }
+
+    void Multiplicative()
+    {
+        Unary();
+        while(true)
+        {
+            Op op;
+            if(Accept("*"))
+            {
+                op = Op::Multiply;
+            }
+            else if(Accept("/"))
+            {
+                op = Op::Divide;
+            }
+            else if(Accept("%"))
+            {
+                op = Op::Modulo;
+            }
+            else
+            {
+                return;
+            }
+            Unary();
+            Emit(op, -1);
+        }
+    }
+
+    void Unary()
+    {
+        if(!Peek("!=") && Accept("!"))
+        {
+            Unary();
+            Emit(Op::Not, 0);
+        }
+        else if(Accept("~"))
+        {
+            Unary();
+            Emit(Op::Complement, 0);
+        }
+        else if(Accept("-"))
+        {
+            Unary();
+            Emit(Op::Negate, 0);
+        }
+        else
+        {
+            Primary();
+        }
+    }
+
+    void Primary()
+    {
+        SkipSpaces();
+        if(Accept("("))
+        {
+            LogicalOr();
+            Expect(")");
+            return;
+        }
+        if(m_pos < m_text.size() && (m_text[m_pos] == '$' || isdigit(static_cast<unsigned char>(m_text[m_pos]))))
+        {
+            Emit(Op::Push, 1, Number());
+            return;
+        }
+
+        string name;
+        while(m_pos < m_text.size() && isalpha(static_cast<unsigned char>(m_text[m_pos])))
+        {
+            name += static_cast<char>(toupper(static_cast<unsigned char>(m_text[m_pos++])));
+        }
+        const map<string, Op> values = {
+            {"A", Op::A}, {"X", Op::X}, {"Y", Op::Y}, {"S", Op::S}, {"P", Op::P}, {"PC", Op::PC}, {"HITS", Op::Hits}};
+        if(const auto value = values.find(name); value != values.end())
+        {
+            Emit(value->second, 1);
+        }
+        else if(name == "PEEK" || name == "DPEEK")
+        {
+            Expect("(");
+            LogicalOr();
+            Expect(")");
+            Emit(name == "PEEK" ? Op::Peek : Op::DPeek, 0);
+        }
+        else
+        {
+            Fail(name.empty() ? "expected a value" : "unknown name " + name);
+        }
+    }
+
+    int32_t Number()
+    {
+        int base = 10;
+        if(m_text[m_pos] == '$')
+        {
+            base = 16;
+            m_pos++;
+        }
+        else if(m_text.compare(m_pos, 2, "0x") == 0 || m_text.compare(m_pos, 2, "0X") == 0)
+        {
+            base = 16;
+            m_pos += 2;
+        }
+        const size_t start = m_pos;
+        while(m_pos < m_text.size() && (base == 16 ? isxdigit(static_cast<unsigned char>(m_text[m_pos]))
+                                                   : isdigit(static_cast<unsigned char>(m_text[m_pos]))))
+        {
+            m_pos++;
+        }
+        if(m_pos == start || m_pos - start > 8)
+        {
+            Fail("invalid number");
+        }
+        return static_cast<int32_t>(stoul(m_text.substr(start, m_pos - start), nullptr, base));
+    }
+};
+
+Condition::Condition(const string& text) : m_text(text), m_code()
+{
+    Compiler(m_text, m_code).Compile();
+}
+
+bool Condition::Evaluate(const CPU& cpu, unsigned hits) const
+{
+    int64_t  stack[STACK_SIZE];
+    unsigned top = 0;
+    for(size_t ip = 0; ip < m_code.size(); ip++)
+    {
+        const Instruction& instr = m_code[ip];
+        int64_t            rhs   = 0;
+        if(instr.op >= Op::Multiply && instr.op <= Op::NotEqual)
+        {
+            rhs = stack[--top];
+        }
+        int64_t& value = stack[instr.op <= Op::Hits ? top++ : top - 1];
+        switch(instr.op)
+        {
+        case Op::Push:
+            value = instr.value;
+            break;
+        case Op::A:
+            value = cpu.A;
+            break;
+        case Op::X:
+            value = cpu.X;
+            break;
+        case Op::Y:
+            value = cpu.Y;
+            break;
+        case Op::S:
+            value = cpu.S;
+            break;
+        case Op::P:
+            value = cpu.GetF();
+            break;
+        case Op::PC:
+            value = cpu.PC;
+            break;
+        case Op::Hits:
+            value = hits;
+            break;
+        case Op::Peek:
+            value = cpu.m_RAM->Get(static_cast<word_t>(value));
+            break;
+        case Op::DPeek:
+            value = cpu.m_RAM->GetW(static_cast<word_t>(value));
+            break;
+        case Op::Not:
+            value = !value;
+            break;
+        case Op::Complement:
+            value = ~value;
+            break;
+        case Op::Negate:
+            value = -value;
+            break;
+        case Op::Multiply:
+            value *= rhs;
+            break;
+        case Op::Divide:
+            value = rhs ? value / rhs : 0;
+            break;
+        case Op::Modulo:
+            value = rhs ? value % rhs : 0;
+            break;
+        case Op::Add:
+            value += rhs;
+            break;
+        case Op::Subtract:
+            value -= rhs;
+            break;
+        case Op::And:
+            value &= rhs;
+            break;
+        case Op::Xor:
+            value ^= rhs;
+            break;
+        case Op::Or:
+            value |= rhs;
+            break;
+        case Op::Less:
+            value = value < rhs;
+            break;
+        case Op::LessEqual:
+            value = value <= rhs;
+            break;
+        case Op::Greater:
+            value = value > rhs;
+            break;
+        case Op::GreaterEqual:
+            value = value >= rhs;
+            break;
+        case Op::Equal:
+            value = value == rhs;
+            break;
+        case Op::NotEqual:
+            value = value != rhs;
+            break;
+        case Op::Bool:
+            value = value != 0;
+            break;
+        case Op::JumpIfFalse:
+            if(!value)
+            {
+                ip = static_cast<size_t>(instr.value) - 1;
+            }
+            else
+            {
+                top--;
+            }
+            break;
+        case Op::JumpIfTrue:
+            if(value)
+            {
+                value = 1;
+                ip    = static_cast<size_t>(instr.value) - 1;
+            }
+            else
+            {
+                top--;
+            }
+            break;
+        }
+    }
+    return top && stack[top - 1];
+}
+} // namespace atre
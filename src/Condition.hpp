@@ -0,0 +1,78 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+class CPU;
+
+// breakpoint condition compiled once to stack machine code, like
+// "A==$9B && PEEK($D40B)>100 && hits>5"; values are A, X, Y, S, P, PC,
+// hits, PEEK(addr), DPEEK(addr) and decimal or $hex numbers, combined with
+// the C operators ! ~ - * / % + - & ^ | < <= > >= == != && ||
+class Condition
+{
+public:
+    // throws on syntax errors
+    Condition(const std::string& text);
+
+    // hits counts the times the breakpoint was reached, this one included;
+    // PEEK reads like the CPU, chip registers included
+    bool Evaluate(const CPU& cpu, unsigned hits) const;
+
+    inline const std::string& Text() const
+    {
+        return m_text;
+    }
+
+private:
+    // values, then unary, then binary operators, Evaluate relies on the order
+    enum class Op : byte_t
+    {
+        Push,
+        A,
+        X,
+        Y,
+        S,
+        P,
+        PC,
+        Hits,
+        Peek,
+        DPeek,
+        Not,
+        Complement,
+        Negate,
+        Multiply,
+        Divide,
+        Modulo,
+        Add,
+        Subtract,
+        And,
+        Xor,
+        Or,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        Bool,
+        JumpIfFalse, // keeps the value when jumping, drops it otherwise
+        JumpIfTrue
+    };
+
+    struct Instruction
+    {
+        Op      op;
+        int32_t value; // number or jump target
+    };
+
+    const static unsigned STACK_SIZE = 16;
+
+    std::string              m_text;
+    std::vector<Instruction> m_code;
+
+    // recursive descent compiler, one level per precedence
+    class Compiler;
+};
+} // namespace atre
@@ -0,0 +1,216 @@
+#include "Coverage.hpp"
+#include "CPU.hpp"
+#include <iomanip>
+
+using namespace std;
+
+namespace atre
+{
+namespace
+{
+const char* const MNEMONICS[256] = {
+    "BRK", "ORA", "???", "???", "???", "ORA", "ASL", "???", "PHP", "ORA", "ASL", "???", "???", "ORA", "ASL", "???", // 00
+    "BPL", "ORA", "???", "???", "???", "ORA", "ASL", "???", "CLC", "ORA", "???", "???", "???", "ORA", "ASL", "???", // 10
+    "JSR", "AND", "???", "???", "BIT", "AND", "ROL", "???", "PLP", "AND", "ROL", "???", "BIT", "AND", "ROL", "???", // 20
+    "BMI", "AND", "???", "???", "???", "AND", "ROL", "???", "SEC", "AND", "???", "???", "???", "AND", "ROL", "???", // 30
+    "RTI", "EOR", "???", "???", "???", "EOR", "LSR", "???", "PHA", "EOR", "LSR", "???", "JMP", "EOR", "LSR", "???", // 40
+    "BVC", "EOR", "???", "???", "???", "EOR", "LSR", "???", "CLI", "EOR", "???", "???", "???", "EOR", "LSR", "???", // 50
+    "RTS", "ADC", "???", "???", "???", "ADC", "ROR", "???", "PLA", "ADC", "ROR", "???", "JMP", "ADC", "ROR", "???", // 60
+    "BVS", "ADC", "???", "???", "???", "ADC", "ROR", "???", "SEI", "ADC", "???", "???", "???", "ADC", "ROR", "???", // 70
+    "???", "STA", "???", "???", "STY", "STA", "STX", "???", "DEY", "???", "TXA", "???", "STY", "STA", "STX", "???", // 80
+    "BCC", "STA", "???", "???", "STY", "STA", "STX", "???", "TYA", "STA", "TXS", "???", "???", "STA", "???", "???", // 90
+    "LDY", "LDA", "LDX", "???", "LDY", "LDA", "LDX", "???", "TAY", "LDA", "TAX", "???", "LDY", "LDA", "LDX", "???", // A0
+    "BCS", "LDA", "???", "???", "LDY", "LDA", "LDX", "???", "CLV", "LDA", "TSX", "???", "LDY", "LDA", "LDX", "???", // B0
+    "CPY", "CMP", "???", "???", "CPY", "CMP", "DEC", "???", "INY", "CMP", "DEX", "???", "CPY", "CMP", "DEC", "???", // C0
+    "BNE", "CMP", "???", "???", "???", "CMP", "DEC", "???", "CLD", "CMP", "???", "???", "???", "CMP", "DEC", "???", // D0
+    "CPX", "SBC", "???", "???", "CPX", "SBC", "INC", "???", "INX", "SBC", "NOP", "???", "CPX", "SBC", "INC", "???", // E0
+    "BEQ", "SBC", "???", "???", "???", "SBC", "INC", "???", "SED", "SBC", "???", "???", "???", "SBC", "INC", "???", // F0
+};
+
+const char* const BANK_NAMES[Coverage::BANKS] = {"RAM", "OS ROM", "Cartridge", "Self test", "IO"};
+
+string Operand(AddressingMode adr, word_t pc, word_t operand)
+{
+    ostringstream os;
+    os << hex << uppercase << setfill('0');
+    switch(adr)
+    {
+    case AddressingMode::Immediate:
+        os << "#$" << setw(2) << operand;
+        break;
+    case AddressingMode::ZeroPage:
+        os << "$" << setw(2) << operand;
+        break;
+    case AddressingMode::ZeroPageX:
+        os << "$" << setw(2) << operand << ",X";
+        break;
+    case AddressingMode::ZeroPageY:
+        os << "$" << setw(2) << operand << ",Y";
+        break;
+    case AddressingMode::Absolute:
+        os << "$" << setw(4) << operand;
+        break;
+    case AddressingMode::AbsoluteX:
+    case AddressingMode::AbsoluteXPaged:
+        os << "$" << setw(4) << operand << ",X";
+        break;
+    case AddressingMode::AbsoluteY:
+    case AddressingMode::AbsoluteYPaged:
+        os << "$" << setw(4) << operand << ",Y";
+        break;
+    case AddressingMode::IndexedIndirect:
+        os << "($" << setw(2) << operand << ",X)";
+        break;
+    case AddressingMode::IndirectIndexed:
+    case AddressingMode::IndirectIndexedPaged:
+        os << "($" << setw(2) << operand << "),Y";
+        break;
+    case AddressingMode::Accumulator:
+        os << "A";
+        break;
+    case AddressingMode::Relative:
+        os << "$" << setw(4) << static_cast<word_t>(pc + 2 + static_cast<sbyte_t>(operand));
+        break;
+    case AddressingMode::Indirect:
+        os << "($" << setw(4) << operand << ")";
+        break;
+    case AddressingMode::None:
+        break;
+    }
+    return os.str();
+}
+} // namespace
+
+Coverage::Coverage() : m_bits() {}
+
+void Coverage::Clear()
+{
+    m_bits = {};
+}
+
+unsigned Coverage::Count(MemoryBank bank) const
+{
+    unsigned count = 0;
+    for(auto bits : m_bits[static_cast<size_t>(bank)])
+    {
+        count += static_cast<unsigned>(bitset<64>(bits).count());
+    }
+    return count;
+}
+
+void Coverage::Save(const string& fileName) const
+{
+    ofstream ofs(fileName, ios_base::binary);
+    if(!ofs.good())
+    {
+        throw runtime_error("Unable to open file");
+    }
+
+    for(const auto& bits : m_bits)
+    {
+        for(auto word : bits)
+        {
+            for(int i = 0; i < 8; i++)
+            {
+                ofs.put(static_cast<char>(word >> (i * 8)));
+            }
+        }
+    }
+}
+
+void Coverage::List(ostream& os, const RAM& ram) const
+{
+    for(unsigned b = 0; b < BANKS; b++)
+    {
+        const auto bank  = static_cast<MemoryBank>(b);
+        const auto count = Count(bank);
+        if(!count)
+        {
+            continue;
+        }
+        os << "; " << BANK_NAMES[b] << ": " << dec << count << " bytes executed" << endl;
+        switch(bank)
+        {
+        case MemoryBank::RAM:
+            for(unsigned page = 0; page < 256; page++)
+            {
+                const auto& bits = m_bits[b];
+                if(bits[page * 4] | bits[page * 4 + 1] | bits[page * 4 + 2] | bits[page * 4 + 3])
+                {
+                    ListRange(os, ram, bank, page << 8, (page + 1) << 8);
+                }
+            }
+            break;
+        case MemoryBank::OS:
+            ListRange(os, ram, bank, 0xC000, 0xD000);
+            ListRange(os, ram, bank, 0xD800, MEM_SIZE);
+            break;
+        case MemoryBank::Cartridge:
+            ListRange(os, ram, bank, CARTRIDGE_START, CARTRIDGE_START + CARTRIDGE_SIZE);
+            break;
+        case MemoryBank::SelfTest:
+            ListRange(os, ram, bank, 0x5000, 0x5800);
+            break;
+        case MemoryBank::IO:
+            // nothing to disassemble without reading the chips
+            break;
+        }
+    }
+}
+
+// missed bytes are disassembled too, but as data where an instruction would
+// run into executed code so the listing stays in step with it
+void Coverage::ListRange(ostream& os, const RAM& ram, MemoryBank bank, unsigned start, unsigned end) const
+{
+    os << hex << uppercase << setfill('0');
+    for(unsigned addr = start; addr < end;)
+    {
+        const auto   pc     = static_cast<word_t>(addr);
+        const byte_t code   = ram.PeekBank(bank, pc);
+        const auto&  opCode = CPU::s_opCodeMap[code];
+        const bool   hit    = IsHit(bank, pc);
+        unsigned     bytes  = opCode.bytes;
+        for(unsigned i = 1; i < bytes && !hit; i++)
+        {
+            if(addr + i >= end || IsHit(bank, static_cast<word_t>(pc + i)))
+            {
+                bytes = 0;
+            }
+        }
+
+        os << (hit ? "+ " : "  ") << setw(4) << addr << " ";
+        for(unsigned i = 0; i < 3; i++)
+        {
+            if(i < max(bytes, 1u))
+            {
+                os << " " << setw(2) << static_cast<int>(ram.PeekBank(bank, static_cast<word_t>(pc + i)));
+            }
+            else
+            {
+                os << "   ";
+            }
+        }
+        if(bytes)
+        {
+            word_t operand = 0;
+            if(bytes == 2)
+            {
+                operand = ram.PeekBank(bank, static_cast<word_t>(pc + 1));
+            }
+            else if(bytes == 3)
+            {
+                operand = static_cast<word_t>(ram.PeekBank(bank, static_cast<word_t>(pc + 1)) |
+                                              (ram.PeekBank(bank, static_cast<word_t>(pc + 2)) << 8));
+            }
+            const string text = Operand(opCode.adr, pc, operand);
+            os << "  " << MNEMONICS[code] << (text.empty() ? "" : " ") << text << "\n";
+        }
+        else
+        {
+            os << "  .BYTE $" << setw(2) << static_cast<int>(code) << "\n";
+        }
+        addr += max(bytes, 1u);
+    }
+    os << dec << nouppercase << setfill(' ') << flush;
+}
+} // namespace atre
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "RAM.hpp"
+#include "atre.hpp"
+
+namespace atre
+{
+// a bit per executed instruction byte, kept separately for each bank the
+// address was mapped to, so OS ROM, cartridge and the RAM under them don't
+// mix up
+class Coverage
+{
+public:
+    const static unsigned BANKS = 5; // MemoryBank values
+
+    Coverage();
+
+    void     Clear();
+    unsigned Count(MemoryBank bank) const;
+    // the bitmaps in MemoryBank order, 8 kB each, bit 0 of byte 0 is address 0
+    void Save(const std::string& fileName) const;
+    // disassembly of every bank with hits, executed bytes marked with +;
+    // RAM only on pages with hits
+    void List(std::ostream& os, const RAM& ram) const;
+
+    inline void Hit(MemoryBank bank, word_t pc, unsigned bytes)
+    {
+        auto&          bits = m_bits[static_cast<size_t>(bank)];
+        const unsigned bit  = pc & 63;
+        const uint64_t mask = (1ull << bytes) - 1;
+        bits[pc >> 6] |= mask << bit;
+        if(bit + bytes > 64)
+        {
+            bits[((pc >> 6) + 1) % WORDS] |= mask >> (64 - bit);
+        }
+    }
+
+    inline bool IsHit(MemoryBank bank, word_t addr) const
+    {
+        return (m_bits[static_cast<size_t>(bank)][addr >> 6] >> (addr & 63)) & 1;
+    }
+
+private:
+    const static unsigned WORDS = MEM_SIZE / 64;
+
+    std::array<std::array<uint64_t, WORDS>, BANKS> m_bits;
+
+    void ListRange(std::ostream& os, const RAM& ram, MemoryBank bank, unsigned start, unsigned end) const;
+};
+} // namespace atre
@@ -2,6 +2,7 @@
 #include "Atari.hpp"
 #include "Chips.hpp"
 #include "Debugger.hpp"
+#include "Snapshot.hpp"
 #include <bitset>
 #include <iostream>
 
@@ -9,7 +10,12 @@ using namespace std;
 
 namespace atre
 {
-Debugger::Debugger(Atari* atari) : m_atari(atari), m_exiting(), m_stopping(), m_mutex(), m_running(), m_CPUThread(), m_IOThread() {}
+Debugger::Debugger(Atari* atari) :
+    m_atari(atari), m_exiting(), m_stopping(), m_pausing(), m_mutex(), m_running(), m_CPUThread(), m_IOThread(), m_pacer(), m_runAhead(),
+    m_trace(), m_profiler(), m_coverage(), m_snapshot(make_unique<Snapshot>())
+{}
+
+Debugger::~Debugger() {}
 
 void Debugger::Initialize()
 {
@@ -29,9 +35,11 @@ void Debugger::Exit()
 
 void Debugger::CallStack()
 {
-    for(auto s : m_atari->getCPU()->m_callStack)
+    const auto& callStack = m_atari->getCPU()->m_callStack;
+    for(unsigned i = 0; i < callStack.Size(); i++)
     {
-        cout << hex << s.first << " (" << s.second << ")" << endl;
+        const auto& frame = callStack.Get(i);
+        cout << hex << frame.target << " (" << atre::CallStack::Name(frame.kind) << ")" << endl;
     }
     cout << hex << m_atari->getCPU()->PC << " (PC)" << endl;
 }
@@ -39,21 +47,26 @@ void Debugger::CallStack()
 void Debugger::DumpState()
 {
     const CPU& cpu = *(m_atari->getCPU());
-    cout << "A = " << hex << showbase << (int)cpu.A << " (" << dec << (int)cpu.A << "), ";
-    cout << "X = " << hex << showbase << (int)cpu.X << " (" << dec << (int)cpu.X << "), ";
-    cout << "Y = " << hex << showbase << (int)cpu.Y << " (" << dec << (int)cpu.Y << "), ";
-    cout << "PC = " << hex << showbase << (int)cpu.PC << ", ";
-    cout << "S = " << hex << showbase << (int)cpu.S << ", ";
+    PrintState(cpu.A, cpu.X, cpu.Y, cpu.PC, cpu.S, cpu.GetF());
+}
+
+void Debugger::PrintState(byte_t a, byte_t x, byte_t y, word_t pc, byte_t s, byte_t f)
+{
+    cout << "A = " << hex << showbase << (int)a << " (" << dec << (int)a << "), ";
+    cout << "X = " << hex << showbase << (int)x << " (" << dec << (int)x << "), ";
+    cout << "Y = " << hex << showbase << (int)y << " (" << dec << (int)y << "), ";
+    cout << "PC = " << hex << showbase << (int)pc << ", ";
+    cout << "S = " << hex << showbase << (int)s << ", ";
     cout << "Flags = ";
-    cout << (cpu.IsSetFlag(CPU::NEGATIVE_FLAG) ? "N" : "n");
-    cout << (cpu.IsSetFlag(CPU::OVERFLOW_FLAG) ? "O" : "o");
-    cout << (cpu.IsSetFlag(CPU::IGNORED_FLAG) ? "X" : "x");
-    cout << (cpu.IsSetFlag(CPU::BREAK_FLAG) ? "B" : "b");
-    cout << (cpu.IsSetFlag(CPU::DECIMAL_FLAG) ? "D" : "d");
-    cout << (cpu.IsSetFlag(CPU::INTERRUPT_FLAG) ? "I" : "i");
-    cout << (cpu.IsSetFlag(CPU::ZERO_FLAG) ? "Z" : "z");
-    cout << (cpu.IsSetFlag(CPU::CARRY_FLAG) ? "C" : "c");
-    cout << " " << bitset<8>(cpu.F) << endl;
+    cout << ((f & CPU::NEGATIVE_FLAG) ? "N" : "n");
+    cout << ((f & CPU::OVERFLOW_FLAG) ? "O" : "o");
+    cout << ((f & CPU::IGNORED_FLAG) ? "X" : "x");
+    cout << ((f & CPU::BREAK_FLAG) ? "B" : "b");
+    cout << ((f & CPU::DECIMAL_FLAG) ? "D" : "d");
+    cout << ((f & CPU::INTERRUPT_FLAG) ? "I" : "i");
+    cout << ((f & CPU::ZERO_FLAG) ? "Z" : "z");
+    cout << ((f & CPU::CARRY_FLAG) ? "C" : "c");
+    cout << " " << bitset<8>(f) << endl;
 }
 
 // getCPU callbacks
@@ -89,6 +102,12 @@ void Debugger::OnBreak()
     Stop();
 }
 
+void Debugger::OnWatch(word_t addr, Access access)
+{
+    cout << (access == Access::Write ? "Write" : "Read") << " at " << hex << showbase << addr << endl;
+    Stop();
+}
+
 void Debugger::Start()
 {
     m_stopping = false;
@@ -107,39 +126,118 @@ void Debugger::CPUThread()
     while(!m_exiting)
     {
         // cout << "(getCPU Thread Step)" << endl;
-        m_running.wait(runningLock);
+        m_running.wait(runningLock, [this] { return m_exiting || !m_stopping; });
         if(m_exiting)
         {
             break;
         }
         cout << "Starting CPU execution" << endl;
+        m_pacer.Restart();
+        uint64_t frameStart = m_atari->getIO()->getFrameStart();
         while(!m_stopping)
         {
-            m_atari->getCPU()->Execute();
+            if(m_pausing)
+            {
+                m_running.wait(runningLock, [this] { return !m_pausing; });
+                m_pacer.Restart();
+            }
+            // breaks and traps end the slice early and stop us from their callbacks
+            m_atari->getCPU()->RunCycles(CYCLES_PER_SCANLINE);
+            // frames start on a scanline event, a slice never spans two
+            if(m_atari->getIO()->getFrameStart() != frameStart)
+            {
+                frameStart = m_atari->getIO()->getFrameStart();
+                StartFrame();
+            }
         }
         cout << "Stopping CPU execution" << endl;
     }
     // cout << "Exiting getCPU thread" << endl;
 }
 
+void Debugger::WhilePaused(const function<void()>& command)
+{
+    exception_ptr error;
+    m_pausing = true;
+    {
+        // the CPU thread holds the lock for as long as it runs
+        lock_guard<mutex> lock(m_mutex);
+        try
+        {
+            command();
+        }
+        catch(...)
+        {
+            error = current_exception();
+        }
+        m_pausing = false;
+    }
+    m_running.notify_one();
+    if(error)
+    {
+        rethrow_exception(error);
+    }
+}
+
+// paces the frame, hands it the input polled so far and runs ahead: the
+// frames up to the shown one run from a snapshot with the same input, the
+// last of them is drawn, then the frame itself runs again from the snapshot
+// without drawing. Breakpoints, traps, coverage and the seconds count only
+// see the frames that count, run-ahead stays off while instructions are
+// recorded
+void Debugger::StartFrame()
+{
+    IO*            io     = m_atari->getIO();
+    CPU*           cpu    = m_atari->getCPU();
+    const unsigned frames = m_runAhead;
+    io->SetFrameSkip(m_pacer.Frame(io->getFrameStart()));
+    io->ApplyInput();
+    if(!frames || !io->IsRendering() || cpu->MustStep())
+    {
+        return;
+    }
+
+    m_snapshot->Save(m_atari);
+    const bool showCycles = cpu->m_showCycles;
+    cpu->m_showCycles     = false;
+    Coverage* const coverage = cpu->m_coverage;
+    cpu->Attach(nullptr);
+    cpu->AttachCoverage(nullptr);
+    for(unsigned frame = 0; frame < frames; frame++)
+    {
+        io->SetRendering(frame == frames - 1);
+        m_atari->RunFrame();
+    }
+    cpu->AttachCoverage(coverage);
+    cpu->Attach(this);
+    cpu->m_showCycles = showCycles;
+    m_snapshot->Restore(m_atari);
+    io->SetRendering(false);
+}
+
+// shows each frame the CPU thread starts and polls input in between, or
+// refreshes once a second while stopped; frames started while one is shown
+// are left out
 void Debugger::IOThread()
 {
     // cout << "Starting getIO thread" << endl;
     m_atari->getIO()->Initialize();
-    auto tickInterval  = chrono::duration<int, milli>(MILLISEC_PER_FRAME);
-    auto pauseInterval = chrono::duration<int, milli>(1000);
+    auto pauseInterval = chrono::milliseconds(1000);
+    auto pollInterval  = chrono::milliseconds(INPUT_POLL_MILLISEC);
+    bool refresh       = true;
     while(!m_exiting)
     {
         // cout << "(getIO Thread Step)" << endl;
-        m_atari->getIO()->Refresh(!m_stopping);
-        if(m_stopping)
+        const bool running = !m_stopping;
+        if(refresh)
         {
-            this_thread::sleep_for(pauseInterval);
+            m_atari->getIO()->Refresh(running);
         }
         else
         {
-            this_thread::sleep_for(tickInterval);
+            m_atari->getIO()->PollInput(running);
         }
+        refresh = m_pacer.WaitFrame(running ? pollInterval : pauseInterval) || !running;
     }
     m_atari->getIO()->Destroy();
     // cout << "Exiting getIO thread" << endl;
@@ -150,6 +248,180 @@ void Debugger::Steps(bool steps)
     m_atari->getCPU()->m_showSteps = steps;
 }
 
+void Debugger::JIT(bool enable)
+{
+    m_atari->getCPU()->m_enableJIT = enable;
+}
+
+void Debugger::FloatingPoint(bool enable)
+{
+    m_atari->getCPU()->m_enableMathPack = enable;
+}
+
+void Debugger::Clock(unsigned multiplier)
+{
+    WhilePaused([this, multiplier] { m_atari->getCPU()->SetClockMultiplier(multiplier); });
+}
+
+void Debugger::Speed(unsigned speed)
+{
+    m_pacer.SetSpeed(speed);
+}
+
+void Debugger::FrameSkip(unsigned frames)
+{
+    m_pacer.SetFrameSkip(frames);
+}
+
+void Debugger::RunAhead(unsigned frames)
+{
+    m_runAhead = frames;
+}
+
+void Debugger::PacingReport()
+{
+    m_pacer.Report(cout);
+}
+
+void Debugger::PacingClear()
+{
+    m_pacer.ClearStats();
+}
+
+// the condition compiles before the CPU thread is paused
+void Debugger::Break(word_t addr, const string& condition)
+{
+    auto& breakpoints = m_atari->getCPU()->m_breakpoints;
+    if(condition.empty())
+    {
+        // also drops a condition set at addr before
+        WhilePaused([&breakpoints, addr] { breakpoints.Add(Access::Execute, addr, addr); });
+    }
+    else
+    {
+        Condition compiled(condition);
+        WhilePaused([&breakpoints, addr, &compiled] { breakpoints.AddConditional(addr, move(compiled)); });
+    }
+}
+
+void Debugger::Watch(Access access, word_t start, word_t end)
+{
+    WhilePaused([this, access, start, end] { m_atari->getCPU()->m_breakpoints.Add(access, start, end); });
+}
+
+void Debugger::ClearBreakpoints()
+{
+    WhilePaused([this] { m_atari->getCPU()->m_breakpoints.Clear(); });
+}
+
+// an empty file name only keeps the last records in memory
+void Debugger::TraceOn(const string& fileName)
+{
+    WhilePaused([this, &fileName] {
+        if(!m_trace)
+        {
+            m_trace = make_unique<Trace>(TRACE_CAPACITY);
+        }
+        m_trace->StopWriter();
+        if(!fileName.empty())
+        {
+            m_trace->StartWriter(fileName);
+        }
+        m_atari->getCPU()->AttachTrace(m_trace.get());
+    });
+}
+
+void Debugger::TraceOff()
+{
+    WhilePaused([this] {
+        m_atari->getCPU()->AttachTrace(nullptr);
+        if(m_trace)
+        {
+            m_trace->StopWriter();
+        }
+    });
+}
+
+void Debugger::TraceSave(const string& fileName)
+{
+    WhilePaused([this, &fileName] {
+        if(!m_trace)
+        {
+            throw runtime_error("No trace recorded");
+        }
+        m_trace->Save(fileName);
+    });
+}
+
+void Debugger::Profile(bool enable)
+{
+    WhilePaused([this, enable] { m_atari->getCPU()->AttachProfiler(enable ? GetProfiler() : nullptr); });
+}
+
+void Debugger::ProfileClear()
+{
+    WhilePaused([this] { GetProfiler()->Clear(); });
+}
+
+void Debugger::ProfileLabels(const string& fileName)
+{
+    WhilePaused([this, &fileName] { GetProfiler()->LoadLabels(fileName); });
+}
+
+void Debugger::ProfileReport(unsigned count)
+{
+    WhilePaused([this, count] { GetProfiler()->Report(cout, count); });
+}
+
+void Debugger::ProfileFolded(const string& fileName)
+{
+    WhilePaused([this, &fileName] { GetProfiler()->SaveFolded(fileName); });
+}
+
+// labels can be loaded before profiling starts
+Profiler* Debugger::GetProfiler()
+{
+    if(!m_profiler)
+    {
+        m_profiler = make_unique<Profiler>();
+    }
+    return m_profiler.get();
+}
+
+void Debugger::CoverageOn(bool enable)
+{
+    WhilePaused([this, enable] { m_atari->getCPU()->AttachCoverage(enable ? GetCoverage() : nullptr); });
+}
+
+void Debugger::CoverageClear()
+{
+    WhilePaused([this] { GetCoverage()->Clear(); });
+}
+
+void Debugger::CoverageSave(const string& fileName)
+{
+    WhilePaused([this, &fileName] { GetCoverage()->Save(fileName); });
+}
+
+void Debugger::CoverageList(const string& fileName)
+{
+    ofstream ofs(fileName);
+    if(!ofs.good())
+    {
+        throw runtime_error("Unable to open file");
+    }
+    WhilePaused([this, &ofs] { GetCoverage()->List(ofs, *m_atari->getRAM()); });
+}
+
+Coverage* Debugger::GetCoverage()
+{
+    if(!m_coverage)
+    {
+        m_coverage = make_unique<Coverage>();
+    }
+    return m_coverage.get();
+}
+
 void Debugger::DumpRAM(const string& fileName)
 {
     ofstream ofs(fileName, ios_base::binary);
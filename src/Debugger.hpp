@@ -1,10 +1,16 @@
 #pragma once
 
+#include "Breakpoints.hpp"
+#include "Coverage.hpp"
+#include "Pacer.hpp"
+#include "Profiler.hpp"
+#include "Trace.hpp"
 #include "atre.hpp"
 
 namespace atre
 {
 class Atari;
+class Snapshot;
 
 class Callbacks
 {
@@ -15,6 +21,7 @@ public:
     virtual void OnBRK() {}
     virtual void OnReset() {}
     virtual void OnBreak() {}
+    virtual void OnWatch(word_t /*addr*/, Access /*access*/) {}
     virtual void DumpState() {}
 
     virtual ~Callbacks() {}
@@ -24,6 +31,7 @@ class Debugger : public Callbacks
 {
 public:
     Debugger(Atari* atari);
+    ~Debugger();
 
     void Initialize();
     void Exit();
@@ -34,6 +42,7 @@ public:
     void OnBRK() override;
     void OnReset() override;
     void OnBreak() override;
+    void OnWatch(word_t addr, Access access) override;
     void DumpState() override;
 
     // commands
@@ -41,19 +50,67 @@ public:
     void Stop();
     void CallStack();
     void Steps(bool);
+    void JIT(bool);
+    void FloatingPoint(bool);
+    void Clock(unsigned multiplier);
+    // emulated time runs at speed times the host's, 0 runs unthrottled
+    void Speed(unsigned speed);
+    void FrameSkip(unsigned frames);
+    // shows frames ahead of the emulation, 0 turns it off
+    void RunAhead(unsigned frames);
+    void PacingReport();
+    void PacingClear();
+    // an empty condition always breaks
+    void Break(word_t addr, const std::string& condition);
+    void Watch(Access access, word_t start, word_t end);
+    void ClearBreakpoints();
+    void TraceOn(const std::string& fileName);
+    void TraceOff();
+    void TraceSave(const std::string& fileName);
+    void Profile(bool);
+    void ProfileClear();
+    void ProfileLabels(const std::string& fileName);
+    void ProfileReport(unsigned count);
+    void ProfileFolded(const std::string& fileName);
+    void CoverageOn(bool);
+    void CoverageClear();
+    void CoverageSave(const std::string& fileName);
+    void CoverageList(const std::string& fileName);
     void DumpRAM(const std::string& fileName);
     void ShowDList();
 
+    static void PrintState(byte_t a, byte_t x, byte_t y, word_t pc, byte_t s, byte_t f);
+
+    const static size_t   TRACE_CAPACITY       = 1 << 16;
+    const static unsigned MAX_RUN_AHEAD_FRAMES = 4;
+    // how often the IO thread takes host input between frames
+    const static unsigned INPUT_POLL_MILLISEC = 2;
+
 private:
     Atari*                       m_atari;
     std::atomic_bool             m_exiting;
     std::atomic_bool             m_stopping;
+    std::atomic_bool             m_pausing;
     std::mutex                   m_mutex;
     std::condition_variable      m_running;
     std::unique_ptr<std::thread> m_CPUThread;
     std::unique_ptr<std::thread> m_IOThread;
+    Pacer                        m_pacer;
+    std::atomic_uint             m_runAhead;
+    // kept once created, the CPU thread may still be using them
+    std::unique_ptr<Trace>       m_trace;
+    std::unique_ptr<Profiler>    m_profiler;
+    std::unique_ptr<Coverage>    m_coverage;
+    // CPU thread only
+    std::unique_ptr<Snapshot>    m_snapshot;
 
-    void CPUThread();
-    void IOThread();
+    Profiler* GetProfiler();
+    Coverage* GetCoverage();
+    // runs the command while the CPU thread waits between two slices, for
+    // state the CPU thread uses on every instruction
+    void      WhilePaused(const std::function<void()>& command);
+    void      CPUThread();
+    void      StartFrame();
+    void      IOThread();
 };
 } // namespace atre
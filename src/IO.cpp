@@ -28,7 +28,7 @@ const map<SDL_Scancode, int> IO::s_scanCodes = {
 
 IO::IO(CPU* cpu, RAM* ram) :
     m_CPU(cpu), m_ANTIC(cpu, ram), m_GTIA(cpu, ram, m_ANTIC.getScanBuffer()), m_POKEY(cpu, ram), m_PIA(cpu, ram), m_window(), m_renderer(),
-    m_texture()
+    m_texture(), m_inputMutex(), m_input()
 {}
 
 void IO::Initialize()
@@ -72,82 +72,99 @@ void IO::Refresh(bool cpuRunning)
     SDL_RenderCopy(m_renderer, m_texture, NULL, NULL);
     SDL_RenderPresent(m_renderer);
 
-    if(cpuRunning)
+    PollInput(cpuRunning);
+}
+
+// takes every pending event, keys are queued for the CPU thread
+void IO::PollInput(bool cpuRunning)
+{
+    if(!cpuRunning)
     {
-        // poll keyboard
-        SDL_Event e;
-        if(SDL_PollEvent(&e))
+        SDL_PollEvent(NULL);
+        return;
+    }
+    SDL_Event e;
+    while(SDL_PollEvent(&e))
+    {
+        if(e.type == SDL_KEYDOWN || e.type == SDL_KEYUP)
         {
-            switch(e.type)
-            {
-            case SDL_KEYDOWN:
-            case SDL_KEYUP: {
-                auto shiftStatus = e.key.keysym.mod & KMOD_SHIFT;
-                auto isUp        = e.type == SDL_KEYUP;
-                m_POKEY.ShiftKey(shiftStatus);
-                if(e.key.keysym.scancode == SDL_SCANCODE_F2)
-                {
-                    m_GTIA.Start(e.type == SDL_KEYDOWN);
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_F3)
-                {
-                    m_GTIA.Select(e.type == SDL_KEYDOWN);
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_F4)
-                {
-                    m_GTIA.Option(e.type == SDL_KEYDOWN);
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_F5)
-                {
-                    m_CPU->Reset();
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_UP)
-                {
-                    m_PIA.JoyUp(!isUp);
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_DOWN)
-                {
-                    m_PIA.JoyDown(!isUp);
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_LEFT)
-                {
-                    m_PIA.JoyLeft(!isUp);
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_RIGHT)
-                {
-                    m_PIA.JoyRight(!isUp);
-                }
-                else if(e.key.keysym.scancode == SDL_SCANCODE_LCTRL)
-                {
-                    m_GTIA.JoyFire(!isUp);
-                }
-                else if(isUp)
-                {
-                    m_POKEY.KeyUp();
-                }
-                else
-                {
-                    auto ctrlStatus = e.key.keysym.mod & KMOD_CTRL;
-                    auto scanCode   = s_scanCodes.find(e.key.keysym.scancode);
-                    if(scanCode != s_scanCodes.end())
-                    {
-                        m_POKEY.KeyDown(static_cast<byte_t>(scanCode->second), shiftStatus, ctrlStatus);
-                    }
-                    else if(e.key.keysym.scancode == SDL_SCANCODE_F6)
-                    {
-                        m_POKEY.Break();
-                    }
-                }
-            }
-            break;
-            default:
-                break;
-            }
+            lock_guard<mutex> lock(m_inputMutex);
+            m_input.push_back(e.key);
         }
     }
+}
+
+// the chips only see input between frames, on the CPU thread
+void IO::ApplyInput()
+{
+    vector<SDL_KeyboardEvent> input;
+    {
+        lock_guard<mutex> lock(m_inputMutex);
+        input.swap(m_input);
+    }
+    for(const auto& key : input)
+    {
+        ApplyKey(key);
+    }
+}
+
+void IO::ApplyKey(const SDL_KeyboardEvent& key)
+{
+    auto shiftStatus = key.keysym.mod & KMOD_SHIFT;
+    auto isUp        = key.type == SDL_KEYUP;
+    m_POKEY.ShiftKey(shiftStatus);
+    if(key.keysym.scancode == SDL_SCANCODE_F2)
+    {
+        m_GTIA.Start(key.type == SDL_KEYDOWN);
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_F3)
+    {
+        m_GTIA.Select(key.type == SDL_KEYDOWN);
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_F4)
+    {
+        m_GTIA.Option(key.type == SDL_KEYDOWN);
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_F5)
+    {
+        m_CPU->Reset();
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_UP)
+    {
+        m_PIA.JoyUp(!isUp);
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_DOWN)
+    {
+        m_PIA.JoyDown(!isUp);
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_LEFT)
+    {
+        m_PIA.JoyLeft(!isUp);
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_RIGHT)
+    {
+        m_PIA.JoyRight(!isUp);
+    }
+    else if(key.keysym.scancode == SDL_SCANCODE_LCTRL)
+    {
+        m_GTIA.JoyFire(!isUp);
+    }
+    else if(isUp)
+    {
+        m_POKEY.KeyUp();
+    }
     else
     {
-        SDL_PollEvent(NULL);
+        auto ctrlStatus = key.keysym.mod & KMOD_CTRL;
+        auto scanCode   = s_scanCodes.find(key.keysym.scancode);
+        if(scanCode != s_scanCodes.end())
+        {
+            m_POKEY.KeyDown(static_cast<byte_t>(scanCode->second), shiftStatus, ctrlStatus);
+        }
+        else if(key.keysym.scancode == SDL_SCANCODE_F6)
+        {
+            m_POKEY.Break();
+        }
     }
 }
 
@@ -167,7 +184,11 @@ void IO::Write(word_t addr, byte_t val)
     }
     if(addr < 0xD200)
     {
+        m_ANTIC.Sync();
+        m_GTIA.Sync(m_CPU->m_scheduler.Now());
         m_GTIA.Write(addr, val);
+        // GRACTL decides whether ANTIC sets up every line
+        m_ANTIC.ScheduleLine();
         return;
     }
     if(addr < 0xD300)
@@ -180,7 +201,9 @@ void IO::Write(word_t addr, byte_t val)
         m_PIA.Write(addr, val);
         return;
     }
+    m_ANTIC.Sync();
     m_ANTIC.Write(addr, val);
+    m_ANTIC.ScheduleLine();
 }
 
 byte_t IO::Read(word_t addr)
@@ -191,6 +214,8 @@ byte_t IO::Read(word_t addr)
     }
     if(addr < 0xD200)
     {
+        m_ANTIC.Sync();
+        m_GTIA.Sync(m_CPU->m_scheduler.Now());
         return m_GTIA.Read(0xD000 + (addr & 0x1F));
     }
     if(addr < 0xD300)
@@ -204,16 +229,119 @@ byte_t IO::Read(word_t addr)
     return m_ANTIC.Read(0xD400 + (addr & 0xF));
 }
 
-void IO::Tick()
+uint64_t IO::StableUntil(word_t addr, uint64_t since)
 {
-    m_ANTIC.Tick();
-    m_GTIA.Tick();
-    m_POKEY.Tick();
-    m_PIA.Tick();
+    if(addr < 0xD200)
+    {
+        return m_GTIA.StableUntil(0xD000 + (addr & 0x1F), since);
+    }
+    if(addr < 0xD300)
+    {
+        return m_POKEY.StableUntil(0xD200 + (addr & 0xF), since);
+    }
+    if(addr < 0xD400)
+    {
+        return m_PIA.StableUntil(0xD300 + (addr & 0x3), since);
+    }
+    return m_ANTIC.StableUntil(0xD400 + (addr & 0xF), since);
+}
+
+// called by the CPU with the clock at the event's deadline
+void IO::Dispatch(ChipEvent event)
+{
+#ifdef ATRE_COROUTINES
+    auto& task = m_tasks[static_cast<size_t>(event)];
+    if(task.IsDone())
+    {
+        task = StartTask(event);
+    }
+    task.Resume();
+#else
+    switch(event)
+    {
+    case ChipEvent::Scanline:
+        // GTIA draws the rest of its line before ANTIC sets up the new one
+        m_GTIA.Sync(m_CPU->m_scheduler.Now() - 1);
+        m_ANTIC.StartScanline();
+        break;
+    case ChipEvent::SerialOut:
+        m_POKEY.SerialOutDone();
+        break;
+    case ChipEvent::Keyboard:
+        m_POKEY.ScanKeyboard();
+        break;
+    case ChipEvent::Timers:
+        m_POKEY.UpdateTimers();
+        break;
+    default:
+        break;
+    }
+#endif
+}
+
+#ifdef ATRE_COROUTINES
+// the chips pick their next deadlines as in the event switch, each task
+// runs the work of its event every time the scheduler resumes it
+ChipTask IO::StartTask(ChipEvent event)
+{
+    switch(event)
+    {
+    case ChipEvent::Scanline:
+        return Scanlines();
+    case ChipEvent::SerialOut:
+        return SerialOut();
+    case ChipEvent::Keyboard:
+        return Keyboard();
+    case ChipEvent::Timers:
+        return Timers();
+    default:
+        throw runtime_error("Invalid chip event");
+    }
+}
+
+ChipTask IO::Scanlines()
+{
+    for(;;)
+    {
+        // GTIA draws the rest of its line before ANTIC sets up the new one
+        m_GTIA.Sync(m_CPU->m_scheduler.Now() - 1);
+        m_ANTIC.StartScanline();
+        co_await ChipTask::NextEvent();
+    }
+}
+
+ChipTask IO::SerialOut()
+{
+    for(;;)
+    {
+        m_POKEY.SerialOutDone();
+        co_await ChipTask::NextEvent();
+    }
+}
+
+ChipTask IO::Keyboard()
+{
+    for(;;)
+    {
+        m_POKEY.ScanKeyboard();
+        co_await ChipTask::NextEvent();
+    }
+}
+
+ChipTask IO::Timers()
+{
+    for(;;)
+    {
+        m_POKEY.UpdateTimers();
+        co_await ChipTask::NextEvent();
+    }
 }
+#endif
 
 void IO::Reset()
 {
+    m_ANTIC.Sync();
+    m_GTIA.Sync(m_CPU->m_scheduler.Now());
     m_GTIA.Reset();
     m_POKEY.Reset();
     m_PIA.Reset();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ANTIC.hpp"
+#include "ChipTask.hpp"
 #include "Chips.hpp"
 #include <SDL.h>
 
@@ -11,16 +12,50 @@ class IO
 public:
     IO(CPU* cpu, RAM* ram);
 
+    // IO thread
     void Initialize();
     void Refresh(bool cpuRunning);
+    void PollInput(bool cpuRunning);
     void Destroy();
 
-    void   Tick();
-    void   Reset();
-    void   Write(word_t reg, byte_t val);
-    byte_t Read(word_t reg);
+    // CPU thread, hands the keys polled so far to the chips
+    void ApplyInput();
+
+    void     Dispatch(ChipEvent event);
+    void     Reset();
+    void     Write(word_t reg, byte_t val);
+    byte_t   Read(word_t reg);
+    // see Chip::StableUntil
+    uint64_t StableUntil(word_t reg, uint64_t since);
+
+    inline word_t getScanLine() const
+    {
+        return m_ANTIC.getScanLine();
+    }
+
+    inline uint64_t getFrameStart() const
+    {
+        return m_ANTIC.getFrameStart();
+    }
+
+    inline void SetFrameSkip(unsigned frames)
+    {
+        m_ANTIC.SetFrameSkip(frames);
+    }
+
+    inline bool IsRendering() const
+    {
+        return m_ANTIC.IsRendering();
+    }
+
+    inline void SetRendering(bool rendering)
+    {
+        m_ANTIC.SetRendering(rendering);
+    }
 
 private:
+    friend class Snapshot;
+
     const static std::map<SDL_Scancode, int> s_scanCodes;
 
     CPU* m_CPU;
@@ -33,5 +68,23 @@ private:
     SDL_Window*   m_window;
     SDL_Renderer* m_renderer;
     SDL_Texture*  m_texture;
+
+    std::mutex                     m_inputMutex;
+    std::vector<SDL_KeyboardEvent> m_input; // polled, not applied yet
+
+#ifdef ATRE_COROUTINES
+    // one per event, started when the event first comes up
+    std::array<ChipTask, static_cast<size_t>(ChipEvent::Count)> m_tasks;
+#endif
+
+    void ApplyKey(const SDL_KeyboardEvent& key);
+
+#ifdef ATRE_COROUTINES
+    ChipTask StartTask(ChipEvent event);
+    ChipTask Scanlines();
+    ChipTask SerialOut();
+    ChipTask Keyboard();
+    ChipTask Timers();
+#endif
 };
 } // namespace atre
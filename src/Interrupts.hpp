@@ -0,0 +1,122 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+// IRQ sources, POKEY's in their IRQEN/IRQST bit positions
+namespace IRQSource
+{
+const unsigned TIMER1              = 0x001;
+const unsigned TIMER2              = 0x002;
+const unsigned TIMER4              = 0x004;
+const unsigned SERIAL_OUT_COMPLETE = 0x008;
+const unsigned SERIAL_OUT_READY    = 0x010;
+const unsigned SERIAL_IN_READY     = 0x020;
+const unsigned KEYBOARD            = 0x040;
+const unsigned BREAK_KEY           = 0x080;
+const unsigned POKEY               = 0x0FF;
+const unsigned PIA                 = 0x100; // PACTL/PBCTL interrupt inputs
+const unsigned EXTERNAL            = 0x200; // cartridges and test hardware
+} // namespace IRQSource
+
+// NMI sources in their NMIST bit positions
+namespace NMISource
+{
+const unsigned DLI      = 0x80;
+const unsigned VBI      = 0x40;
+const unsigned RESET    = 0x20; // the 400/800 RESET key, XL models reset the CPU
+const unsigned EXTERNAL = 0x01;
+} // namespace NMISource
+
+// collects the interrupt lines of all chips into one ready word for the
+// CPU to check per instruction. IRQ lines are level-triggered and stay
+// asserted until their chip releases them, masked per source; requests
+// and NMIs are edge-triggered and latched until the CPU takes them
+class InterruptController
+{
+public:
+    const static unsigned NMI_READY = 1;
+    const static unsigned IRQ_READY = 2;
+
+    InterruptController() : m_irqLines(), m_irqMask(~0u), m_irqRequests(), m_nmiLines(), m_nmiLatch(), m_ready() {}
+
+    // lines outside mask keep their level
+    inline void SetIRQLines(unsigned mask, unsigned lines)
+    {
+        m_irqLines = (m_irqLines & ~mask) | (lines & mask);
+        Update();
+    }
+
+    inline void SetIRQMask(unsigned mask, unsigned enabled)
+    {
+        m_irqMask = (m_irqMask & ~mask) | (enabled & mask);
+        Update();
+    }
+
+    // one IRQ, taken once the I flag allows it
+    inline void RequestIRQ(unsigned source)
+    {
+        m_irqRequests |= source;
+        Update();
+    }
+
+    // latches an NMI on the rising edge of a line
+    inline void SetNMILines(unsigned mask, unsigned lines)
+    {
+        m_nmiLatch |= lines & mask & ~m_nmiLines;
+        m_nmiLines = (m_nmiLines & ~mask) | (lines & mask);
+        Update();
+    }
+
+    inline void RaiseNMI(unsigned source)
+    {
+        m_nmiLatch |= source;
+        Update();
+    }
+
+    // called when the CPU takes the interrupt
+    inline void AcknowledgeIRQ()
+    {
+        m_irqRequests = 0;
+        Update();
+    }
+
+    inline void AcknowledgeNMI()
+    {
+        m_nmiLatch = 0;
+        Update();
+    }
+
+    // drops pending requests, chips keep driving their lines
+    inline void Reset()
+    {
+        m_irqRequests = 0;
+        m_nmiLatch    = 0;
+        Update();
+    }
+
+    inline unsigned Ready() const
+    {
+        return m_ready;
+    }
+
+    inline unsigned IRQLines() const
+    {
+        return m_irqLines & m_irqMask;
+    }
+
+private:
+    unsigned m_irqLines;
+    unsigned m_irqMask;
+    unsigned m_irqRequests;
+    unsigned m_nmiLines;
+    unsigned m_nmiLatch;
+    unsigned m_ready;
+
+    inline void Update()
+    {
+        m_ready = (m_nmiLatch ? NMI_READY : 0) | ((m_irqLines & m_irqMask) || m_irqRequests ? IRQ_READY : 0);
+    }
+};
+} // namespace atre
@@ -0,0 +1,515 @@
+#include "Jit.hpp"
+#include "CPU.hpp"
+#include "RAM.hpp"
+
+#ifdef ATRE_JIT_X64
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+using namespace std;
+
+namespace atre
+{
+namespace
+{
+template <typename T>
+int32_t FieldOffset(const CPU* cpu, const T* field)
+{
+    return static_cast<int32_t>(reinterpret_cast<const byte_t*>(field) - reinterpret_cast<const byte_t*>(cpu));
+}
+} // namespace
+
+Jit::Jit(CPU* cpu, RAM* ram, const CPU::JitThunk* thunks) :
+    m_RAM(ram), m_thunks(thunks), m_code(), m_used(), m_epoch(), m_buffer(), m_epilogueJumps(), m_offA(FieldOffset(cpu, &cpu->A)),
+    m_offX(FieldOffset(cpu, &cpu->X)), m_offY(FieldOffset(cpu, &cpu->Y)), m_offS(FieldOffset(cpu, &cpu->S)),
+    m_offPC(FieldOffset(cpu, &cpu->PC)), m_offF(FieldOffset(cpu, &cpu->F)),
+    m_offN(FieldOffset(cpu, &cpu->m_nResult)), m_offZ(FieldOffset(cpu, &cpu->m_zResult))
+{}
+
+Jit::~Jit()
+{
+#ifdef ATRE_JIT_X64
+    if(m_code)
+    {
+#ifdef _WIN32
+        VirtualFree(m_code, 0, MEM_RELEASE);
+#else
+        munmap(m_code, CODE_SIZE);
+#endif
+    }
+#endif
+}
+
+bool Jit::IsCompiled(const Block& block) const
+{
+    return block.native && block.epoch == m_epoch;
+}
+
+#ifdef ATRE_JIT_X64
+
+namespace
+{
+// x86-64 registers used by the generated code
+const byte_t RAX = 0;
+const byte_t RCX = 1;
+const byte_t RDX = 2;
+
+// code pages are only writable while a block is being copied in
+void Protect(byte_t* start, size_t size, bool writable)
+{
+    const size_t pageSize = 4096;
+    const auto   first    = reinterpret_cast<uintptr_t>(start) & ~(pageSize - 1);
+    const auto   last     = reinterpret_cast<uintptr_t>(start) + size;
+#ifdef _WIN32
+    DWORD oldProtect;
+    if(!VirtualProtect(reinterpret_cast<void*>(first), last - first, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &oldProtect))
+#else
+    if(mprotect(reinterpret_cast<void*>(first), last - first, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC))
+#endif
+    {
+        throw runtime_error("Unable to change JIT code protection");
+    }
+}
+} // namespace
+
+bool Jit::Compile(Block& block)
+{
+    if(!m_code)
+    {
+#ifdef _WIN32
+        m_code = static_cast<byte_t*>(VirtualAlloc(nullptr, CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+        void* code = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        m_code     = code == MAP_FAILED ? nullptr : static_cast<byte_t*>(code);
+#endif
+        if(!m_code)
+        {
+            throw runtime_error("Unable to allocate JIT code memory");
+        }
+    }
+
+    Translate(block);
+
+    if(m_used + m_buffer.size() > CODE_SIZE)
+    {
+        // out of space, start over and let every block recompile
+        m_used = 0;
+        m_epoch++;
+    }
+
+    byte_t* code = m_code + m_used;
+    Protect(code, m_buffer.size(), true);
+    memcpy(code, m_buffer.data(), m_buffer.size());
+    Protect(code, m_buffer.size(), false);
+#ifdef _WIN32
+    FlushInstructionCache(GetCurrentProcess(), code, m_buffer.size());
+#endif
+    m_used += (m_buffer.size() + 15) & ~size_t(15);
+
+    block.native = reinterpret_cast<NativeBlock>(code);
+    block.epoch  = m_epoch;
+    return true;
+}
+
+// unsigned Block(CPU* cpu): runs the instructions in order and returns
+// the cycles of the ones it executed; CPU::JitStep results decide early exits
+void Jit::Translate(const Block& block)
+{
+    m_buffer.clear();
+    m_epilogueJumps.clear();
+    vector<Exit> exits;
+
+    Emit({0x53});                   // push rbx
+    Emit({0x48, 0x83, 0xEC, 0x20}); // sub rsp, 32 (shadow space, keeps rsp aligned)
+#ifdef _WIN32
+    Emit({0x48, 0x89, 0xCB}); // mov rbx, rcx
+#else
+    Emit({0x48, 0x89, 0xFB}); // mov rbx, rdi
+#endif
+
+    unsigned cycles  = 0;
+    bool     pcValid = true;
+    bool     ended   = false;
+    for(size_t i = 0; i < block.ops.size() && !ended; i++)
+    {
+        const MicroOp& op   = block.ops[i];
+        const bool     last = i + 1 == block.ops.size();
+        const auto     next = static_cast<word_t>(op.pc + op.bytes);
+
+        if(EmitInline(op))
+        {
+            cycles += op.cycles;
+            pcValid = false;
+        }
+        else if(last && op.adr == AddressingMode::Relative && static_cast<word_t>(next + static_cast<sbyte_t>(op.operand)) != op.pc)
+        {
+            EmitBranch(op, cycles + op.cycles);
+            ended = true;
+        }
+        else if(last && op.code == 0x4C && op.operand != op.pc)
+        {
+            EmitJump(op, cycles + op.cycles);
+            ended = true;
+        }
+        else
+        {
+            // branches and jumps to self stay in the CPU for trap detection
+            if(!pcValid)
+            {
+                EmitSetPC(op.pc);
+            }
+            EmitCall(op);
+            exits.push_back({EmitJump32({0x0F, 0x85}), cycles, cycles + op.cycles}); // jnz exit
+            cycles += op.cycles;
+            pcValid = true;
+        }
+    }
+    if(!ended)
+    {
+        if(!pcValid)
+        {
+            const MicroOp& op = block.ops.back();
+            EmitSetPC(static_cast<word_t>(op.pc + op.bytes));
+        }
+        EmitReturn(cycles);
+    }
+
+    const size_t epilogue = m_buffer.size();
+    Emit({0x48, 0x83, 0xC4, 0x20}); // add rsp, 32
+    Emit({0x5B});                   // pop rbx
+    Emit({0xC3});                   // ret
+    for(auto jump : m_epilogueJumps)
+    {
+        Patch(jump, epilogue);
+    }
+
+    // stopped after the instruction ran or bailed out before it did
+    for(const auto& exit : exits)
+    {
+        Patch(exit.jump, m_buffer.size());
+        Emit({0x83, 0xF8, static_cast<byte_t>(CPU::JIT_BAIL)}); // cmp eax, JIT_BAIL
+        Emit({0xB8});                                           // mov eax, cyclesAfter
+        Emit32(exit.cyclesAfter);
+        Patch(EmitJump32({0x0F, 0x85}), epilogue); // jne epilogue
+        Emit({0xB8});                              // mov eax, cyclesBefore
+        Emit32(exit.cyclesBefore);
+        Patch(EmitJump32({0xE9}), epilogue); // jmp epilogue
+    }
+}
+
+// register-only instructions, PC is left behind and synced before the next call
+bool Jit::EmitInline(const MicroOp& op)
+{
+    const auto imm = static_cast<byte_t>(op.operand);
+
+    auto loadDL  = [&](int32_t off) { EmitMem(0x8A, RDX, off); };
+    auto storeDL = [&](int32_t off) { EmitMem(0x88, RDX, off); };
+    auto andF    = [&](byte_t mask) {
+        EmitMem(0x80, 4, m_offF);
+        Emit({mask});
+    };
+    auto orF = [&](byte_t mask) {
+        EmitMem(0x80, 1, m_offF);
+        Emit({mask});
+    };
+    auto loadImm = [&](int32_t off) {
+        for(auto dest : {off, m_offN, m_offZ})
+        {
+            EmitMem(0xC6, 0, dest);
+            Emit({imm});
+        }
+    };
+    auto loadZeroPage = [&](int32_t off) {
+        Emit({0x48, 0xB8}); // mov rax, &m_bytes[operand]
+        Emit64(reinterpret_cast<uint64_t>(&m_RAM->m_bytes[op.operand]));
+        Emit({0x8A, 0x10}); // mov dl, [rax]
+        storeDL(off);
+        EmitFlagsNZ(false);
+    };
+    auto transfer = [&](int32_t from, int32_t to) {
+        loadDL(from);
+        storeDL(to);
+        EmitFlagsNZ(false);
+    };
+    auto modify = [&](int32_t off, std::initializer_list<byte_t> code) {
+        loadDL(off);
+        Emit(code);
+        storeDL(off);
+        EmitFlagsNZ(false);
+    };
+    auto compare = [&](int32_t off) {
+        loadDL(off);
+        Emit({0x80, 0xEA, imm});  // sub dl, imm
+        Emit({0x0F, 0x93, 0xC1}); // setnc cl
+        EmitFlagsNZ(true);
+    };
+    auto shiftA = [&](std::initializer_list<byte_t> code, bool carryIn) {
+        if(carryIn)
+        {
+            EmitMem(0x8A, RAX, m_offF); // mov al, F
+            Emit({0xD0, 0xE8});         // shr al, 1
+        }
+        loadDL(m_offA);
+        Emit(code);
+        Emit({0x0F, 0x92, 0xC1}); // setc cl
+        storeDL(m_offA);
+        EmitFlagsNZ(true);
+    };
+
+    switch(op.code)
+    {
+    case 0x18: // CLC
+        andF(static_cast<byte_t>(~CPU::CARRY_FLAG));
+        break;
+    case 0x38: // SEC
+        orF(CPU::CARRY_FLAG);
+        break;
+    case 0xD8: // CLD
+        andF(static_cast<byte_t>(~CPU::DECIMAL_FLAG));
+        break;
+    case 0xF8: // SED
+        orF(CPU::DECIMAL_FLAG);
+        break;
+    case 0xB8: // CLV
+        andF(static_cast<byte_t>(~CPU::OVERFLOW_FLAG));
+        break;
+    case 0x78: // SEI
+        orF(CPU::INTERRUPT_FLAG);
+        break;
+    case 0xEA: // NOP
+        break;
+    case 0xA9: // LDA #
+        loadImm(m_offA);
+        break;
+    case 0xA2: // LDX #
+        loadImm(m_offX);
+        break;
+    case 0xA0: // LDY #
+        loadImm(m_offY);
+        break;
+    case 0xA5: // LDA zp
+        loadZeroPage(m_offA);
+        break;
+    case 0xA6: // LDX zp
+        loadZeroPage(m_offX);
+        break;
+    case 0xA4: // LDY zp
+        loadZeroPage(m_offY);
+        break;
+    case 0xAA: // TAX
+        transfer(m_offA, m_offX);
+        break;
+    case 0xA8: // TAY
+        transfer(m_offA, m_offY);
+        break;
+    case 0x8A: // TXA
+        transfer(m_offX, m_offA);
+        break;
+    case 0x98: // TYA
+        transfer(m_offY, m_offA);
+        break;
+    case 0xBA: // TSX
+        transfer(m_offS, m_offX);
+        break;
+    case 0x9A: // TXS
+        loadDL(m_offX);
+        storeDL(m_offS);
+        break;
+    case 0xE8: // INX
+        modify(m_offX, {0xFE, 0xC2}); // inc dl
+        break;
+    case 0xC8: // INY
+        modify(m_offY, {0xFE, 0xC2});
+        break;
+    case 0xCA: // DEX
+        modify(m_offX, {0xFE, 0xCA}); // dec dl
+        break;
+    case 0x88: // DEY
+        modify(m_offY, {0xFE, 0xCA});
+        break;
+    case 0x29: // AND #
+        modify(m_offA, {0x80, 0xE2, imm}); // and dl, imm
+        break;
+    case 0x09: // ORA #
+        modify(m_offA, {0x80, 0xCA, imm}); // or dl, imm
+        break;
+    case 0x49: // EOR #
+        modify(m_offA, {0x80, 0xF2, imm}); // xor dl, imm
+        break;
+    case 0xC9: // CMP #
+        compare(m_offA);
+        break;
+    case 0xE0: // CPX #
+        compare(m_offX);
+        break;
+    case 0xC0: // CPY #
+        compare(m_offY);
+        break;
+    case 0x0A: // ASL A
+        shiftA({0xD0, 0xE2}, false); // shl dl, 1
+        break;
+    case 0x4A: // LSR A
+        shiftA({0xD0, 0xEA}, false); // shr dl, 1
+        break;
+    case 0x2A: // ROL A
+        shiftA({0xD0, 0xD2}, true); // rcl dl, 1
+        break;
+    case 0x6A: // ROR A
+        shiftA({0xD0, 0xDA}, true); // rcr dl, 1
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+// N and Z from dl, C from cl
+void Jit::EmitFlagsNZ(bool withCarry)
+{
+    EmitMem(0x88, RDX, m_offN); // mov m_nResult, dl
+    EmitMem(0x88, RDX, m_offZ); // mov m_zResult, dl
+    if(withCarry)
+    {
+        EmitMem(0x80, 4, m_offF); // and F, ~C
+        Emit({static_cast<byte_t>(~CPU::CARRY_FLAG)});
+        EmitMem(0x08, RCX, m_offF); // or F, cl
+    }
+}
+
+// both outcomes leave the block with their own cycle count
+void Jit::EmitBranch(const MicroOp& op, unsigned cycles)
+{
+    static const flag_t flags[] = {CPU::NEGATIVE_FLAG, CPU::OVERFLOW_FLAG, CPU::CARRY_FLAG, CPU::ZERO_FLAG};
+
+    const auto next   = static_cast<word_t>(op.pc + op.bytes);
+    const auto target = static_cast<word_t>(next + static_cast<sbyte_t>(op.operand));
+    const bool ifSet  = op.code & 0x20;
+
+    bool jumpIfNonZero = ifSet;
+    switch(op.code >> 6)
+    {
+    case 0:
+        EmitMem(0xF6, 0, m_offN); // test m_nResult, N
+        Emit({CPU::NEGATIVE_FLAG});
+        break;
+    case 3:
+        EmitMem(0x80, 7, m_offZ); // cmp m_zResult, 0
+        Emit({0x00});
+        jumpIfNonZero = !ifSet;
+        break;
+    default:
+        EmitMem(0xF6, 0, m_offF); // test F, flag
+        Emit({flags[op.code >> 6]});
+        break;
+    }
+    const size_t taken = EmitJump32({0x0F, static_cast<byte_t>(jumpIfNonZero ? 0x85 : 0x84)}); // jnz/jz taken
+    EmitSetPC(next);
+    EmitReturn(cycles);
+
+    Patch(taken, m_buffer.size());
+    EmitSetPC(target);
+    EmitReturn(cycles + (next >> 8 != target >> 8 ? 2 : 1));
+}
+
+void Jit::EmitJump(const MicroOp& op, unsigned cycles)
+{
+    EmitSetPC(op.operand);
+    EmitReturn(cycles);
+}
+
+// JIT_CONTINUE (0) in eax falls through to the next instruction
+void Jit::EmitCall(const MicroOp& op)
+{
+#ifdef _WIN32
+    Emit({0x48, 0x89, 0xD9}); // mov rcx, rbx
+    Emit({0xBA});             // mov edx, operand
+#else
+    Emit({0x48, 0x89, 0xDF}); // mov rdi, rbx
+    Emit({0xBE});             // mov esi, operand
+#endif
+    Emit32(op.operand);
+    Emit({0x48, 0xB8}); // mov rax, JitStep<code>
+    Emit64(reinterpret_cast<uint64_t>(m_thunks[op.code]));
+    Emit({0xFF, 0xD0}); // call rax
+    Emit({0x85, 0xC0}); // test eax, eax
+}
+
+void Jit::EmitSetPC(word_t pc)
+{
+    Emit({0x66}); // mov word PC, pc
+    EmitMem(0xC7, 0, m_offPC);
+    Emit({static_cast<byte_t>(pc & 0xFF), static_cast<byte_t>(pc >> 8)});
+}
+
+void Jit::EmitReturn(unsigned cycles)
+{
+    Emit({0xB8}); // mov eax, cycles
+    Emit32(cycles);
+    m_epilogueJumps.push_back(EmitJump32({0xE9})); // jmp epilogue
+}
+
+void Jit::Emit(std::initializer_list<byte_t> bytes)
+{
+    m_buffer.insert(m_buffer.end(), bytes);
+}
+
+void Jit::Emit32(uint32_t val)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        m_buffer.push_back(static_cast<byte_t>(val >> (i * 8)));
+    }
+}
+
+void Jit::Emit64(uint64_t val)
+{
+    Emit32(static_cast<uint32_t>(val));
+    Emit32(static_cast<uint32_t>(val >> 32));
+}
+
+// opcode with a [rbx + disp] operand
+void Jit::EmitMem(byte_t opcode, byte_t reg, int32_t disp)
+{
+    if(disp >= -128 && disp < 128)
+    {
+        Emit({opcode, static_cast<byte_t>(0x43 | (reg << 3)), static_cast<byte_t>(disp)});
+    }
+    else
+    {
+        Emit({opcode, static_cast<byte_t>(0x83 | (reg << 3))});
+        Emit32(static_cast<uint32_t>(disp));
+    }
+}
+
+// returns the position right after the rel32 to patch
+size_t Jit::EmitJump32(std::initializer_list<byte_t> opcode)
+{
+    Emit(opcode);
+    Emit32(0);
+    return m_buffer.size();
+}
+
+void Jit::Patch(size_t jump, size_t target)
+{
+    const auto rel = static_cast<uint32_t>(static_cast<int32_t>(target - jump));
+    for(int i = 0; i < 4; i++)
+    {
+        m_buffer[jump - 4 + i] = static_cast<byte_t>(rel >> (i * 8));
+    }
+}
+
+#else
+
+bool Jit::Compile(Block& /*block*/)
+{
+    return false;
+}
+
+#endif
+} // namespace atre
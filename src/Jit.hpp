@@ -0,0 +1,70 @@
+#pragma once
+
+#include "BlockCache.hpp"
+#include "atre.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ATRE_JIT_X64
+#endif
+
+namespace atre
+{
+class CPU;
+class RAM;
+
+// translates hot blocks to x86-64 code; register-only instructions are
+// emitted inline, everything else calls CPU::JitStep<code> for that opcode
+class Jit
+{
+public:
+    Jit(CPU* cpu, RAM* ram, const CPU::JitThunk* thunks);
+    ~Jit();
+
+    bool Compile(Block& block);
+    bool IsCompiled(const Block& block) const;
+
+    const static unsigned COMPILE_THRESHOLD = 16;
+
+private:
+    const static size_t CODE_SIZE = 4 * 1024 * 1024;
+
+    RAM*                 m_RAM;
+    const CPU::JitThunk* m_thunks; // JitStep<code> of the CPU's bus
+    byte_t*              m_code;
+    size_t               m_used;
+    unsigned             m_epoch;
+    std::vector<byte_t>  m_buffer;
+    std::vector<size_t>  m_epilogueJumps;
+    int32_t              m_offA;
+    int32_t              m_offX;
+    int32_t              m_offY;
+    int32_t              m_offS;
+    int32_t              m_offPC;
+    int32_t              m_offF;
+    int32_t              m_offN;
+    int32_t              m_offZ;
+
+    struct Exit
+    {
+        size_t   jump;
+        unsigned cyclesBefore;
+        unsigned cyclesAfter;
+    };
+
+    void Translate(const Block& block);
+    bool EmitInline(const MicroOp& op);
+    void EmitBranch(const MicroOp& op, unsigned cycles);
+    void EmitJump(const MicroOp& op, unsigned cycles);
+    void EmitCall(const MicroOp& op);
+    void EmitSetPC(word_t pc);
+    void EmitReturn(unsigned cycles);
+    void EmitFlagsNZ(bool withCarry);
+
+    void   Emit(std::initializer_list<byte_t> bytes);
+    void   Emit32(uint32_t val);
+    void   Emit64(uint64_t val);
+    void   EmitMem(byte_t opcode, byte_t reg, int32_t disp);
+    size_t EmitJump32(std::initializer_list<byte_t> opcode);
+    void   Patch(size_t jump, size_t target);
+};
+} // namespace atre
@@ -0,0 +1,1168 @@
+#include "Alu.hpp"
+#include "Lanes.hpp"
+
+using namespace std;
+
+namespace atre
+{
+Lanes::Lanes() :
+    m_A(), m_X(), m_Y(), m_S(), m_F(), m_nResult(), m_zResult(), m_mask(), m_zeroPage(), m_PC(), m_cycles(), m_scalar(), m_halted(),
+    m_breakAddr(NO_BREAK), m_vectorSteps(), m_scalarSteps(), m_RAM(), m_CPU()
+{
+    // like a CPU before its first instruction
+    m_zResult.fill(1);
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_RAM[l] = make_unique<RAM>();
+        m_CPU[l] = make_unique<CPU>(m_RAM[l].get(), BusType::Flat);
+    }
+}
+
+Lanes::~Lanes() {}
+
+void Lanes::Load(const string& fileName, word_t startAddr)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_RAM[l]->Load(fileName, startAddr);
+        for(unsigned addr = 0; addr < 0x100; addr++)
+        {
+            m_zeroPage[addr][l] = m_RAM[l]->DirectGet(static_cast<word_t>(addr));
+        }
+    }
+}
+
+void Lanes::JumpTo(word_t startAddr)
+{
+    m_PC.fill(startAddr);
+    m_halted = 0;
+}
+
+void Lanes::BreakAt(word_t breakAddr)
+{
+    m_breakAddr = breakAddr;
+}
+
+byte_t Lanes::Get(unsigned lane, word_t addr) const
+{
+    return Read(lane, addr);
+}
+
+void Lanes::Set(unsigned lane, word_t addr, byte_t val)
+{
+    Write(lane, addr, val);
+}
+
+Lanes::State Lanes::GetState(unsigned lane) const
+{
+    const byte_t f = GetF()[lane];
+    return {m_PC[lane], m_A[lane], m_X[lane], m_Y[lane], m_S[lane], f};
+}
+
+bool Lanes::Run(uint64_t maxSteps)
+{
+    for(uint64_t i = 0; i < maxSteps && m_halted != ALL_LANES; i++)
+    {
+        Step();
+    }
+    // everything is back in the lanes between runs
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if((m_scalar >> l) & 1)
+        {
+            Fill(l);
+        }
+    }
+    return m_halted == ALL_LANES;
+}
+
+// the lanes at the lowest PC go first, so after a branch the lanes that
+// skipped ahead wait where the paths usually meet again
+void Lanes::Step()
+{
+    uint32_t pc = 0x10000;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        pc = min(pc, ((m_halted >> l) & 1) ? 0x10000u : m_PC[l]);
+    }
+    uint32_t group = 0;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if(m_PC[l] == pc && !((m_halted >> l) & 1))
+        {
+            group |= 1u << l;
+        }
+    }
+
+    unsigned leader = 0;
+    while(!((group >> leader) & 1))
+    {
+        leader++;
+    }
+    if(group == 1u << leader)
+    {
+        StepScalar(leader);
+        return;
+    }
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if(((group & m_scalar) >> l) & 1)
+        {
+            Fill(l);
+        }
+    }
+
+    // each lane has its own copy of the code, lanes where it differs wait
+    const auto   instrAddress = static_cast<word_t>(pc);
+    const byte_t code         = Read(leader, instrAddress);
+    const auto&  opCode       = CPU::s_opCodeMap[code];
+    for(unsigned l = leader + 1; l < LANES; l++)
+    {
+        for(int i = 0; i < max(opCode.bytes, 1) && ((group >> l) & 1); i++)
+        {
+            const auto addr = static_cast<word_t>(instrAddress + i);
+            if(Read(l, addr) != Read(leader, addr))
+            {
+                group &= ~(1u << l);
+            }
+        }
+    }
+    if(group == 1u << leader)
+    {
+        StepScalar(leader);
+        return;
+    }
+
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_mask[l] = ((group >> l) & 1) ? 0xFF : 0;
+    }
+    const LaneOP& op      = s_ops[code];
+    bool          decimal = false;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        decimal |= InGroup(l) && (m_F[l] & CPU::DECIMAL_FLAG);
+    }
+    if(!op.func || (op.decimal && decimal))
+    {
+        for(unsigned l = 0; l < LANES; l++)
+        {
+            if((group >> l) & 1)
+            {
+                StepScalar(l);
+            }
+        }
+        return;
+    }
+
+    word_t operand = 0;
+    if(opCode.bytes == 2)
+    {
+        operand = Read(leader, static_cast<word_t>(instrAddress + 1));
+    }
+    else if(opCode.bytes == 3)
+    {
+        operand = static_cast<word_t>(Read(leader, static_cast<word_t>(instrAddress + 1)) |
+                                      (Read(leader, static_cast<word_t>(instrAddress + 2)) << 8));
+    }
+    StepVector(op, instrAddress, code, operand);
+}
+
+void Lanes::StepVector(const LaneOP& op, word_t pc, byte_t code, word_t operand)
+{
+    const auto& opCode = CPU::s_opCodeMap[code];
+    const auto  next   = static_cast<word_t>(pc + opCode.bytes);
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_PC[l] = InGroup(l) ? next : m_PC[l];
+    }
+    (this->*op.func)(operand);
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_cycles[l] += InGroup(l) ? static_cast<unsigned>(opCode.cycles) : 0;
+    }
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if(InGroup(l))
+        {
+            Halt(l, pc);
+        }
+    }
+    m_vectorSteps++;
+}
+
+void Lanes::StepScalar(unsigned lane)
+{
+    if(!((m_scalar >> lane) & 1))
+    {
+        Spill(lane);
+    }
+    CPU&           cpu          = *m_CPU[lane];
+    const uint64_t start        = cpu.TotalCycles();
+    const word_t   instrAddress = cpu.PC;
+    cpu.Execute();
+    m_cycles[lane] += cpu.TotalCycles() - start;
+    m_PC[lane] = cpu.PC;
+    Halt(lane, instrAddress);
+    m_scalarSteps++;
+}
+
+// moves a lane's registers and zero page to its CPU
+void Lanes::Spill(unsigned lane)
+{
+    CPU& cpu      = *m_CPU[lane];
+    cpu.A         = m_A[lane];
+    cpu.X         = m_X[lane];
+    cpu.Y         = m_Y[lane];
+    cpu.S         = m_S[lane];
+    cpu.PC        = m_PC[lane];
+    cpu.F         = m_F[lane];
+    cpu.m_nResult = m_nResult[lane];
+    cpu.m_zResult = m_zResult[lane];
+    for(unsigned addr = 0; addr < 0x100; addr++)
+    {
+        m_RAM[lane]->DirectSet(static_cast<word_t>(addr), m_zeroPage[addr][lane]);
+    }
+    m_scalar |= 1u << lane;
+}
+
+void Lanes::Fill(unsigned lane)
+{
+    const CPU& cpu  = *m_CPU[lane];
+    m_A[lane]       = cpu.A;
+    m_X[lane]       = cpu.X;
+    m_Y[lane]       = cpu.Y;
+    m_S[lane]       = cpu.S;
+    m_PC[lane]      = cpu.PC;
+    m_F[lane]       = cpu.F;
+    m_nResult[lane] = cpu.m_nResult;
+    m_zResult[lane] = cpu.m_zResult;
+    for(unsigned addr = 0; addr < 0x100; addr++)
+    {
+        m_zeroPage[addr][lane] = m_RAM[lane]->DirectGet(static_cast<word_t>(addr));
+    }
+    m_scalar &= ~(1u << lane);
+}
+
+void Lanes::Halt(unsigned lane, word_t instrAddress)
+{
+    if(m_PC[lane] == instrAddress || m_PC[lane] == m_breakAddr)
+    {
+        m_halted |= 1u << lane;
+    }
+}
+
+// dst = src in the lanes of the group
+void Lanes::Blend(Vec& dst, const Vec& src)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        dst[l] = static_cast<byte_t>((src[l] & m_mask[l]) | (dst[l] & ~m_mask[l]));
+    }
+}
+
+void Lanes::SetNZ(const Vec& result)
+{
+    Blend(m_nResult, result);
+    Blend(m_zResult, result);
+}
+
+void Lanes::SetFlag(flag_t flag)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_F[l] |= flag & m_mask[l];
+    }
+}
+
+void Lanes::ClearFlag(flag_t flag)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_F[l] &= static_cast<byte_t>(~(flag & m_mask[l]));
+    }
+}
+
+// isSet has any bit set where the flag is
+void Lanes::SetFlag(flag_t flag, const Vec& isSet)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const byte_t change = flag & m_mask[l];
+        m_F[l]              = static_cast<byte_t>((m_F[l] & ~change) | (isSet[l] ? change : 0));
+    }
+}
+
+Lanes::Vec Lanes::GetF() const
+{
+    Vec f;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        f[l] = static_cast<byte_t>((m_F[l] & ~(CPU::NEGATIVE_FLAG | CPU::ZERO_FLAG)) | (m_nResult[l] & CPU::NEGATIVE_FLAG) |
+                                   (m_zResult[l] ? 0 : CPU::ZERO_FLAG));
+    }
+    return f;
+}
+
+// the stack page is in each lane's memory
+void Lanes::Push(const Vec& val)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if(InGroup(l))
+        {
+            m_RAM[l]->DirectSet(static_cast<word_t>(0x100 + m_S[l]), val[l]);
+            m_S[l]--;
+        }
+    }
+}
+
+Lanes::Vec Lanes::Pull()
+{
+    Vec val {};
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if(InGroup(l))
+        {
+            m_S[l]++;
+            val[l] = m_RAM[l]->DirectGet(static_cast<word_t>(0x100 + m_S[l]));
+        }
+    }
+    return val;
+}
+
+// like CPU::GetOP, for the modes that index or go through a pointer
+template <AddressingMode adr>
+Lanes::Addresses Lanes::GetAddresses(word_t operand)
+{
+    Addresses addrs;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if constexpr(adr == AddressingMode::ZeroPageX)
+        {
+            addrs[l] = (operand + m_X[l]) & 0xFF;
+        }
+        else if constexpr(adr == AddressingMode::ZeroPageY)
+        {
+            addrs[l] = (operand + m_Y[l]) & 0xFF;
+        }
+        else if constexpr(adr == AddressingMode::AbsoluteX || adr == AddressingMode::AbsoluteXPaged)
+        {
+            addrs[l] = static_cast<word_t>(operand + m_X[l]);
+            if(adr == AddressingMode::AbsoluteXPaged && operand >> 8 != addrs[l] >> 8)
+            {
+                m_cycles[l] += m_mask[l] & 1;
+            }
+        }
+        else if constexpr(adr == AddressingMode::AbsoluteY || adr == AddressingMode::AbsoluteYPaged)
+        {
+            addrs[l] = static_cast<word_t>(operand + m_Y[l]);
+            if(adr == AddressingMode::AbsoluteYPaged && operand >> 8 != addrs[l] >> 8)
+            {
+                m_cycles[l] += m_mask[l] & 1;
+            }
+        }
+        else if constexpr(adr == AddressingMode::IndexedIndirect)
+        {
+            const auto baseAddr = (operand + m_X[l]) & 0xFF;
+            addrs[l]            = static_cast<word_t>(m_zeroPage[baseAddr][l] + (m_zeroPage[(baseAddr + 1) & 0xFF][l] << 8));
+        }
+        else if constexpr(adr == AddressingMode::IndirectIndexed || adr == AddressingMode::IndirectIndexedPaged)
+        {
+            const auto baseAddress = static_cast<word_t>(m_zeroPage[operand][l] + (m_zeroPage[(operand + 1) & 0xFF][l] << 8));
+            addrs[l]               = static_cast<word_t>(baseAddress + m_Y[l]);
+            if(adr == AddressingMode::IndirectIndexedPaged && baseAddress >> 8 != addrs[l] >> 8)
+            {
+                m_cycles[l] += m_mask[l] & 1;
+            }
+        }
+        else
+        {
+            static_assert(adr != adr, "Not supported addressing mode");
+        }
+    }
+    return addrs;
+}
+
+// zero page operands are one vector load, the others read lane by lane
+template <AddressingMode adr>
+Lanes::Vec Lanes::GetOP(word_t operand)
+{
+    Vec op;
+    if constexpr(adr == AddressingMode::Accumulator)
+    {
+        op = m_A;
+    }
+    else if constexpr(adr == AddressingMode::Immediate)
+    {
+        op.fill(static_cast<byte_t>(operand));
+    }
+    else if constexpr(adr == AddressingMode::Absolute || adr == AddressingMode::ZeroPage)
+    {
+        if(operand < 0x100)
+        {
+            op = m_zeroPage[operand];
+        }
+        else
+        {
+            for(unsigned l = 0; l < LANES; l++)
+            {
+                op[l] = m_RAM[l]->DirectGet(operand);
+            }
+        }
+    }
+    else
+    {
+        const Addresses addrs = GetAddresses<adr>(operand);
+        for(unsigned l = 0; l < LANES; l++)
+        {
+            op[l] = Read(l, addrs[l]);
+        }
+    }
+    return op;
+}
+
+template <AddressingMode adr>
+void Lanes::SetOP(word_t operand, const Vec& val)
+{
+    if constexpr(adr == AddressingMode::Accumulator)
+    {
+        Blend(m_A, val);
+    }
+    else if constexpr(adr == AddressingMode::Absolute || adr == AddressingMode::ZeroPage)
+    {
+        if(operand < 0x100)
+        {
+            Blend(m_zeroPage[operand], val);
+        }
+        else
+        {
+            for(unsigned l = 0; l < LANES; l++)
+            {
+                if(InGroup(l))
+                {
+                    m_RAM[l]->DirectSet(operand, val[l]);
+                }
+            }
+        }
+    }
+    else
+    {
+        const Addresses addrs = GetAddresses<adr>(operand);
+        for(unsigned l = 0; l < LANES; l++)
+        {
+            if(InGroup(l))
+            {
+                Write(l, addrs[l], val[l]);
+            }
+        }
+    }
+}
+
+// binary only, decimal mode is left to the CPUs
+void Lanes::ADC(const Vec& op)
+{
+    Vec res;
+    Vec carry;
+    Vec overflow;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const AluResult sum = Alu::Add(m_A[l], op[l], m_F[l] & CPU::CARRY_FLAG);
+        res[l]              = sum.value;
+        carry[l]            = sum.carry;
+        overflow[l]         = sum.overflow;
+    }
+    SetFlag(CPU::CARRY_FLAG, carry);
+    SetNZ(res);
+    SetFlag(CPU::OVERFLOW_FLAG, overflow);
+    Blend(m_A, res);
+}
+
+template <AddressingMode adr>
+void Lanes::opADC(word_t operand)
+{
+    ADC(GetOP<adr>(operand));
+}
+
+template <AddressingMode adr>
+void Lanes::opAND(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       res;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        res[l] = m_A[l] & op[l];
+    }
+    SetNZ(res);
+    Blend(m_A, res);
+}
+
+template <AddressingMode adr>
+void Lanes::opASL(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       res;
+    Vec       carry;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const AluResult shift = Alu::ShiftLeft(op[l], false);
+        res[l]                = shift.value;
+        carry[l]              = shift.carry;
+    }
+    SetFlag(CPU::CARRY_FLAG, carry);
+    SetNZ(res);
+    SetOP<adr>(operand, res);
+}
+
+// PC already points to the next instruction
+template <typename Taken>
+void Lanes::Branch(word_t operand, Taken taken)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if(InGroup(l) && taken(l))
+        {
+            const auto target = static_cast<word_t>(m_PC[l] + static_cast<sbyte_t>(operand));
+            m_cycles[l] += (m_PC[l] >> 8 != target >> 8) ? 2 : 1;
+            m_PC[l] = target;
+        }
+    }
+}
+
+void Lanes::opBCC(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return !(m_F[l] & CPU::CARRY_FLAG); });
+}
+
+void Lanes::opBCS(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return m_F[l] & CPU::CARRY_FLAG; });
+}
+
+void Lanes::opBEQ(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return !m_zResult[l]; });
+}
+
+void Lanes::opBMI(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return m_nResult[l] & CPU::NEGATIVE_FLAG; });
+}
+
+void Lanes::opBNE(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return m_zResult[l]; });
+}
+
+void Lanes::opBPL(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return !(m_nResult[l] & CPU::NEGATIVE_FLAG); });
+}
+
+void Lanes::opBVC(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return !(m_F[l] & CPU::OVERFLOW_FLAG); });
+}
+
+void Lanes::opBVS(word_t operand)
+{
+    Branch(operand, [this](unsigned l) { return m_F[l] & CPU::OVERFLOW_FLAG; });
+}
+
+template <AddressingMode adr>
+void Lanes::opBIT(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       overflow;
+    Vec       res;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        overflow[l] = op[l] & 0b01000000;
+        res[l]      = m_A[l] & op[l];
+    }
+    SetFlag(CPU::OVERFLOW_FLAG, overflow);
+    Blend(m_nResult, op);
+    Blend(m_zResult, res);
+}
+
+void Lanes::opCLC(word_t /*operand*/)
+{
+    ClearFlag(CPU::CARRY_FLAG);
+}
+
+void Lanes::opCLD(word_t /*operand*/)
+{
+    ClearFlag(CPU::DECIMAL_FLAG);
+}
+
+void Lanes::opCLI(word_t /*operand*/)
+{
+    ClearFlag(CPU::INTERRUPT_FLAG);
+}
+
+void Lanes::opCLV(word_t /*operand*/)
+{
+    ClearFlag(CPU::OVERFLOW_FLAG);
+}
+
+void Lanes::Compare(const Vec& r, const Vec& op)
+{
+    Vec res;
+    Vec carry;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const AluResult diff = Alu::Compare(r[l], op[l]);
+        res[l]               = diff.value;
+        carry[l]             = diff.carry;
+    }
+    SetNZ(res);
+    SetFlag(CPU::CARRY_FLAG, carry);
+}
+
+template <AddressingMode adr>
+void Lanes::opCMP(word_t operand)
+{
+    Compare(m_A, GetOP<adr>(operand));
+}
+
+template <AddressingMode adr>
+void Lanes::opCPX(word_t operand)
+{
+    Compare(m_X, GetOP<adr>(operand));
+}
+
+template <AddressingMode adr>
+void Lanes::opCPY(word_t operand)
+{
+    Compare(m_Y, GetOP<adr>(operand));
+}
+
+template <AddressingMode adr>
+void Lanes::opDEC(word_t operand)
+{
+    Vec res = GetOP<adr>(operand);
+    for(auto& r : res)
+    {
+        r--;
+    }
+    SetNZ(res);
+    SetOP<adr>(operand, res);
+}
+
+void Lanes::opDEX(word_t /*operand*/)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_X[l] = static_cast<byte_t>(m_X[l] - (m_mask[l] & 1));
+    }
+    SetNZ(m_X);
+}
+
+void Lanes::opDEY(word_t /*operand*/)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_Y[l] = static_cast<byte_t>(m_Y[l] - (m_mask[l] & 1));
+    }
+    SetNZ(m_Y);
+}
+
+template <AddressingMode adr>
+void Lanes::opINC(word_t operand)
+{
+    Vec res = GetOP<adr>(operand);
+    for(auto& r : res)
+    {
+        r++;
+    }
+    SetNZ(res);
+    SetOP<adr>(operand, res);
+}
+
+void Lanes::opINX(word_t /*operand*/)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_X[l] = static_cast<byte_t>(m_X[l] + (m_mask[l] & 1));
+    }
+    SetNZ(m_X);
+}
+
+void Lanes::opINY(word_t /*operand*/)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        m_Y[l] = static_cast<byte_t>(m_Y[l] + (m_mask[l] & 1));
+    }
+    SetNZ(m_Y);
+}
+
+template <AddressingMode adr>
+void Lanes::opEOR(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       res;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        res[l] = m_A[l] ^ op[l];
+    }
+    SetNZ(res);
+    Blend(m_A, res);
+}
+
+template <AddressingMode adr>
+void Lanes::opJMP(word_t operand)
+{
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        if(!InGroup(l))
+        {
+            continue;
+        }
+        if constexpr(adr == AddressingMode::Absolute)
+        {
+            m_PC[l] = operand;
+        }
+        else
+        {
+            static_assert(adr == AddressingMode::Indirect, "Not supported addressing mode");
+            m_PC[l] = static_cast<word_t>(Read(l, operand) + (Read(l, static_cast<word_t>(operand + 1)) << 8));
+        }
+    }
+}
+
+void Lanes::opJSR(word_t operand)
+{
+    Vec hi;
+    Vec lo;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const auto retAddress = static_cast<word_t>(m_PC[l] - 1); // next instruction - 1
+        hi[l]                 = static_cast<byte_t>(retAddress >> 8);
+        lo[l]                 = static_cast<byte_t>(retAddress);
+        m_PC[l]               = InGroup(l) ? operand : m_PC[l];
+    }
+    Push(hi);
+    Push(lo);
+}
+
+void Lanes::opRTS(word_t /*operand*/)
+{
+    const Vec lo = Pull();
+    const Vec hi = Pull();
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        // we pushed next instruction - 1
+        m_PC[l] = InGroup(l) ? static_cast<word_t>(lo[l] + (hi[l] << 8) + 1) : m_PC[l];
+    }
+}
+
+template <AddressingMode adr>
+void Lanes::opLDA(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Blend(m_A, op);
+    SetNZ(op);
+}
+
+template <AddressingMode adr>
+void Lanes::opLDX(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Blend(m_X, op);
+    SetNZ(op);
+}
+
+template <AddressingMode adr>
+void Lanes::opLDY(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Blend(m_Y, op);
+    SetNZ(op);
+}
+
+template <AddressingMode adr>
+void Lanes::opLSR(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       res;
+    Vec       carry;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const AluResult shift = Alu::ShiftRight(op[l], false);
+        res[l]                = shift.value;
+        carry[l]              = shift.carry;
+    }
+    SetFlag(CPU::CARRY_FLAG, carry);
+    SetNZ(res);
+    SetOP<adr>(operand, res);
+}
+
+void Lanes::opNOP(word_t /*operand*/) {}
+
+template <AddressingMode adr>
+void Lanes::opORA(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       res;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        res[l] = m_A[l] | op[l];
+    }
+    SetNZ(res);
+    Blend(m_A, res);
+}
+
+void Lanes::opPHA(word_t /*operand*/)
+{
+    Push(m_A);
+}
+
+void Lanes::opPHP(word_t /*operand*/)
+{
+    Vec f = GetF();
+    for(auto& v : f)
+    {
+        v |= CPU::BREAK_FLAG;
+    }
+    Push(f);
+}
+
+void Lanes::opPLA(word_t /*operand*/)
+{
+    const Vec val = Pull();
+    Blend(m_A, val);
+    SetNZ(val);
+}
+
+void Lanes::opPLP(word_t /*operand*/)
+{
+    const Vec f = Pull();
+    Vec       zResult;
+    Vec       flags;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        zResult[l] = (f[l] & CPU::ZERO_FLAG) ? 0 : 1;
+        flags[l]   = static_cast<byte_t>((f[l] & ~CPU::BREAK_FLAG) | CPU::IGNORED_FLAG);
+    }
+    Blend(m_F, flags);
+    Blend(m_nResult, f);
+    Blend(m_zResult, zResult);
+}
+
+template <AddressingMode adr>
+void Lanes::opROL(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       res;
+    Vec       carry;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const AluResult shift = Alu::ShiftLeft(op[l], m_F[l] & CPU::CARRY_FLAG);
+        res[l]                = shift.value;
+        carry[l]              = shift.carry;
+    }
+    SetFlag(CPU::CARRY_FLAG, carry);
+    SetNZ(res);
+    SetOP<adr>(operand, res);
+}
+
+template <AddressingMode adr>
+void Lanes::opROR(word_t operand)
+{
+    const Vec op = GetOP<adr>(operand);
+    Vec       res;
+    Vec       carry;
+    for(unsigned l = 0; l < LANES; l++)
+    {
+        const AluResult shift = Alu::ShiftRight(op[l], m_F[l] & CPU::CARRY_FLAG);
+        res[l]                = shift.value;
+        carry[l]              = shift.carry;
+    }
+    SetFlag(CPU::CARRY_FLAG, carry);
+    SetNZ(res);
+    SetOP<adr>(operand, res);
+}
+
+template <AddressingMode adr>
+void Lanes::opSBC(word_t operand)
+{
+    Vec op = GetOP<adr>(operand);
+    for(auto& v : op)
+    {
+        v ^= 0xFF;
+    }
+    ADC(op);
+}
+
+void Lanes::opSEC(word_t /*operand*/)
+{
+    SetFlag(CPU::CARRY_FLAG);
+}
+
+void Lanes::opSED(word_t /*operand*/)
+{
+    SetFlag(CPU::DECIMAL_FLAG);
+}
+
+void Lanes::opSEI(word_t /*operand*/)
+{
+    SetFlag(CPU::INTERRUPT_FLAG);
+}
+
+template <AddressingMode adr>
+void Lanes::opSTA(word_t operand)
+{
+    SetOP<adr>(operand, m_A);
+}
+
+template <AddressingMode adr>
+void Lanes::opSTX(word_t operand)
+{
+    SetOP<adr>(operand, m_X);
+}
+
+template <AddressingMode adr>
+void Lanes::opSTY(word_t operand)
+{
+    SetOP<adr>(operand, m_Y);
+}
+
+void Lanes::opTAX(word_t /*operand*/)
+{
+    Blend(m_X, m_A);
+    SetNZ(m_A);
+}
+
+void Lanes::opTAY(word_t /*operand*/)
+{
+    Blend(m_Y, m_A);
+    SetNZ(m_A);
+}
+
+void Lanes::opTSX(word_t /*operand*/)
+{
+    Blend(m_X, m_S);
+    SetNZ(m_S);
+}
+
+void Lanes::opTXA(word_t /*operand*/)
+{
+    Blend(m_A, m_X);
+    SetNZ(m_X);
+}
+
+void Lanes::opTXS(word_t /*operand*/)
+{
+    Blend(m_S, m_X);
+}
+
+void Lanes::opTYA(word_t /*operand*/)
+{
+    Blend(m_A, m_Y);
+    SetNZ(m_Y);
+}
+
+// the instructions of CPU::InitializeOPCodes but BRK and RTI
+constexpr array<Lanes::LaneOP, 256> Lanes::InitializeOPs()
+{
+    array<LaneOP, 256> ops {};
+
+    // ADC
+    ops[0x69] = {&atre::Lanes::opADC<AddressingMode::Immediate>, true};
+    ops[0x65] = {&atre::Lanes::opADC<AddressingMode::ZeroPage>, true};
+    ops[0x75] = {&atre::Lanes::opADC<AddressingMode::ZeroPageX>, true};
+    ops[0x6D] = {&atre::Lanes::opADC<AddressingMode::Absolute>, true};
+    ops[0x7D] = {&atre::Lanes::opADC<AddressingMode::AbsoluteXPaged>, true};
+    ops[0x79] = {&atre::Lanes::opADC<AddressingMode::AbsoluteYPaged>, true};
+    ops[0x61] = {&atre::Lanes::opADC<AddressingMode::IndexedIndirect>, true};
+    ops[0x71] = {&atre::Lanes::opADC<AddressingMode::IndirectIndexedPaged>, true};
+
+    // AND
+    ops[0x29] = {&atre::Lanes::opAND<AddressingMode::Immediate>, false};
+    ops[0x25] = {&atre::Lanes::opAND<AddressingMode::ZeroPage>, false};
+    ops[0x35] = {&atre::Lanes::opAND<AddressingMode::ZeroPageX>, false};
+    ops[0x2D] = {&atre::Lanes::opAND<AddressingMode::Absolute>, false};
+    ops[0x3D] = {&atre::Lanes::opAND<AddressingMode::AbsoluteXPaged>, false};
+    ops[0x39] = {&atre::Lanes::opAND<AddressingMode::AbsoluteYPaged>, false};
+    ops[0x21] = {&atre::Lanes::opAND<AddressingMode::IndexedIndirect>, false};
+    ops[0x31] = {&atre::Lanes::opAND<AddressingMode::IndirectIndexedPaged>, false};
+
+    // ASL
+    ops[0x0A] = {&atre::Lanes::opASL<AddressingMode::Accumulator>, false};
+    ops[0x06] = {&atre::Lanes::opASL<AddressingMode::ZeroPage>, false};
+    ops[0x16] = {&atre::Lanes::opASL<AddressingMode::ZeroPageX>, false};
+    ops[0x0E] = {&atre::Lanes::opASL<AddressingMode::Absolute>, false};
+    ops[0x1E] = {&atre::Lanes::opASL<AddressingMode::AbsoluteX>, false};
+
+    // branching
+    ops[0x90] = {&atre::Lanes::opBCC, false};
+    ops[0xB0] = {&atre::Lanes::opBCS, false};
+    ops[0xF0] = {&atre::Lanes::opBEQ, false};
+    ops[0x30] = {&atre::Lanes::opBMI, false};
+    ops[0xD0] = {&atre::Lanes::opBNE, false};
+    ops[0x10] = {&atre::Lanes::opBPL, false};
+    ops[0x50] = {&atre::Lanes::opBVC, false};
+    ops[0x70] = {&atre::Lanes::opBVS, false};
+
+    // BIT
+    ops[0x24] = {&atre::Lanes::opBIT<AddressingMode::ZeroPage>, false};
+    ops[0x2C] = {&atre::Lanes::opBIT<AddressingMode::Absolute>, false};
+
+    // clear flags
+    ops[0x18] = {&atre::Lanes::opCLC, false};
+    ops[0xD8] = {&atre::Lanes::opCLD, false};
+    ops[0x58] = {&atre::Lanes::opCLI, false};
+    ops[0xB8] = {&atre::Lanes::opCLV, false};
+
+    // comparisons
+    ops[0xC9] = {&atre::Lanes::opCMP<AddressingMode::Immediate>, false};
+    ops[0xC5] = {&atre::Lanes::opCMP<AddressingMode::ZeroPage>, false};
+    ops[0xD5] = {&atre::Lanes::opCMP<AddressingMode::ZeroPageX>, false};
+    ops[0xCD] = {&atre::Lanes::opCMP<AddressingMode::Absolute>, false};
+    ops[0xDD] = {&atre::Lanes::opCMP<AddressingMode::AbsoluteXPaged>, false};
+    ops[0xD9] = {&atre::Lanes::opCMP<AddressingMode::AbsoluteYPaged>, false};
+    ops[0xC1] = {&atre::Lanes::opCMP<AddressingMode::IndexedIndirect>, false};
+    ops[0xD1] = {&atre::Lanes::opCMP<AddressingMode::IndirectIndexedPaged>, false};
+    ops[0xE0] = {&atre::Lanes::opCPX<AddressingMode::Immediate>, false};
+    ops[0xE4] = {&atre::Lanes::opCPX<AddressingMode::ZeroPage>, false};
+    ops[0xEC] = {&atre::Lanes::opCPX<AddressingMode::Absolute>, false};
+    ops[0xC0] = {&atre::Lanes::opCPY<AddressingMode::Immediate>, false};
+    ops[0xC4] = {&atre::Lanes::opCPY<AddressingMode::ZeroPage>, false};
+    ops[0xCC] = {&atre::Lanes::opCPY<AddressingMode::Absolute>, false};
+
+    // increment/decrement
+    ops[0xE6] = {&atre::Lanes::opINC<AddressingMode::ZeroPage>, false};
+    ops[0xF6] = {&atre::Lanes::opINC<AddressingMode::ZeroPageX>, false};
+    ops[0xEE] = {&atre::Lanes::opINC<AddressingMode::Absolute>, false};
+    ops[0xFE] = {&atre::Lanes::opINC<AddressingMode::AbsoluteX>, false};
+    ops[0xE8] = {&atre::Lanes::opINX, false};
+    ops[0xC8] = {&atre::Lanes::opINY, false};
+    ops[0xC6] = {&atre::Lanes::opDEC<AddressingMode::ZeroPage>, false};
+    ops[0xD6] = {&atre::Lanes::opDEC<AddressingMode::ZeroPageX>, false};
+    ops[0xCE] = {&atre::Lanes::opDEC<AddressingMode::Absolute>, false};
+    ops[0xDE] = {&atre::Lanes::opDEC<AddressingMode::AbsoluteX>, false};
+    ops[0xCA] = {&atre::Lanes::opDEX, false};
+    ops[0x88] = {&atre::Lanes::opDEY, false};
+
+    // EOR
+    ops[0x49] = {&atre::Lanes::opEOR<AddressingMode::Immediate>, false};
+    ops[0x45] = {&atre::Lanes::opEOR<AddressingMode::ZeroPage>, false};
+    ops[0x55] = {&atre::Lanes::opEOR<AddressingMode::ZeroPageX>, false};
+    ops[0x4D] = {&atre::Lanes::opEOR<AddressingMode::Absolute>, false};
+    ops[0x5D] = {&atre::Lanes::opEOR<AddressingMode::AbsoluteXPaged>, false};
+    ops[0x59] = {&atre::Lanes::opEOR<AddressingMode::AbsoluteYPaged>, false};
+    ops[0x41] = {&atre::Lanes::opEOR<AddressingMode::IndexedIndirect>, false};
+    ops[0x51] = {&atre::Lanes::opEOR<AddressingMode::IndirectIndexedPaged>, false};
+
+    // JMP
+    ops[0x4C] = {&atre::Lanes::opJMP<AddressingMode::Absolute>, false};
+    ops[0x6C] = {&atre::Lanes::opJMP<AddressingMode::Indirect>, false};
+
+    // subroutine
+    ops[0x20] = {&atre::Lanes::opJSR, false};
+    ops[0x60] = {&atre::Lanes::opRTS, false};
+
+    // load
+    ops[0xA9] = {&atre::Lanes::opLDA<AddressingMode::Immediate>, false};
+    ops[0xA5] = {&atre::Lanes::opLDA<AddressingMode::ZeroPage>, false};
+    ops[0xB5] = {&atre::Lanes::opLDA<AddressingMode::ZeroPageX>, false};
+    ops[0xAD] = {&atre::Lanes::opLDA<AddressingMode::Absolute>, false};
+    ops[0xBD] = {&atre::Lanes::opLDA<AddressingMode::AbsoluteXPaged>, false};
+    ops[0xB9] = {&atre::Lanes::opLDA<AddressingMode::AbsoluteYPaged>, false};
+    ops[0xA1] = {&atre::Lanes::opLDA<AddressingMode::IndexedIndirect>, false};
+    ops[0xB1] = {&atre::Lanes::opLDA<AddressingMode::IndirectIndexedPaged>, false};
+    ops[0xA2] = {&atre::Lanes::opLDX<AddressingMode::Immediate>, false};
+    ops[0xA6] = {&atre::Lanes::opLDX<AddressingMode::ZeroPage>, false};
+    ops[0xB6] = {&atre::Lanes::opLDX<AddressingMode::ZeroPageY>, false};
+    ops[0xAE] = {&atre::Lanes::opLDX<AddressingMode::Absolute>, false};
+    ops[0xBE] = {&atre::Lanes::opLDX<AddressingMode::AbsoluteYPaged>, false};
+    ops[0xA0] = {&atre::Lanes::opLDY<AddressingMode::Immediate>, false};
+    ops[0xA4] = {&atre::Lanes::opLDY<AddressingMode::ZeroPage>, false};
+    ops[0xB4] = {&atre::Lanes::opLDY<AddressingMode::ZeroPageX>, false};
+    ops[0xAC] = {&atre::Lanes::opLDY<AddressingMode::Absolute>, false};
+    ops[0xBC] = {&atre::Lanes::opLDY<AddressingMode::AbsoluteXPaged>, false};
+
+    // LSR
+    ops[0x4A] = {&atre::Lanes::opLSR<AddressingMode::Accumulator>, false};
+    ops[0x46] = {&atre::Lanes::opLSR<AddressingMode::ZeroPage>, false};
+    ops[0x56] = {&atre::Lanes::opLSR<AddressingMode::ZeroPageX>, false};
+    ops[0x4E] = {&atre::Lanes::opLSR<AddressingMode::Absolute>, false};
+    ops[0x5E] = {&atre::Lanes::opLSR<AddressingMode::AbsoluteX>, false};
+
+    // NOP
+    ops[0xEA] = {&atre::Lanes::opNOP, false};
+
+    // ORA
+    ops[0x09] = {&atre::Lanes::opORA<AddressingMode::Immediate>, false};
+    ops[0x05] = {&atre::Lanes::opORA<AddressingMode::ZeroPage>, false};
+    ops[0x15] = {&atre::Lanes::opORA<AddressingMode::ZeroPageX>, false};
+    ops[0x0D] = {&atre::Lanes::opORA<AddressingMode::Absolute>, false};
+    ops[0x1D] = {&atre::Lanes::opORA<AddressingMode::AbsoluteXPaged>, false};
+    ops[0x19] = {&atre::Lanes::opORA<AddressingMode::AbsoluteYPaged>, false};
+    ops[0x01] = {&atre::Lanes::opORA<AddressingMode::IndexedIndirect>, false};
+    ops[0x11] = {&atre::Lanes::opORA<AddressingMode::IndirectIndexedPaged>, false};
+
+    // push/pull
+    ops[0x48] = {&atre::Lanes::opPHA, false};
+    ops[0x08] = {&atre::Lanes::opPHP, false};
+    ops[0x68] = {&atre::Lanes::opPLA, false};
+    ops[0x28] = {&atre::Lanes::opPLP, false};
+
+    // ROL
+    ops[0x2A] = {&atre::Lanes::opROL<AddressingMode::Accumulator>, false};
+    ops[0x26] = {&atre::Lanes::opROL<AddressingMode::ZeroPage>, false};
+    ops[0x36] = {&atre::Lanes::opROL<AddressingMode::ZeroPageX>, false};
+    ops[0x2E] = {&atre::Lanes::opROL<AddressingMode::Absolute>, false};
+    ops[0x3E] = {&atre::Lanes::opROL<AddressingMode::AbsoluteX>, false};
+
+    // ROR
+    ops[0x6A] = {&atre::Lanes::opROR<AddressingMode::Accumulator>, false};
+    ops[0x66] = {&atre::Lanes::opROR<AddressingMode::ZeroPage>, false};
+    ops[0x76] = {&atre::Lanes::opROR<AddressingMode::ZeroPageX>, false};
+    ops[0x6E] = {&atre::Lanes::opROR<AddressingMode::Absolute>, false};
+    ops[0x7E] = {&atre::Lanes::opROR<AddressingMode::AbsoluteX>, false};
+
+    // SBC
+    ops[0xE9] = {&atre::Lanes::opSBC<AddressingMode::Immediate>, true};
+    ops[0xE5] = {&atre::Lanes::opSBC<AddressingMode::ZeroPage>, true};
+    ops[0xF5] = {&atre::Lanes::opSBC<AddressingMode::ZeroPageX>, true};
+    ops[0xED] = {&atre::Lanes::opSBC<AddressingMode::Absolute>, true};
+    ops[0xFD] = {&atre::Lanes::opSBC<AddressingMode::AbsoluteXPaged>, true};
+    ops[0xF9] = {&atre::Lanes::opSBC<AddressingMode::AbsoluteYPaged>, true};
+    ops[0xE1] = {&atre::Lanes::opSBC<AddressingMode::IndexedIndirect>, true};
+    ops[0xF1] = {&atre::Lanes::opSBC<AddressingMode::IndirectIndexedPaged>, true};
+
+    // set flags
+    ops[0x38] = {&atre::Lanes::opSEC, false};
+    ops[0xF8] = {&atre::Lanes::opSED, false};
+    ops[0x78] = {&atre::Lanes::opSEI, false};
+
+    // store
+    ops[0x85] = {&atre::Lanes::opSTA<AddressingMode::ZeroPage>, false};
+    ops[0x95] = {&atre::Lanes::opSTA<AddressingMode::ZeroPageX>, false};
+    ops[0x8D] = {&atre::Lanes::opSTA<AddressingMode::Absolute>, false};
+    ops[0x9D] = {&atre::Lanes::opSTA<AddressingMode::AbsoluteX>, false};
+    ops[0x99] = {&atre::Lanes::opSTA<AddressingMode::AbsoluteY>, false};
+    ops[0x81] = {&atre::Lanes::opSTA<AddressingMode::IndexedIndirect>, false};
+    ops[0x91] = {&atre::Lanes::opSTA<AddressingMode::IndirectIndexed>, false};
+    ops[0x86] = {&atre::Lanes::opSTX<AddressingMode::ZeroPage>, false};
+    ops[0x96] = {&atre::Lanes::opSTX<AddressingMode::ZeroPageY>, false};
+    ops[0x8E] = {&atre::Lanes::opSTX<AddressingMode::Absolute>, false};
+    ops[0x84] = {&atre::Lanes::opSTY<AddressingMode::ZeroPage>, false};
+    ops[0x94] = {&atre::Lanes::opSTY<AddressingMode::ZeroPageX>, false};
+    ops[0x8C] = {&atre::Lanes::opSTY<AddressingMode::Absolute>, false};
+
+    // transfer
+    ops[0xAA] = {&atre::Lanes::opTAX, false};
+    ops[0xA8] = {&atre::Lanes::opTAY, false};
+    ops[0xBA] = {&atre::Lanes::opTSX, false};
+    ops[0x8A] = {&atre::Lanes::opTXA, false};
+    ops[0x9A] = {&atre::Lanes::opTXS, false};
+    ops[0x98] = {&atre::Lanes::opTYA, false};
+
+    return ops;
+}
+
+constexpr array<Lanes::LaneOP, 256> Lanes::s_ops = Lanes::InitializeOPs();
+} // namespace atre
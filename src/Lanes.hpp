@@ -0,0 +1,233 @@
+#pragma once
+
+#include "CPU.hpp"
+#include "RAM.hpp"
+#include "atre.hpp"
+
+namespace atre
+{
+// LANES copies of one program for fuzzing, sweeps and rollouts, each with
+// its own flat 64 kB memory like the test ROMs use. Registers and zero
+// page are stored with one byte per lane so lanes at the same instruction
+// run it together in loops the compiler vectorizes; a lane alone at its
+// PC, and BRK, RTI and decimal arithmetic, run in the lane's own CPU
+class Lanes
+{
+public:
+    // a register of every lane fills one AVX2 register
+    const static unsigned LANES = 32;
+
+    struct State
+    {
+        word_t pc;
+        byte_t a;
+        byte_t x;
+        byte_t y;
+        byte_t s;
+        byte_t f;
+    };
+
+    Lanes();
+    ~Lanes();
+
+    // into every lane
+    void Load(const std::string& fileName, word_t startAddr);
+    void JumpTo(word_t startAddr);
+    // lanes reaching it halt like on a trap
+    void BreakAt(word_t breakAddr);
+
+    byte_t Get(unsigned lane, word_t addr) const;
+    void   Set(unsigned lane, word_t addr, byte_t val);
+    State  GetState(unsigned lane) const;
+
+    // runs until every lane reached the break address or jumped to itself,
+    // false when maxSteps instructions were run first
+    bool Run(uint64_t maxSteps);
+
+    inline bool IsHalted(unsigned lane) const
+    {
+        return (m_halted >> lane) & 1;
+    }
+
+    inline uint64_t Cycles(unsigned lane) const
+    {
+        return m_cycles[lane];
+    }
+
+    // instructions run for a group of lanes at once and for single lanes
+    inline uint64_t VectorSteps() const
+    {
+        return m_vectorSteps;
+    }
+
+    inline uint64_t ScalarSteps() const
+    {
+        return m_scalarSteps;
+    }
+
+private:
+    typedef std::array<byte_t, LANES> Vec;
+    typedef std::array<word_t, LANES> Addresses;
+    typedef void (atre::Lanes::*OPFunction)(word_t);
+
+    const static uint32_t ALL_LANES = 0xFFFFFFFF;
+    const static uint32_t NO_BREAK  = 0x10000;
+
+    struct LaneOP
+    {
+        OPFunction func;
+        bool       decimal; // ADC and SBC, left to the CPUs while D is set
+    };
+
+    static const std::array<LaneOP, 256> s_ops;
+
+    // m_mask has 0xFF in the lanes of the running group
+    alignas(32) Vec                         m_A;
+    alignas(32) Vec                         m_X;
+    alignas(32) Vec                         m_Y;
+    alignas(32) Vec                         m_S;
+    alignas(32) Vec                         m_F;
+    alignas(32) Vec                         m_nResult;
+    alignas(32) Vec                         m_zResult;
+    alignas(32) Vec                         m_mask;
+    alignas(32) std::array<Vec, 256>        m_zeroPage;
+    std::array<word_t, LANES>               m_PC;
+    std::array<uint64_t, LANES>             m_cycles;
+    uint32_t                                m_scalar; // lanes whose state is in their CPU
+    uint32_t                                m_halted;
+    uint32_t                                m_breakAddr;
+    uint64_t                                m_vectorSteps;
+    uint64_t                                m_scalarSteps;
+    std::array<std::unique_ptr<RAM>, LANES> m_RAM;
+    std::array<std::unique_ptr<CPU>, LANES> m_CPU;
+
+    static constexpr std::array<LaneOP, 256> InitializeOPs();
+
+    void Step();
+    void StepVector(const LaneOP& op, word_t pc, byte_t code, word_t operand);
+    void StepScalar(unsigned lane);
+    void Spill(unsigned lane);
+    void Fill(unsigned lane);
+    void Halt(unsigned lane, word_t instrAddress);
+
+    inline byte_t Read(unsigned lane, word_t addr) const
+    {
+        return addr < 0x100 ? m_zeroPage[addr][lane] : m_RAM[lane]->DirectGet(addr);
+    }
+
+    inline void Write(unsigned lane, word_t addr, byte_t val)
+    {
+        if(addr < 0x100)
+        {
+            m_zeroPage[addr][lane] = val;
+        }
+        else
+        {
+            m_RAM[lane]->DirectSet(addr, val);
+        }
+    }
+
+    inline bool InGroup(unsigned lane) const
+    {
+        return m_mask[lane];
+    }
+
+    void Blend(Vec& dst, const Vec& src);
+    void SetNZ(const Vec& result);
+    void SetFlag(flag_t flag);
+    void ClearFlag(flag_t flag);
+    void SetFlag(flag_t flag, const Vec& isSet);
+    Vec  GetF() const;
+    void Push(const Vec& val);
+    Vec  Pull();
+
+    template <AddressingMode adr>
+    Addresses GetAddresses(word_t operand);
+    template <AddressingMode adr>
+    Vec GetOP(word_t operand);
+    template <AddressingMode adr>
+    void SetOP(word_t operand, const Vec& val);
+
+    void ADC(const Vec& op);
+    void Compare(const Vec& r, const Vec& op);
+    template <typename Taken>
+    void Branch(word_t operand, Taken taken);
+
+    template <AddressingMode adr>
+    void opADC(word_t operand);
+    template <AddressingMode adr>
+    void opAND(word_t operand);
+    template <AddressingMode adr>
+    void opASL(word_t operand);
+    void opBCC(word_t operand);
+    void opBCS(word_t operand);
+    void opBEQ(word_t operand);
+    void opBMI(word_t operand);
+    void opBNE(word_t operand);
+    void opBPL(word_t operand);
+    void opBVC(word_t operand);
+    void opBVS(word_t operand);
+    template <AddressingMode adr>
+    void opBIT(word_t operand);
+    void opCLC(word_t operand);
+    void opCLD(word_t operand);
+    void opCLI(word_t operand);
+    void opCLV(word_t operand);
+    template <AddressingMode adr>
+    void opCMP(word_t operand);
+    template <AddressingMode adr>
+    void opCPX(word_t operand);
+    template <AddressingMode adr>
+    void opCPY(word_t operand);
+    template <AddressingMode adr>
+    void opDEC(word_t operand);
+    void opDEX(word_t operand);
+    void opDEY(word_t operand);
+    template <AddressingMode adr>
+    void opINC(word_t operand);
+    void opINX(word_t operand);
+    void opINY(word_t operand);
+    template <AddressingMode adr>
+    void opEOR(word_t operand);
+    template <AddressingMode adr>
+    void opJMP(word_t operand);
+    void opJSR(word_t operand);
+    void opRTS(word_t operand);
+    template <AddressingMode adr>
+    void opLDA(word_t operand);
+    template <AddressingMode adr>
+    void opLDX(word_t operand);
+    template <AddressingMode adr>
+    void opLDY(word_t operand);
+    template <AddressingMode adr>
+    void opLSR(word_t operand);
+    void opNOP(word_t operand);
+    template <AddressingMode adr>
+    void opORA(word_t operand);
+    void opPHA(word_t operand);
+    void opPHP(word_t operand);
+    void opPLA(word_t operand);
+    void opPLP(word_t operand);
+    template <AddressingMode adr>
+    void opROL(word_t operand);
+    template <AddressingMode adr>
+    void opROR(word_t operand);
+    template <AddressingMode adr>
+    void opSBC(word_t operand);
+    void opSEC(word_t operand);
+    void opSED(word_t operand);
+    void opSEI(word_t operand);
+    template <AddressingMode adr>
+    void opSTA(word_t operand);
+    template <AddressingMode adr>
+    void opSTX(word_t operand);
+    template <AddressingMode adr>
+    void opSTY(word_t operand);
+    void opTAX(word_t operand);
+    void opTAY(word_t operand);
+    void opTSX(word_t operand);
+    void opTXA(word_t operand);
+    void opTXS(word_t operand);
+    void opTYA(word_t operand);
+};
+} // namespace atre
@@ -0,0 +1,465 @@
+#include "MathPack.hpp"
+#include "RAM.hpp"
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+
+using namespace std;
+
+namespace atre
+{
+namespace
+{
+// OS entry points
+const word_t AFP   = 0xD800;
+const word_t FASC  = 0xD8E6;
+const word_t IFP   = 0xD9AA;
+const word_t FPI   = 0xD9D2;
+const word_t FSUB  = 0xDA60;
+const word_t FADD  = 0xDA66;
+const word_t FMUL  = 0xDADB;
+const word_t FDIV  = 0xDB28;
+const word_t EXP   = 0xDDC0;
+const word_t EXP10 = 0xDDCC;
+const word_t LOG   = 0xDECD;
+const word_t LOG10 = 0xDED1;
+
+// registers and buffers
+const word_t FR0    = 0xD4;
+const word_t FR1    = 0xE0;
+const word_t CIX    = 0xF2;
+const word_t INBUFF = 0xF3;
+const word_t LBUFF  = 0x0580;
+
+const uint64_t MANTISSA_LIMIT = 10000000000ull;
+const int      EXPONENT_BIAS  = 64;
+
+// the ROM keeps numbers between 1E-98 and 9.99E+97
+const int MIN_EXPONENT = -49;
+const int MAX_EXPONENT = 48;
+} // namespace
+
+MathPack::MathPack(RAM* ram) : m_RAM(ram) {}
+
+unsigned MathPack::Call(word_t entry, bool& error)
+{
+    auto unary = [this](double (*func)(double)) {
+        Decimal value;
+        return FromDouble(func(ToDouble(Load(FR0))), value) && Store(FR0, value);
+    };
+
+    // cycle counts are typical for the ROM routines with ten digit operands
+    Decimal result;
+    switch(entry)
+    {
+    case AFP:
+        error = !AsciiToFloat();
+        return 2100;
+    case FASC:
+        FloatToAscii();
+        error = false;
+        return 2600;
+    case IFP:
+        IntegerToFloat();
+        error = false;
+        return 1300;
+    case FPI:
+        error = !FloatToInteger();
+        return 1100;
+    case FSUB:
+    {
+        auto subtrahend     = Load(FR1);
+        subtrahend.negative = !subtrahend.negative;
+        error               = !Store(FR0, Add(Load(FR0), subtrahend));
+        return 800;
+    }
+    case FADD:
+        error = !Store(FR0, Add(Load(FR0), Load(FR1)));
+        return 750;
+    case FMUL:
+        error = !Store(FR0, Multiply(Load(FR0), Load(FR1)));
+        return 3000;
+    case FDIV:
+        error = !Divide(Load(FR0), Load(FR1), result) || !Store(FR0, result);
+        return 5200;
+    case EXP:
+        error = !unary([](double x) { return exp(x); });
+        return 26000;
+    case EXP10:
+        error = !unary([](double x) { return pow(10.0, x); });
+        return 24000;
+    case LOG:
+        error = !unary([](double x) { return x > 0 ? log(x) : NAN; });
+        return 30000;
+    case LOG10:
+        error = !unary([](double x) { return x > 0 ? log10(x) : NAN; });
+        return 31000;
+    default:
+        return 0;
+    }
+}
+
+// keeps the first base 100 digit non-zero, dropping digits past the fifth
+void MathPack::Normalize(Decimal& value)
+{
+    if(!value.mantissa)
+    {
+        value.negative = false;
+        value.exponent = 0;
+        return;
+    }
+    while(value.mantissa >= MANTISSA_LIMIT)
+    {
+        value.mantissa /= 100;
+        value.exponent++;
+    }
+    while(value.mantissa < MANTISSA_LIMIT / 100)
+    {
+        value.mantissa *= 100;
+        value.exponent--;
+    }
+}
+
+// the operand with the smaller exponent loses the digits shifted out
+MathPack::Decimal MathPack::Add(Decimal a, Decimal b)
+{
+    if(!b.mantissa)
+    {
+        return a;
+    }
+    if(!a.mantissa)
+    {
+        return b;
+    }
+    if(a.exponent < b.exponent)
+    {
+        swap(a, b);
+    }
+    for(auto shift = a.exponent - b.exponent; shift > 0 && b.mantissa; shift--)
+    {
+        b.mantissa /= 100;
+    }
+
+    if(a.negative == b.negative)
+    {
+        a.mantissa += b.mantissa;
+    }
+    else if(a.mantissa >= b.mantissa)
+    {
+        a.mantissa -= b.mantissa;
+    }
+    else
+    {
+        a.mantissa = b.mantissa - a.mantissa;
+        a.negative = b.negative;
+    }
+    Normalize(a);
+    return a;
+}
+
+MathPack::Decimal MathPack::Multiply(const Decimal& a, const Decimal& b)
+{
+    if(!a.mantissa || !b.mantissa)
+    {
+        return {false, 0, 0};
+    }
+
+    // the 20 digit product in halves, keeping its top 12 digits
+    const uint64_t half = 100000;
+    const uint64_t aHi = a.mantissa / half, aLo = a.mantissa % half;
+    const uint64_t bHi = b.mantissa / half, bLo = b.mantissa % half;
+    const uint64_t low = (aHi * bLo + aLo * bHi) * half + aLo * bLo;
+
+    Decimal product;
+    product.negative = a.negative != b.negative;
+    product.exponent = a.exponent + b.exponent;
+    product.mantissa = aHi * bHi * 100 + low / (MANTISSA_LIMIT / 100);
+    Normalize(product);
+    return product;
+}
+
+bool MathPack::Divide(const Decimal& a, const Decimal& b, Decimal& quotient)
+{
+    if(!b.mantissa)
+    {
+        return false;
+    }
+
+    // long division in base 100 down to one digit past the mantissa
+    uint64_t digits    = a.mantissa / b.mantissa;
+    uint64_t remainder = a.mantissa % b.mantissa;
+    for(auto i = 0; i < 5; i++)
+    {
+        remainder *= 100;
+        digits = digits * 100 + remainder / b.mantissa;
+        remainder %= b.mantissa;
+    }
+
+    quotient.negative = a.negative != b.negative;
+    quotient.exponent = a.exponent - b.exponent - 1;
+    quotient.mantissa = digits;
+    Normalize(quotient);
+    return true;
+}
+
+// [blanks][+|-]digits[.digits][E[+|-]digits], at least one mantissa digit;
+// pos is moved past the number
+bool MathPack::Parse(const string& text, size_t& pos, Decimal& value)
+{
+    auto isDigit = [&text](size_t i) { return i < text.size() && isdigit(static_cast<unsigned char>(text[i])); };
+
+    size_t i = pos;
+    while(i < text.size() && text[i] == ' ')
+    {
+        i++;
+    }
+    value = {false, 0, 0};
+    if(i < text.size() && (text[i] == '+' || text[i] == '-'))
+    {
+        value.negative = text[i++] == '-';
+    }
+
+    // up to 12 significant digits, the value is digits * 10^power
+    uint64_t digits    = 0;
+    int      power     = 0;
+    int      numDigits = 0;
+    bool     hasDigits = false;
+    bool     fraction  = false;
+    for(; isDigit(i) || (i < text.size() && text[i] == '.' && !fraction); i++)
+    {
+        if(text[i] == '.')
+        {
+            fraction = true;
+            continue;
+        }
+        hasDigits = true;
+        if(numDigits < 12)
+        {
+            digits = digits * 10 + (text[i] - '0');
+            numDigits += digits ? 1 : 0;
+            power -= fraction ? 1 : 0;
+        }
+        else if(!fraction)
+        {
+            power++;
+        }
+    }
+    if(!hasDigits)
+    {
+        return false;
+    }
+
+    if(i < text.size() && text[i] == 'E')
+    {
+        size_t exp      = i + 1;
+        bool   negative = false;
+        if(exp < text.size() && (text[exp] == '+' || text[exp] == '-'))
+        {
+            negative = text[exp++] == '-';
+        }
+        if(isDigit(exp))
+        {
+            int exponent = 0;
+            for(; isDigit(exp) && exponent < 1000; exp++)
+            {
+                exponent = exponent * 10 + (text[exp] - '0');
+            }
+            power += negative ? -exponent : exponent;
+            i = exp;
+        }
+    }
+    pos = i;
+
+    if(power % 2)
+    {
+        digits *= 10;
+        power--;
+    }
+    value.mantissa = digits;
+    value.exponent = power / 2 + 4;
+    Normalize(value);
+    return true;
+}
+
+double MathPack::ToDouble(const Decimal& value)
+{
+    const double number = static_cast<double>(value.mantissa) * pow(100.0, value.exponent - 4);
+    return value.negative ? -number : number;
+}
+
+bool MathPack::FromDouble(double number, Decimal& value)
+{
+    if(!isfinite(number))
+    {
+        return false;
+    }
+    ostringstream text;
+    text << scientific << setprecision(11) << number;
+    auto str = text.str();
+    for(auto& c : str)
+    {
+        c = static_cast<char>(toupper(c));
+    }
+    size_t pos = 0;
+    return Parse(str, pos, value);
+}
+
+MathPack::Decimal MathPack::Load(word_t addr)
+{
+    const byte_t exponent = m_RAM->Get(addr);
+
+    Decimal value;
+    value.negative = exponent & 0x80;
+    value.exponent = (exponent & 0x7F) - EXPONENT_BIAS;
+    value.mantissa = 0;
+    for(word_t i = 1; i <= 5; i++)
+    {
+        const byte_t bcd = m_RAM->Get(static_cast<word_t>(addr + i));
+        value.mantissa   = value.mantissa * 100 + (bcd >> 4) * 10 + (bcd & 0x0F);
+    }
+    Normalize(value);
+    return value;
+}
+
+// false on overflow, underflow stores 0
+bool MathPack::Store(word_t addr, Decimal value)
+{
+    Normalize(value);
+    if(value.exponent > MAX_EXPONENT)
+    {
+        return false;
+    }
+    if(!value.mantissa || value.exponent < MIN_EXPONENT)
+    {
+        value = {false, -EXPONENT_BIAS, 0};
+    }
+
+    m_RAM->Set(addr, static_cast<byte_t>((value.negative ? 0x80 : 0) | (value.exponent + EXPONENT_BIAS)));
+    for(word_t i = 5; i >= 1; i--)
+    {
+        const auto digit = static_cast<byte_t>(value.mantissa % 100);
+        m_RAM->Set(static_cast<word_t>(addr + i), static_cast<byte_t>(((digit / 10) << 4) | (digit % 10)));
+        value.mantissa /= 100;
+    }
+    return true;
+}
+
+// text at INBUFF + CIX to FR0, CIX is left past the number
+bool MathPack::AsciiToFloat()
+{
+    const word_t buffer = m_RAM->GetW(INBUFF);
+    const byte_t start  = m_RAM->Get(CIX);
+
+    string text;
+    for(unsigned i = start; i < 256; i++)
+    {
+        text += static_cast<char>(m_RAM->Get(static_cast<word_t>(buffer + i)));
+    }
+
+    size_t  pos = 0;
+    Decimal value;
+    if(!Parse(text, pos, value) || !Store(FR0, value))
+    {
+        return false;
+    }
+    m_RAM->Set(CIX, static_cast<byte_t>(start + pos));
+    return true;
+}
+
+// FR0 to text at LBUFF, pointed to by INBUFF, the last character has bit 7 set
+void MathPack::FloatToAscii()
+{
+    const Decimal value = Load(FR0);
+
+    string text;
+    if(!value.mantissa)
+    {
+        text = "0";
+    }
+    else
+    {
+        ostringstream digits;
+        digits << setw(10) << setfill('0') << value.mantissa;
+        const string all   = digits.str();
+        const int    point = 2 * value.exponent + 2; // digits before the decimal point
+
+        auto trimmed = [](string str) {
+            str.erase(str.find_last_not_of('0') + 1);
+            return str;
+        };
+
+        if(value.negative)
+        {
+            text.push_back('-');
+        }
+        if(value.exponent >= -1 && value.exponent <= 4)
+        {
+            const auto integer  = all.substr(0, point);
+            const auto fraction = trimmed(all.substr(point));
+            const auto first    = integer.find_first_not_of('0');
+            text += first == string::npos ? "0" : integer.substr(first);
+            text += fraction.empty() ? "" : "." + fraction;
+        }
+        else
+        {
+            const auto first    = all.find_first_not_of('0');
+            const auto fraction = trimmed(all.substr(first + 1));
+            const int  exponent = point - static_cast<int>(first) - 1;
+
+            ostringstream scientific;
+            scientific << all[first] << (fraction.empty() ? "" : "." + fraction) << 'E' << (exponent < 0 ? '-' : '+') << setw(2)
+                       << setfill('0') << abs(exponent);
+            text += scientific.str();
+        }
+    }
+
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        const auto c = static_cast<byte_t>(text[i] | (i + 1 == text.size() ? 0x80 : 0));
+        m_RAM->Set(static_cast<word_t>(LBUFF + i), c);
+    }
+    m_RAM->SetW(INBUFF, LBUFF);
+}
+
+// 16-bit integer in FR0 to floating point
+void MathPack::IntegerToFloat()
+{
+    Store(FR0, {false, 4, m_RAM->GetW(FR0)});
+}
+
+// FR0 rounded to a 16-bit integer in FR0, fails for negative or too large numbers
+bool MathPack::FloatToInteger()
+{
+    const Decimal value = Load(FR0);
+    if(value.negative)
+    {
+        return false;
+    }
+
+    // value is mantissa * 100^(exponent - 4)
+    uint64_t integer = value.mantissa;
+    if(value.exponent > 4)
+    {
+        return false;
+    }
+    else if(value.exponent < -1)
+    {
+        integer = 0;
+    }
+    else
+    {
+        uint64_t scale = 1;
+        for(auto i = value.exponent; i < 4; i++)
+        {
+            scale *= 100;
+        }
+        integer = (integer + scale / 2) / scale;
+    }
+    if(integer > 0xFFFF)
+    {
+        return false;
+    }
+    m_RAM->SetW(FR0, static_cast<word_t>(integer));
+    return true;
+}
+} // namespace atre
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+class RAM;
+
+// high-level emulation of the floating point package in the OS ROM; numbers
+// use the ROM format, a sign and excess-64 power of 100 exponent byte and
+// five BCD mantissa bytes, and the arithmetic truncates like the ROM does
+class MathPack
+{
+public:
+    MathPack(RAM* ram);
+
+    // runs the routine at entry natively, returns its estimated cycle count
+    // or 0 when entry isn't a supported entry point
+    unsigned Call(word_t entry, bool& error);
+
+    const static word_t ROM_START = 0xD800;
+    const static word_t ROM_END   = 0xE000;
+
+private:
+    struct Decimal
+    {
+        bool     negative;
+        int      exponent; // of the first base 100 digit
+        uint64_t mantissa; // 10 digits, 5 base 100 digits
+    };
+
+    RAM* m_RAM;
+
+    static void    Normalize(Decimal& value);
+    static Decimal Add(Decimal a, Decimal b);
+    static Decimal Multiply(const Decimal& a, const Decimal& b);
+    static bool    Divide(const Decimal& a, const Decimal& b, Decimal& quotient);
+    static bool    Parse(const std::string& text, size_t& pos, Decimal& value);
+    static double  ToDouble(const Decimal& value);
+    static bool    FromDouble(double number, Decimal& value);
+
+    Decimal Load(word_t addr);
+    bool    Store(word_t addr, Decimal value);
+
+    bool AsciiToFloat();
+    void FloatToAscii();
+    void IntegerToFloat();
+    bool FloatToInteger();
+};
+} // namespace atre
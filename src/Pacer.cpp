@@ -0,0 +1,133 @@
+#include "Pacer.hpp"
+#include <cmath>
+#include <iomanip>
+
+using namespace std;
+
+namespace atre
+{
+Pacer::Pacer() :
+    m_speed(1), m_frameSkip(), m_restart(true), m_paceStart(), m_paceCycles(), m_lastFrame(), m_timed(), m_mutex(), m_frameStarted(),
+    m_frames(), m_shown(), m_paced(), m_timedFrames(), m_sum(), m_squares(), m_min(), m_max(), m_late(), m_catchUp(), m_rebases()
+{}
+
+void Pacer::SetSpeed(unsigned speed)
+{
+    m_speed   = speed;
+    m_restart = true;
+}
+
+void Pacer::SetFrameSkip(unsigned frames)
+{
+    m_frameSkip = frames;
+}
+
+void Pacer::Restart()
+{
+    m_restart = true;
+}
+
+// sleeps until the frame is due; behind by a frame or more it leaves out
+// frames to catch up, behind by more than MAX_LAG_FRAMES it starts over
+unsigned Pacer::Frame(uint64_t start)
+{
+    const unsigned speed   = m_speed;
+    const bool     restart = m_restart.exchange(false);
+    auto           host    = chrono::steady_clock::now();
+    unsigned       skip    = m_frameSkip;
+    bool           late    = false;
+    bool           catchUp = false;
+    bool           rebase  = false;
+    if(!restart && speed)
+    {
+        const chrono::duration<double> emulated(static_cast<double>(start - m_paceCycles) / (static_cast<double>(CYCLES_PER_SEC) * speed));
+        const auto due = m_paceStart + chrono::duration_cast<chrono::steady_clock::duration>(emulated);
+        if(host < due)
+        {
+            this_thread::sleep_until(due);
+            host = chrono::steady_clock::now();
+        }
+        else
+        {
+            const double behind = chrono::duration<double>(host - due).count() * speed / FRAME_TIME;
+            late                = behind >= 1;
+            rebase              = behind > MAX_LAG_FRAMES;
+            if(late && !rebase && min(static_cast<unsigned>(behind), MAX_CATCH_UP_SKIP) > skip)
+            {
+                skip    = min(static_cast<unsigned>(behind), MAX_CATCH_UP_SKIP);
+                catchUp = true;
+            }
+        }
+    }
+    if(restart || rebase || !speed)
+    {
+        m_paceStart  = host;
+        m_paceCycles = start;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if(m_timed && !restart)
+        {
+            const double interval = chrono::duration<double>(host - m_lastFrame).count();
+            m_min                 = m_timedFrames ? min(m_min, interval) : interval;
+            m_max                 = m_timedFrames ? max(m_max, interval) : interval;
+            m_sum += interval;
+            m_squares += interval * interval;
+            m_timedFrames++;
+        }
+        m_frames++;
+        m_paced++;
+        m_late += late;
+        m_catchUp += catchUp;
+        m_rebases += rebase;
+    }
+    m_frameStarted.notify_one();
+    m_lastFrame = host;
+    m_timed     = true;
+    return skip;
+}
+
+bool Pacer::WaitFrame(chrono::milliseconds timeout)
+{
+    unique_lock<mutex> lock(m_mutex);
+    if(!m_frameStarted.wait_for(lock, timeout, [this] { return m_frames != m_shown; }))
+    {
+        return false;
+    }
+    m_shown = m_frames;
+    return true;
+}
+
+void Pacer::Report(ostream& os) const
+{
+    lock_guard<mutex> lock(m_mutex);
+    if(!m_timedFrames)
+    {
+        os << "No frames timed" << endl;
+        return;
+    }
+    const double mean      = m_sum / static_cast<double>(m_timedFrames);
+    const double deviation = sqrt(max(0.0, m_squares / static_cast<double>(m_timedFrames) - mean * mean));
+    const auto flags     = os.flags();
+    const auto precision = os.precision();
+    os << dec << fixed << setprecision(2);
+    os << "Frames: " << m_paced << ", late: " << m_late << ", catching up: " << m_catchUp << ", lag dropped: " << m_rebases << endl;
+    os << "Frame time: " << mean * 1000 << " ms mean, " << deviation * 1000 << " ms deviation, " << m_min * 1000 << " to "
+       << m_max * 1000 << " ms" << endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void Pacer::ClearStats()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_paced       = 0;
+    m_timedFrames = 0;
+    m_sum         = 0;
+    m_squares     = 0;
+    m_late        = 0;
+    m_catchUp     = 0;
+    m_rebases     = 0;
+}
+} // namespace atre
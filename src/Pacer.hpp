@@ -0,0 +1,61 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+// keeps emulated frames in step with the host's monotonic clock. The CPU
+// thread reports each frame ANTIC starts and sleeps here while ahead, the IO
+// thread waits here for frames to show. Frames are due at absolute host times
+// counted from the last restart, so oversleeping never adds up to drift
+class Pacer
+{
+public:
+    Pacer();
+
+    // emulated time runs at speed times the host's, 0 runs unthrottled
+    void SetSpeed(unsigned speed);
+    // draws one frame, then leaves out the given number even when on time
+    void SetFrameSkip(unsigned frames);
+    // drops the lag, on the next frame pacing starts over from it
+    void Restart();
+    // CPU thread, at the start of the frame beginning at the given master
+    // clock; returns the frames to leave out after the next drawn one
+    unsigned Frame(uint64_t start);
+    // IO thread, true once a frame started after the last one waited for
+    bool WaitFrame(std::chrono::milliseconds timeout);
+    // host time between frames and how often the host fell behind
+    void Report(std::ostream& os) const;
+    void ClearStats();
+
+    // more frames behind the host drops the lag instead of catching up
+    const static unsigned MAX_LAG_FRAMES = 6;
+    // most frames left out in a row to catch up
+    const static unsigned MAX_CATCH_UP_SKIP = 3;
+
+private:
+    std::atomic_uint m_speed;
+    std::atomic_uint m_frameSkip;
+    std::atomic_bool m_restart;
+
+    // CPU thread only
+    std::chrono::steady_clock::time_point m_paceStart;
+    uint64_t                              m_paceCycles;
+    std::chrono::steady_clock::time_point m_lastFrame;
+    bool                                  m_timed; // m_lastFrame was paced since the restart
+
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_frameStarted;
+    uint64_t                m_frames;
+    uint64_t                m_shown; // the last frame the IO thread waited for
+    uint64_t                m_paced; // since the statistics were cleared
+    uint64_t                m_timedFrames;
+    double                  m_sum; // host seconds between timed frames
+    double                  m_squares;
+    double                  m_min;
+    double                  m_max;
+    uint64_t                m_late;    // started more than a frame behind the host
+    uint64_t                m_catchUp; // paced with frames left out to catch up
+    uint64_t                m_rebases; // fell more than MAX_LAG_FRAMES behind
+};
+} // namespace atre
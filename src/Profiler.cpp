@@ -0,0 +1,307 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+namespace atre
+{
+namespace
+{
+bool ParseNumber(string text, bool hex, unsigned& value)
+{
+    if(!text.empty() && text[0] == '$')
+    {
+        text.erase(0, 1);
+        hex = true;
+    }
+    else if(text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+    {
+        text.erase(0, 2);
+        hex = true;
+    }
+    if(text.empty() || text.size() > 8)
+    {
+        return false;
+    }
+    for(char c : text)
+    {
+        if(hex ? !isxdigit(static_cast<unsigned char>(c)) : !isdigit(static_cast<unsigned char>(c)))
+        {
+            return false;
+        }
+    }
+    value = static_cast<unsigned>(stoul(text, nullptr, hex ? 16 : 10));
+    return true;
+}
+
+string Hex(word_t addr)
+{
+    ostringstream os;
+    os << "$" << hex << uppercase << setw(4) << setfill('0') << addr;
+    return os.str();
+}
+} // namespace
+
+Profiler::Profiler() :
+    m_started(), m_lastPC(), m_lastCycle(), m_offset(), m_cycles(), m_counts(), m_codes(), m_calls(), m_inclusive(), m_active(), m_nodes(),
+    m_children(), m_frames(), m_node(), m_changes(), m_labels()
+{
+    Clear();
+}
+
+void Profiler::Clear()
+{
+    m_started = false;
+    m_offset  = 0;
+    m_cycles.assign(MEM_SIZE, 0);
+    m_counts.assign(MEM_SIZE, 0);
+    m_codes.assign(MEM_SIZE, 0);
+    m_calls.assign(MEM_SIZE, 0);
+    m_inclusive.assign(MEM_SIZE, 0);
+    m_active.assign(MEM_SIZE, 0);
+    m_nodes.assign(1, {0, 0, 0});
+    m_children.clear();
+    m_frames.clear();
+    m_node = 0;
+}
+
+// lines look like "00 2000 START" (MADS), "al 002000 .start" (ld65 -Ln) or
+// "CIOV = $E456"; anything else, like headers, is skipped
+void Profiler::LoadLabels(const string& fileName)
+{
+    ifstream ifs(fileName);
+    if(!ifs.good())
+    {
+        throw runtime_error("Unable to open file");
+    }
+
+    string line;
+    while(getline(ifs, line))
+    {
+        string   name;
+        unsigned addr = MEM_SIZE;
+        bool     found;
+        if(const auto equals = line.find('='); equals != string::npos)
+        {
+            istringstream left(line.substr(0, equals));
+            istringstream right(line.substr(equals + 1));
+            string        value;
+            left >> name;
+            right >> value;
+            found = ParseNumber(value, false, addr);
+        }
+        else
+        {
+            vector<string> tokens;
+            istringstream  words(line);
+            for(string word; words >> word;)
+            {
+                tokens.push_back(word);
+            }
+            if(tokens.size() < 2)
+            {
+                continue;
+            }
+            name  = tokens.back();
+            found = ParseNumber(tokens[tokens.size() - 2], true, addr);
+        }
+        if(!name.empty() && name[0] == '.')
+        {
+            name.erase(0, 1);
+        }
+        if(found && !name.empty() && addr < MEM_SIZE)
+        {
+            m_labels.emplace(static_cast<word_t>(addr), name);
+        }
+    }
+}
+
+// brings the frames in line with the CPU call stack, they mostly differ by
+// the last call or return so only the top of the stack is rebuilt
+void Profiler::Enter(const CallStack& callStack, uint64_t cycle)
+{
+    m_changes = callStack.Changes();
+
+    unsigned common = 0;
+    while(common < m_frames.size() && common < callStack.Size())
+    {
+        const auto& ours   = m_frames[common].frame;
+        const auto& theirs = callStack.Get(common);
+        if(ours.target != theirs.target || ours.kind != theirs.kind || ours.s != theirs.s)
+        {
+            break;
+        }
+        common++;
+    }
+    while(m_frames.size() > common)
+    {
+        const Frame& frame = m_frames.back();
+        if(!--m_active[frame.frame.target])
+        {
+            m_inclusive[frame.frame.target] += cycle - frame.start;
+        }
+        m_frames.pop_back();
+    }
+
+    m_node = m_frames.empty() ? 0 : m_frames.back().node;
+    for(unsigned i = common; i < callStack.Size(); i++)
+    {
+        const auto& frame = callStack.Get(i);
+        m_node            = Child(m_node, frame.target);
+        m_active[frame.target]++;
+        m_calls[frame.target]++;
+        m_frames.push_back({frame, m_node, cycle});
+    }
+}
+
+unsigned Profiler::Child(unsigned parent, word_t target)
+{
+    const uint64_t key   = (static_cast<uint64_t>(parent) << 16) | target;
+    const auto     child = m_children.find(key);
+    if(child != m_children.end())
+    {
+        return child->second;
+    }
+    m_nodes.push_back({target, parent, 0});
+    const auto node = static_cast<unsigned>(m_nodes.size() - 1);
+    m_children.emplace(key, node);
+    return node;
+}
+
+// including the calls still on the stack
+uint64_t Profiler::Inclusive(word_t target) const
+{
+    uint64_t cycles = m_inclusive[target];
+    if(m_active[target])
+    {
+        const auto outermost =
+            find_if(m_frames.begin(), m_frames.end(), [target](const Frame& frame) { return frame.frame.target == target; });
+        cycles += m_lastCycle - outermost->start;
+    }
+    return cycles;
+}
+
+// the nearest label at or below addr, with an offset unless exact
+string Profiler::Name(word_t addr, bool exact) const
+{
+    auto label = m_labels.upper_bound(addr);
+    if(label == m_labels.begin())
+    {
+        return Hex(addr);
+    }
+    label--;
+    const unsigned offset = addr - label->first;
+    if(offset == 0)
+    {
+        return label->second;
+    }
+    if(exact || offset > 0xFF)
+    {
+        return Hex(addr);
+    }
+    return label->second + "+" + to_string(offset);
+}
+
+void Profiler::Report(ostream& os, unsigned count) const
+{
+    uint64_t total = 0;
+    for(auto cycles : m_cycles)
+    {
+        total += cycles;
+    }
+    if(!total)
+    {
+        os << "No cycles recorded" << endl;
+        return;
+    }
+
+    const auto percent = [total](uint64_t cycles) { return 100.0 * static_cast<double>(cycles) / static_cast<double>(total); };
+    const auto hottest = [count](vector<word_t>& addrs, const function<uint64_t(word_t)>& key)
+    {
+        const auto last = addrs.begin() + min<size_t>(count, addrs.size());
+        partial_sort(addrs.begin(), last, addrs.end(), [&key](word_t a, word_t b) { return key(a) > key(b); });
+        addrs.erase(last, addrs.end());
+    };
+
+    vector<word_t> pcs;
+    vector<word_t> targets;
+    for(unsigned addr = 0; addr < MEM_SIZE; addr++)
+    {
+        if(m_counts[addr])
+        {
+            pcs.push_back(static_cast<word_t>(addr));
+        }
+        if(m_calls[addr])
+        {
+            targets.push_back(static_cast<word_t>(addr));
+        }
+    }
+
+    vector<uint64_t> exclusive(MEM_SIZE);
+    for(size_t node = 1; node < m_nodes.size(); node++)
+    {
+        exclusive[m_nodes[node].target] += m_nodes[node].cycles;
+    }
+
+    const auto flags     = os.flags();
+    const auto precision = os.precision();
+    os << dec << fixed << setprecision(2);
+    os << "Total cycles: " << total << endl;
+    os << "Hot instructions:" << endl;
+    os << "      cycles      %     count  cyc/ins  addr  op  location" << endl;
+    hottest(pcs, [this](word_t pc) { return m_cycles[pc]; });
+    for(auto pc : pcs)
+    {
+        os << setw(12) << m_cycles[pc] << setw(7) << percent(m_cycles[pc]) << setw(10) << m_counts[pc] << setw(9)
+           << static_cast<double>(m_cycles[pc]) / static_cast<double>(m_counts[pc]) << "  " << Hex(pc).substr(1) << "  " << hex
+           << uppercase << setw(2) << setfill('0') << static_cast<int>(m_codes[pc]) << dec << nouppercase << setfill(' ') << "  "
+           << Name(pc, false) << endl;
+    }
+
+    os << "Hot calls:" << endl;
+    os << "   inclusive      %   exclusive      %     calls  target" << endl;
+    hottest(targets, [this](word_t target) { return Inclusive(target); });
+    for(auto target : targets)
+    {
+        const uint64_t inclusive = Inclusive(target);
+        os << setw(12) << inclusive << setw(7) << percent(inclusive) << setw(12) << exclusive[target] << setw(7)
+           << percent(exclusive[target]) << setw(10) << m_calls[target] << "  " << Name(target, false) << endl;
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void Profiler::SaveFolded(const string& fileName) const
+{
+    ofstream ofs(fileName);
+    if(!ofs.good())
+    {
+        throw runtime_error("Unable to open file");
+    }
+
+    vector<string> names;
+    for(unsigned node = 0; node < m_nodes.size(); node++)
+    {
+        if(!m_nodes[node].cycles)
+        {
+            continue;
+        }
+        names.clear();
+        for(unsigned n = node; n; n = m_nodes[n].parent)
+        {
+            names.push_back(Name(m_nodes[n].target, false));
+        }
+        if(names.empty())
+        {
+            // ran before the first recorded call
+            names.push_back("[unknown]");
+        }
+        for(auto name = names.rbegin(); name != names.rend(); name++)
+        {
+            ofs << (name == names.rbegin() ? "" : ";") << *name;
+        }
+        ofs << " " << m_nodes[node].cycles << "\n";
+    }
+}
+} // namespace atre
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CallStack.hpp"
+#include "atre.hpp"
+
+namespace atre
+{
+// cycles and instruction counts per PC and per call target; each
+// instruction is charged the cycles until the next one starts, so waits and
+// interrupt entries go to the instruction before them. Calls follow the CPU
+// call stack, inclusive time counts a recursive target only once
+class Profiler
+{
+public:
+    Profiler();
+
+    void Clear();
+    // MADS or ld65 label files, or NAME = $ADDR symbol tables
+    void LoadLabels(const std::string& fileName);
+    // hottest instructions and call targets
+    void Report(std::ostream& os, unsigned count) const;
+    // one line per call path with its exclusive cycles, for flamegraph.pl
+    void SaveFolded(const std::string& fileName) const;
+
+    inline void Sample(word_t pc, byte_t code, uint64_t cpuCycle, const CallStack& callStack)
+    {
+        if(m_started && cpuCycle + m_offset < m_lastCycle)
+        {
+            // a reset started the CPU count over, time goes on from the last sample
+            m_offset = m_lastCycle - cpuCycle;
+        }
+        const uint64_t cycle = cpuCycle + m_offset;
+        if(m_started)
+        {
+            const uint64_t cycles = cycle - m_lastCycle;
+            m_cycles[m_lastPC] += cycles;
+            m_nodes[m_node].cycles += cycles;
+        }
+        if(!m_started || callStack.Changes() != m_changes)
+        {
+            Enter(callStack, cycle);
+        }
+        m_started   = true;
+        m_lastPC    = pc;
+        m_lastCycle = cycle;
+        m_counts[pc]++;
+        m_codes[pc] = code;
+    }
+
+private:
+    // one per distinct call path, 0 is the root
+    struct Node
+    {
+        word_t   target;
+        unsigned parent;
+        uint64_t cycles; // exclusive
+    };
+
+    struct Frame
+    {
+        CallStack::Frame frame;
+        unsigned         node;
+        uint64_t         start;
+    };
+
+    bool                                   m_started;
+    word_t                                 m_lastPC;
+    uint64_t                               m_lastCycle;
+    uint64_t                               m_offset; // of the CPU count since its last reset
+    std::vector<uint64_t>                  m_cycles;
+    std::vector<uint64_t>                  m_counts;
+    std::vector<byte_t>                    m_codes;
+    std::vector<uint64_t>                  m_calls;
+    std::vector<uint64_t>                  m_inclusive;
+    std::vector<unsigned>                  m_active; // frames of the target on the stack
+    std::vector<Node>                      m_nodes;
+    std::unordered_map<uint64_t, unsigned> m_children; // parent << 16 | target
+    std::vector<Frame>                     m_frames;
+    unsigned                               m_node;
+    unsigned                               m_changes;
+    std::map<word_t, std::string>          m_labels;
+
+    void        Enter(const CallStack& callStack, uint64_t cycle);
+    unsigned    Child(unsigned parent, word_t target);
+    uint64_t    Inclusive(word_t target) const;
+    std::string Name(word_t addr, bool exact) const;
+};
+} // namespace atre
@@ -6,7 +6,8 @@ using namespace std;
 
 namespace atre
 {
-RAM::RAM() : m_bytes(), m_osROM(), m_cartridgeROM(), m_feedbackRegisters(), m_IO()
+RAM::RAM() :
+    m_bytes(), m_osROM(), m_cartridgeROM(), m_feedbackRegisters(), m_IO(), m_pageTags(), m_pageWrites(), m_pageBanks(), m_romVersion()
 {
     Clear();
 }
@@ -17,17 +18,105 @@ void RAM::Clear()
     memset(m_osROM, 0, sizeof(m_osROM));
     memset(m_cartridgeROM, 0, sizeof(m_cartridgeROM));
     m_feedbackRegisters.clear();
+    Invalidate();
 }
 
 void RAM::Connect(IO* io)
 {
     m_IO = io;
+    UpdateBanks();
 }
 
 void RAM::Move(word_t startAddr, word_t destAddr, word_t size)
 {
     memcpy(reinterpret_cast<char*>(m_bytes) + destAddr, reinterpret_cast<char*>(m_bytes) + startAddr, size);
     memset(reinterpret_cast<char*>(m_bytes) + startAddr, 0, size);
+    Invalidate();
+}
+
+void RAM::SetPortB(byte_t val)
+{
+    DirectSet(ChipRegisters::PORTB, val);
+    UpdateBanks();
+}
+
+// contents changed behind the tracking, bump every page
+void RAM::Invalidate()
+{
+    for(auto page = 0; page < 256; page++)
+    {
+        if(m_pageBanks[page] == MemoryBank::RAM)
+        {
+            m_pageTags[page]++;
+        }
+        else
+        {
+            m_pageWrites[page]++;
+        }
+    }
+    m_romVersion++;
+    UpdateBanks();
+}
+
+// RAM pages are tagged with their write count, ROM pages with
+// the bank they map to; restores the write count when RAM is mapped back
+void RAM::UpdateBanks()
+{
+    const byte_t portB = DirectGet(ChipRegisters::PORTB);
+    for(auto page = 0; page < 256; page++)
+    {
+        const word_t addr = static_cast<word_t>(page << 8);
+        MemoryBank   bank = MemoryBank::RAM;
+        if(m_IO)
+        {
+            if(addr >= 0xD000 && addr < 0xD800)
+            {
+                bank = MemoryBank::IO;
+            }
+            else if(((addr >= 0xC000 && addr < 0xD000) || (addr >= 0xD800)) && (portB & 1))
+            {
+                bank = MemoryBank::OS;
+            }
+            else if(addr >= 0xA000 && addr < 0xC000 && !(portB & 2))
+            {
+                bank = MemoryBank::Cartridge;
+            }
+            else if(addr >= 0x5000 && addr < 0x5800 && !(portB & 128) && (portB & 1))
+            {
+                bank = MemoryBank::SelfTest;
+            }
+        }
+        if(m_pageBanks[page] == MemoryBank::RAM)
+        {
+            m_pageWrites[page] = m_pageTags[page];
+        }
+        m_pageBanks[page] = bank;
+        m_pageTags[page]  = bank == MemoryBank::RAM ? m_pageWrites[page] : ROM_TAG | (m_romVersion << 3) | static_cast<uint32_t>(bank);
+    }
+}
+
+// true when Get and Set of [addr, addr + size) would only touch m_bytes,
+// the range may wrap around the end of memory
+bool RAM::IsPlainRAM(word_t addr, unsigned size) const
+{
+    const unsigned end = addr + size;
+    for(unsigned page = addr >> 8; page <= (end - 1) >> 8; page++)
+    {
+        if(m_pageBanks[page & 0xFF] != MemoryBank::RAM)
+        {
+            return false;
+        }
+    }
+    if(m_feedbackRegisters.empty())
+    {
+        return true;
+    }
+    const auto reg = m_feedbackRegisters.lower_bound(addr);
+    if(reg != m_feedbackRegisters.end() && reg->first < end)
+    {
+        return false;
+    }
+    return end <= MEM_SIZE || m_feedbackRegisters.begin()->first >= end - MEM_SIZE;
 }
 
 void RAM::MapFeedbackRegister(word_t addr, shared_ptr<FeedbackRegister> feedbackRegister)
@@ -63,16 +152,23 @@ byte_t RAM::Get(word_t addr)
     return m_bytes[addr];
 }
 
-byte_t RAM::DirectGet(word_t addr)
+byte_t RAM::PeekBank(MemoryBank bank, word_t addr) const
 {
+    if(bank == MemoryBank::OS && addr >= 0xC000)
+    {
+        return m_osROM[addr - 0xC000];
+    }
+    if(bank == MemoryBank::Cartridge && addr >= 0xA000 && addr < 0xC000)
+    {
+        return m_cartridgeROM[addr - 0xA000];
+    }
+    if(bank == MemoryBank::SelfTest && addr >= 0x5000 && addr < 0x5800)
+    {
+        return m_osROM[addr - 0x5000 + 0x1000];
+    }
     return m_bytes[addr];
 }
 
-void RAM::DirectSet(word_t addr, byte_t val)
-{
-    m_bytes[addr] = val;
-}
-
 void RAM::Set(word_t addr, byte_t val)
 {
     if(m_feedbackRegisters.find(addr) != m_feedbackRegisters.end())
@@ -117,7 +213,7 @@ void RAM::Set(word_t addr, byte_t val)
         return;
     }
 
-    m_bytes[addr] = val;
+    DirectSet(addr, val);
 }
 
 word_t RAM::GetW(word_t addr)
@@ -132,6 +228,17 @@ void RAM::SetW(word_t addr, word_t val)
     Set(addr + 1, static_cast<byte_t>(val >> 8));
 }
 
+// FNV-1a, identifies cartridges compiled ahead of time
+uint64_t RAM::CartridgeHash() const
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for(auto b : m_cartridgeROM)
+    {
+        hash = (hash ^ b) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
 void RAM::InternalLoad(const string& fileName, byte_t* addr)
 {
     if(!fileName.length())
@@ -157,11 +264,13 @@ void RAM::InternalLoad(const string& fileName, byte_t* addr)
 void RAM::Load(const string& fileName, word_t startAddr)
 {
     InternalLoad(fileName, m_bytes + startAddr);
+    Invalidate();
 }
 
 void RAM::LoadROM(const string& osFileName, const string& cartridgeFileName)
 {
     InternalLoad(osFileName, m_osROM);
     InternalLoad(cartridgeFileName, m_cartridgeROM);
+    Invalidate();
 }
 } // namespace atre
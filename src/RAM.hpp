@@ -6,6 +6,15 @@ namespace atre
 {
 class IO;
 
+enum class MemoryBank : byte_t
+{
+    RAM,
+    OS,
+    Cartridge,
+    SelfTest,
+    IO
+};
+
 struct FeedbackRegister
 {
     FeedbackRegister(std::function<void(byte_t)> callback) : writeFunc(callback) {}
@@ -23,23 +32,61 @@ public:
     void Load(const std::string& fileName, word_t startAddr);
     void LoadROM(const std::string& osFileName, const std::string& cartridgeFileName);
     void MapFeedbackRegister(word_t addr, std::shared_ptr<FeedbackRegister> feedbackRegister);
+    void SetPortB(byte_t val);
 
     byte_t Get(word_t addr);
     void   Set(word_t addr, byte_t val);
-    byte_t DirectGet(word_t addr);
-    void   DirectSet(word_t addr, byte_t val);
     word_t GetW(word_t addr);
     void   SetW(word_t addr, word_t val);
 
+    uint64_t CartridgeHash() const;
+    // what the bank holds at addr whether it's mapped or not, RAM under IO
+    // for the IO bank since chip reads have side effects
+    byte_t PeekBank(MemoryBank bank, word_t addr) const;
+    bool     IsPlainRAM(word_t addr, unsigned size) const;
+
+    // changes whenever the code visible on the page may have changed
+    inline uint32_t PageTag(word_t addr) const
+    {
+        return m_pageTags[addr >> 8];
+    }
+
+    inline MemoryBank PageBank(word_t addr) const
+    {
+        return m_pageBanks[addr >> 8];
+    }
+
+    // plain memory, bypassing banking, chips and feedback registers
+    inline byte_t DirectGet(word_t addr) const
+    {
+        return m_bytes[addr];
+    }
+
+    inline void DirectSet(word_t addr, byte_t val)
+    {
+        m_bytes[addr] = val;
+        m_pageTags[addr >> 8]++;
+    }
+
 private:
     friend class Debugger;
+    friend class Jit;
+    friend class Snapshot;
 
     byte_t                                              m_bytes[MEM_SIZE];
     byte_t                                              m_osROM[16386];
-    byte_t                                              m_cartridgeROM[8192];
+    byte_t                                              m_cartridgeROM[CARTRIDGE_SIZE];
     std::map<word_t, std::shared_ptr<FeedbackRegister>> m_feedbackRegisters;
     IO*                                                 m_IO;
+    uint32_t                                            m_pageTags[256];
+    uint32_t                                            m_pageWrites[256];
+    MemoryBank                                          m_pageBanks[256];
+    uint32_t                                            m_romVersion;
+
+    const static uint32_t ROM_TAG = 0x80000000;
 
     void InternalLoad(const std::string& fileName, byte_t* addr);
+    void Invalidate();
+    void UpdateBanks();
 };
 } // namespace atre
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+// timed work of the chips, DLIs and VBIs are raised at the start of their scanline
+enum class ChipEvent
+{
+    Scanline,  // ANTIC starts the next line
+    SerialOut, // POKEY shifted out the last SEROUT byte
+    Keyboard,  // POKEY picks up keys from the IO thread
+    Timers,    // POKEY's timer status, only on the 64 kHz ticks that change it
+    Count
+};
+
+// the master clock in chip cycles since power on, never reset or wrapped,
+// and the next deadline of each event. There are a handful of events, each
+// scheduled at most once, so the queue is a deadline per event with the
+// earliest one cached; the CPU runs without calling the chips until it
+// reaches the earliest deadline
+class Scheduler
+{
+public:
+    const static uint64_t NEVER = UINT64_MAX;
+
+    Scheduler() : m_now(), m_next(NEVER), m_nextEvent(), m_lastEvent(), m_deadlines()
+    {
+        m_deadlines.fill(NEVER);
+    }
+
+    inline uint64_t Now() const
+    {
+        return m_now;
+    }
+
+    inline uint64_t Deadline(ChipEvent event) const
+    {
+        return m_deadlines[static_cast<size_t>(event)];
+    }
+
+    // the earliest deadline of all events
+    inline uint64_t NextDeadline() const
+    {
+        return m_next;
+    }
+
+    // when the last event was taken off the queue
+    inline uint64_t LastEvent() const
+    {
+        return m_lastEvent;
+    }
+
+    inline bool IsScheduled(ChipEvent event) const
+    {
+        return Deadline(event) != NEVER;
+    }
+
+    // replaces the event's earlier deadline
+    inline void Schedule(ChipEvent event, uint64_t time)
+    {
+        m_deadlines[static_cast<size_t>(event)] = time;
+        Update();
+    }
+
+    inline void Cancel(ChipEvent event)
+    {
+        Schedule(event, NEVER);
+    }
+
+    // moves the clock to the first event due by until and takes it off the
+    // queue, or to until once none is; events due together come in ChipEvent order
+    inline bool Next(uint64_t until, ChipEvent& event)
+    {
+        if(m_next > until)
+        {
+            m_now = until;
+            return false;
+        }
+        m_now                                         = m_next;
+        m_lastEvent                                   = m_next;
+        event                                         = m_nextEvent;
+        m_deadlines[static_cast<size_t>(m_nextEvent)] = NEVER;
+        Update();
+        return true;
+    }
+
+private:
+    uint64_t                                                    m_now;
+    uint64_t                                                    m_next;
+    ChipEvent                                                   m_nextEvent;
+    uint64_t                                                    m_lastEvent;
+    std::array<uint64_t, static_cast<size_t>(ChipEvent::Count)> m_deadlines;
+
+    inline void Update()
+    {
+        m_next = NEVER;
+        for(size_t i = 0; i < m_deadlines.size(); i++)
+        {
+            if(m_deadlines[i] < m_next)
+            {
+                m_next      = m_deadlines[i];
+                m_nextEvent = static_cast<ChipEvent>(i);
+            }
+        }
+    }
+};
+} // namespace atre
@@ -0,0 +1,165 @@
+#include "Snapshot.hpp"
+
+using namespace std;
+
+namespace atre
+{
+Snapshot::Snapshot() : m_bytes(), m_CPU(), m_ANTIC(), m_GTIA(), m_POKEY(), m_PIA() {}
+
+void Snapshot::Save(Atari* atari)
+{
+    const CPU& cpu   = *atari->getCPU();
+    m_CPU.a          = cpu.A;
+    m_CPU.x          = cpu.X;
+    m_CPU.y          = cpu.Y;
+    m_CPU.s          = cpu.S;
+    m_CPU.pc         = cpu.PC;
+    m_CPU.f          = cpu.F;
+    m_CPU.nResult    = cpu.m_nResult;
+    m_CPU.zResult    = cpu.m_zResult;
+    m_CPU.brk        = cpu.BRK;
+    m_CPU.cycles     = cpu.m_cycles;
+    m_CPU.seconds    = cpu.m_seconds;
+    m_CPU.clockPhase = cpu.m_clockPhase;
+    m_CPU.waitCycles = cpu.m_waitCycles;
+    m_CPU.pollStart  = cpu.m_pollStart;
+    m_CPU.pollCycles = cpu.m_pollCycles;
+    m_CPU.pollTime   = cpu.m_pollTime;
+    m_CPU.callStack  = cpu.m_callStack;
+    m_CPU.interrupts = cpu.m_interrupts;
+    m_CPU.scheduler  = cpu.m_scheduler;
+
+    memcpy(m_bytes, atari->getRAM()->m_bytes, MEM_SIZE);
+
+    const IO&    io        = *atari->getIO();
+    const ANTIC& antic     = io.m_ANTIC;
+    m_ANTIC.renderLine     = antic.m_renderLine;
+    m_ANTIC.displayMode    = antic.m_displayMode;
+    m_ANTIC.playfieldWidth = antic.m_playfieldWidth;
+    m_ANTIC.scanAddress    = antic.m_scanAddress;
+    m_ANTIC.listAddress    = antic.m_listAddress;
+    m_ANTIC.triggerDLI     = antic.m_triggerDLI;
+    m_ANTIC.hScroll        = antic.m_hScroll;
+    m_ANTIC.listActive     = antic.m_listActive;
+    m_ANTIC.skipped        = antic.m_skipped;
+    m_ANTIC.rendering      = antic.m_rendering;
+    m_ANTIC.frameStart     = antic.m_frameStart;
+    m_ANTIC.scanLine       = antic.m_scanLine;
+    m_ANTIC.scanBuffer     = antic.m_scanBuffer;
+
+    const GTIA& gtia = io.m_GTIA;
+    m_GTIA.synced    = gtia.m_synced;
+    m_GTIA.scanCycle = gtia.m_scanCycle;
+    m_GTIA.optionKey = gtia.m_optionKey;
+    m_GTIA.selectKey = gtia.m_selectKey;
+    m_GTIA.startKey  = gtia.m_startKey;
+    m_GTIA.joyFire   = gtia.m_joyFire;
+    memcpy(m_GTIA.collisions, gtia.m_collisions, sizeof(m_GTIA.collisions));
+    memcpy(m_GTIA.playerPos, gtia.m_playerPos, sizeof(m_GTIA.playerPos));
+
+    const POKEY& pokey   = io.m_POKEY;
+    m_POKEY.irqStatus    = pokey.m_irqStatus;
+    m_POKEY.scanCode     = pokey.m_scanCode;
+    m_POKEY.kbStat       = pokey.m_kbStat;
+    m_POKEY.sioComplete  = pokey.m_sioComplete;
+    m_POKEY.keyPressed   = pokey.m_keyPressed;
+    m_POKEY.breakPressed = pokey.m_breakPressed;
+
+    const PIA& pia = io.m_PIA;
+    m_PIA.joyUp    = pia.m_joyUp;
+    m_PIA.joyDown  = pia.m_joyDown;
+    m_PIA.joyLeft  = pia.m_joyLeft;
+    m_PIA.joyRight = pia.m_joyRight;
+}
+
+void Snapshot::Restore(Atari* atari)
+{
+    CPU& cpu         = *atari->getCPU();
+    cpu.A            = m_CPU.a;
+    cpu.X            = m_CPU.x;
+    cpu.Y            = m_CPU.y;
+    cpu.S            = m_CPU.s;
+    cpu.PC           = m_CPU.pc;
+    cpu.F            = m_CPU.f;
+    cpu.m_nResult    = m_CPU.nResult;
+    cpu.m_zResult    = m_CPU.zResult;
+    cpu.BRK          = m_CPU.brk;
+    cpu.m_cycles     = m_CPU.cycles;
+    cpu.m_seconds    = m_CPU.seconds;
+    cpu.m_clockPhase = m_CPU.clockPhase;
+    cpu.m_waitCycles = m_CPU.waitCycles;
+    cpu.m_pollStart  = m_CPU.pollStart;
+    cpu.m_pollCycles = m_CPU.pollCycles;
+    cpu.m_pollTime   = m_CPU.pollTime;
+    cpu.m_callStack  = m_CPU.callStack;
+    cpu.m_interrupts = m_CPU.interrupts;
+    cpu.m_scheduler  = m_CPU.scheduler;
+
+    // the block being stepped through may have been decoded again meanwhile
+    cpu.m_nextOp = cpu.m_blockEnd = nullptr;
+
+    // changed pages get new tags like with RAM::Invalidate, tags never go back
+    RAM&         ram   = *atari->getRAM();
+    const byte_t portB = ram.DirectGet(ChipRegisters::PORTB);
+    for(unsigned page = 0; page < 256; page++)
+    {
+        const unsigned offset = page << 8;
+        if(memcmp(ram.m_bytes + offset, m_bytes + offset, 256))
+        {
+            memcpy(ram.m_bytes + offset, m_bytes + offset, 256);
+            if(ram.m_pageBanks[page] == MemoryBank::RAM)
+            {
+                ram.m_pageTags[page]++;
+            }
+            else
+            {
+                ram.m_pageWrites[page]++;
+            }
+        }
+    }
+    if(ram.DirectGet(ChipRegisters::PORTB) != portB)
+    {
+        ram.UpdateBanks();
+    }
+
+    IO&    io              = *atari->getIO();
+    ANTIC& antic           = io.m_ANTIC;
+    antic.m_renderLine     = m_ANTIC.renderLine;
+    antic.m_displayMode    = m_ANTIC.displayMode;
+    antic.m_playfieldWidth = m_ANTIC.playfieldWidth;
+    antic.m_scanAddress    = m_ANTIC.scanAddress;
+    antic.m_listAddress    = m_ANTIC.listAddress;
+    antic.m_triggerDLI     = m_ANTIC.triggerDLI;
+    antic.m_hScroll        = m_ANTIC.hScroll;
+    antic.m_listActive     = m_ANTIC.listActive;
+    antic.m_skipped        = m_ANTIC.skipped;
+    antic.m_rendering      = m_ANTIC.rendering;
+    antic.m_frameStart     = m_ANTIC.frameStart;
+    antic.m_scanLine       = m_ANTIC.scanLine;
+    antic.m_scanBuffer     = m_ANTIC.scanBuffer;
+
+    GTIA& gtia       = io.m_GTIA;
+    gtia.m_synced    = m_GTIA.synced;
+    gtia.m_scanCycle = m_GTIA.scanCycle;
+    gtia.m_optionKey = m_GTIA.optionKey;
+    gtia.m_selectKey = m_GTIA.selectKey;
+    gtia.m_startKey  = m_GTIA.startKey;
+    gtia.m_joyFire   = m_GTIA.joyFire;
+    memcpy(gtia.m_collisions, m_GTIA.collisions, sizeof(m_GTIA.collisions));
+    memcpy(gtia.m_playerPos, m_GTIA.playerPos, sizeof(m_GTIA.playerPos));
+
+    POKEY& pokey         = io.m_POKEY;
+    pokey.m_irqStatus    = m_POKEY.irqStatus;
+    pokey.m_scanCode     = m_POKEY.scanCode;
+    pokey.m_kbStat       = m_POKEY.kbStat;
+    pokey.m_sioComplete  = m_POKEY.sioComplete;
+    pokey.m_keyPressed   = m_POKEY.keyPressed;
+    pokey.m_breakPressed = m_POKEY.breakPressed;
+
+    PIA& pia       = io.m_PIA;
+    pia.m_joyUp    = m_PIA.joyUp;
+    pia.m_joyDown  = m_PIA.joyDown;
+    pia.m_joyLeft  = m_PIA.joyLeft;
+    pia.m_joyRight = m_PIA.joyRight;
+}
+} // namespace atre
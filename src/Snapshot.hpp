@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Atari.hpp"
+
+namespace atre
+{
+// the state of the CPU, RAM and chips between two instructions, kept in
+// memory so the emulation can run ahead and come back. Host settings,
+// decoded and compiled code and the drawn pictures aren't part of it
+class Snapshot
+{
+public:
+    Snapshot();
+
+    void Save(Atari* atari);
+    // RAM pages are only written back where they changed, which is also
+    // all the block cache and JIT have to drop
+    void Restore(Atari* atari);
+
+private:
+    struct CPUState
+    {
+        byte_t              a;
+        byte_t              x;
+        byte_t              y;
+        byte_t              s;
+        word_t              pc;
+        byte_t              f;
+        byte_t              nResult;
+        byte_t              zResult;
+        word_t              brk;
+        unsigned long       cycles;
+        unsigned long       seconds;
+        unsigned            clockPhase;
+        unsigned            waitCycles;
+        word_t              pollStart;
+        uint64_t            pollCycles;
+        uint64_t            pollTime;
+        CallStack           callStack;
+        InterruptController interrupts;
+        Scheduler           scheduler;
+    };
+
+    struct ANTICState
+    {
+        int        renderLine;
+        byte_t     displayMode;
+        int        playfieldWidth;
+        word_t     scanAddress;
+        word_t     listAddress;
+        bool       triggerDLI;
+        bool       hScroll;
+        bool       listActive;
+        unsigned   skipped;
+        bool       rendering;
+        uint64_t   frameStart;
+        word_t     scanLine;
+        ScanBuffer scanBuffer;
+    };
+
+    struct GTIAState
+    {
+        uint64_t synced;
+        word_t   scanCycle;
+        bool     optionKey;
+        bool     selectKey;
+        bool     startKey;
+        bool     joyFire;
+        byte_t   collisions[16];
+        byte_t   playerPos[FRAME_WIDTH];
+    };
+
+    struct POKEYState
+    {
+        byte_t irqStatus;
+        byte_t scanCode;
+        byte_t kbStat;
+        bool   sioComplete;
+        bool   keyPressed;
+        bool   breakPressed;
+    };
+
+    struct PIAState
+    {
+        bool joyUp;
+        bool joyDown;
+        bool joyLeft;
+        bool joyRight;
+    };
+
+    byte_t     m_bytes[MEM_SIZE];
+    CPUState   m_CPU;
+    ANTICState m_ANTIC;
+    GTIAState  m_GTIA;
+    POKEYState m_POKEY;
+    PIAState   m_PIA;
+};
+} // namespace atre
@@ -1,12 +1,205 @@
 #include "ANTIC.hpp"
+#include "Aot.hpp"
 #include "Chips.hpp"
+#include "Condition.hpp"
+#include "Coverage.hpp"
 #include "Debugger.hpp"
+#include "Lanes.hpp"
+#include "MathPack.hpp"
 #include "Tests.hpp"
 
 using namespace std;
 
 namespace atre
 {
+namespace
+{
+// branches apart on the seeds at $80 and in page 2 and meets again, loops a
+// number of times the seed decides and runs decimal ADC and SBC, BRK and
+// RTI, which lanes leave to their CPUs; stops at $0441
+const word_t BRANCH_PROGRAM_START = 0x0400;
+const word_t BRANCH_PROGRAM_END   = 0x0441;
+const word_t BRANCH_BRK_HANDLER   = 0x043E;
+const byte_t BRANCH_PROGRAM[]     = {
+    0xA2, 0x00,       // 0400 LDX #$00
+    0xA5, 0x80,       // 0402 LDA $80
+    0x0A,             // 0404 ASL A
+    0x90, 0x02,       // 0405 BCC noxor
+    0x49, 0x1D,       // 0407 EOR #$1D
+    0x85, 0x80,       // 0409 STA $80
+    0x29, 0x07,       // 040B AND #$07
+    0xA8,             // 040D TAY
+    0xF0, 0x03,       // 040E BEQ nodelay
+    0x88,             // 0410 DEY
+    0xD0, 0xFD,       // 0411 BNE delay
+    0xF8,             // 0413 SED
+    0xA5, 0x81,       // 0414 LDA $81
+    0x65, 0x80,       // 0416 ADC $80
+    0xE9, 0x19,       // 0418 SBC #$19
+    0x85, 0x81,       // 041A STA $81
+    0xD8,             // 041C CLD
+    0x08,             // 041D PHP
+    0x20, 0x37, 0x04, // 041E JSR sub
+    0x28,             // 0421 PLP
+    0x9D, 0x00, 0x03, // 0422 STA $0300,X
+    0x7E, 0x00, 0x02, // 0425 ROR $0200,X
+    0x7D, 0xF8, 0x02, // 0428 ADC $02F8,X
+    0x24, 0x80,       // 042B BIT $80
+    0x50, 0x02,       // 042D BVC nobrk
+    0x00, 0xEA,       // 042F BRK
+    0xE8,             // 0431 INX
+    0xD0, 0xCE,       // 0432 BNE loop
+    0x4C, 0x41, 0x04, // 0434 JMP done
+    0xC9, 0x50,       // 0437 CMP #$50
+    0xB0, 0x02,       // 0439 BCS big
+    0x69, 0x30,       // 043B ADC #$30
+    0x60,             // 043D RTS
+    0xE6, 0x82,       // 043E INC $82
+    0x40,             // 0440 RTI
+    0x4C, 0x41, 0x04, // 0441 JMP done
+};
+
+void LoadBranchProgram(unsigned seed, const function<void(word_t, byte_t)>& set)
+{
+    for(unsigned i = 0; i < sizeof(BRANCH_PROGRAM); i++)
+    {
+        set(static_cast<word_t>(BRANCH_PROGRAM_START + i), BRANCH_PROGRAM[i]);
+    }
+    set(0xFFFE, BRANCH_BRK_HANDLER & 0xFF);
+    set(0xFFFF, BRANCH_BRK_HANDLER >> 8);
+    set(0x80, static_cast<byte_t>(seed * 0x35 + 7));
+    set(0x81, static_cast<byte_t>(seed));
+    for(unsigned i = 0; i < 0x100; i++)
+    {
+        set(static_cast<word_t>(0x0200 + i), static_cast<byte_t>(seed * 0x1F + i * 0x0B));
+    }
+}
+
+// OS floating point entry points and registers
+const word_t AFP    = 0xD800;
+const word_t FASC   = 0xD8E6;
+const word_t IFP    = 0xD9AA;
+const word_t FPI    = 0xD9D2;
+const word_t FSUB   = 0xDA60;
+const word_t FADD   = 0xDA66;
+const word_t FMUL   = 0xDADB;
+const word_t FDIV   = 0xDB28;
+const word_t FR0    = 0xD4;
+const word_t FR1    = 0xE0;
+const word_t CIX    = 0xF2;
+const word_t INBUFF = 0xF3;
+
+// exponent byte and five BCD mantissa bytes
+typedef array<byte_t, 6> Float;
+
+// results of the ROM routines, nothing is checked in FR0 after an error
+struct FloatCase
+{
+    word_t entry;
+    Float  fr0;
+    Float  fr1;
+    Float  result;
+    bool   error;
+};
+
+const FloatCase FLOAT_CASES[] = {
+    // 99.99999999 + 0.00000001 carries through all mantissa bytes
+    {FADD, {0x40, 0x99, 0x99, 0x99, 0x99, 0x99}, {0x3C, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x41, 0x01, 0x00, 0x00, 0x00, 0x00}, false},
+    {FADD, {0x3F, 0x50, 0x00, 0x00, 0x00, 0x00}, {0x3F, 0x50, 0x00, 0x00, 0x00, 0x00}, {0x40, 0x01, 0x00, 0x00, 0x00, 0x00}, false},
+    // 9.9E97 + 9.9E97
+    {FADD, {0x70, 0x99, 0x00, 0x00, 0x00, 0x00}, {0x70, 0x99, 0x00, 0x00, 0x00, 0x00}, {}, true},
+    {FSUB, {0x40, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x40, 0x03, 0x00, 0x00, 0x00, 0x00}, {0xC0, 0x02, 0x00, 0x00, 0x00, 0x00}, false},
+    // 100 - 0.000001 borrows through the mantissa bytes
+    {FSUB, {0x41, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x3D, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x40, 0x99, 0x99, 0x99, 0x99, 0x00}, false},
+    {FMUL, {0x40, 0x02, 0x00, 0x00, 0x00, 0x00}, {0xC0, 0x03, 0x00, 0x00, 0x00, 0x00}, {0xC0, 0x06, 0x00, 0x00, 0x00, 0x00}, false},
+    // 1E-60 * 1E-60 underflows to 0, 1E60 * 1E60 overflows
+    {FMUL, {0x22, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x22, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, false},
+    {FMUL, {0x5E, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x5E, 0x01, 0x00, 0x00, 0x00, 0x00}, {}, true},
+    {FDIV, {0x40, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x40, 0x04, 0x00, 0x00, 0x00, 0x00}, {0x3F, 0x25, 0x00, 0x00, 0x00, 0x00}, false},
+    {FDIV, {0x40, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x40, 0x03, 0x00, 0x00, 0x00, 0x00}, {0x3F, 0x33, 0x33, 0x33, 0x33, 0x33}, false},
+    {FDIV, {0x40, 0x01, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {}, true},
+};
+
+// FPI rounds halves up
+struct IntegerCase
+{
+    Float  fr0;
+    word_t result;
+    bool   error;
+};
+
+const IntegerCase INTEGER_CASES[] = {
+    {{0x40, 0x02, 0x50, 0x00, 0x00, 0x00}, 3, false},     {{0x40, 0x01, 0x49, 0x00, 0x00, 0x00}, 1, false},
+    {{0x3F, 0x50, 0x00, 0x00, 0x00, 0x00}, 1, false},     {{0x3F, 0x49, 0x00, 0x00, 0x00, 0x00}, 0, false},
+    {{0x42, 0x06, 0x55, 0x35, 0x00, 0x00}, 65535, false}, {{0x42, 0x06, 0x55, 0x35, 0x50, 0x00}, 0, true},
+    {{0xC0, 0x01, 0x00, 0x00, 0x00, 0x00}, 0, true},
+};
+
+// FASC switches to E notation below 0.01 and from 1E10 on
+struct TextCase
+{
+    Float       fr0;
+    const char* text;
+};
+
+const TextCase TEXT_CASES[] = {
+    {{0x3F, 0x01, 0x00, 0x00, 0x00, 0x00}, "0.01"},       {{0x3F, 0x01, 0x23, 0x00, 0x00, 0x00}, "0.0123"},
+    {{0x3E, 0x99, 0x00, 0x00, 0x00, 0x00}, "9.9E-03"},    {{0x3E, 0x10, 0x00, 0x00, 0x00, 0x00}, "1E-03"},
+    {{0x44, 0x99, 0x99, 0x99, 0x99, 0x99}, "9999999999"}, {{0x45, 0x01, 0x00, 0x00, 0x00, 0x00}, "1E+10"},
+    {{0x45, 0x01, 0x50, 0x00, 0x00, 0x00}, "1.5E+10"},    {{0xBF, 0x50, 0x00, 0x00, 0x00, 0x00}, "-0.5"},
+    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, "0"},
+};
+
+// a cartridge started at $A000 and initialized at $A014, the loop branches
+// back into the first block and the subroutine returns into the middle of
+// the code, each of them starts a block of its own
+const byte_t AOT_CARTRIDGE[] = {
+    0xA2, 0x05,       // A000 LDX #$05
+    0xCA,             // A002 DEX
+    0xD0, 0xFD,       // A003 BNE $A002
+    0x20, 0x10, 0xA0, // A005 JSR $A010
+    0x4C, 0x08, 0xA0, // A008 JMP $A008
+};
+const byte_t AOT_SUBROUTINE[] = {
+    0xE8, // A010 INX
+    0x60, // A011 RTS
+    0x00, // A012
+    0x00, // A013
+    0x60, // A014 RTS
+};
+
+// breakpoint conditions with the A register and hit count they are evaluated at
+struct ConditionCase
+{
+    const char* text;
+    byte_t      a;
+    unsigned    hits;
+    bool        result;
+};
+
+const ConditionCase CONDITION_CASES[] = {
+    // && binds tighter than ||
+    {"1||0&&0", 0, 1, true},
+    {"(1||0)&&0", 0, 1, false},
+    {"!(A!=1)", 1, 1, true},
+    {"!(A!=1)", 2, 1, false},
+    // & binds tighter than ==, unlike C, so masks compare without brackets
+    {"$FF&1==1", 0, 1, true},
+    {"2&2==2", 0, 1, true},
+    {"hits>5", 0, 1, false},
+    {"hits>5", 0, 5, false},
+    {"hits>5", 0, 6, true},
+    {"hits>5", 0, 1000, true},
+    // dividing by zero gives 0
+    {"A/0==0", 7, 1, true},
+    {"A%0==0", 7, 1, true},
+    {"A/0", 7, 1, false},
+    {"-A/2==-3&&~0==-1", 7, 1, true},
+};
+} // namespace
+
+bool    Tests::s_enableJIT = false;
+BusType Tests::s_busType   = BusType::Atari;
 
 TestCallbacks::TestCallbacks() : Callbacks(), m_trapHit() {}
 
@@ -49,12 +242,13 @@ void Tests::FunctionalTest(const string& romFile)
 
     TestCallbacks tc;
     RAM           ram;
-    CPU           cpu(&ram);
+    CPU           cpu(&ram, s_busType);
 
     ram.Load(romFile, 0);
     cpu.Attach(&tc);
     cpu.m_enableTraps = true;
     cpu.m_showCycles  = true;
+    cpu.m_enableJIT   = s_enableJIT;
     cpu.JumpTo(0x0400);
     cpu.BreakAt(0x3469);
     while(!tc.IsTrap())
@@ -66,8 +260,9 @@ void Tests::FunctionalTest(const string& romFile)
 
 void Tests::InterruptReg(CPU* cpu, byte_t val)
 {
-    cpu->m_irqPending = val & 1;
-    cpu->m_nmiPending = val & 2;
+    // a level IRQ line and an edge-triggered NMI line
+    cpu->m_interrupts.SetIRQLines(IRQSource::EXTERNAL, (val & 1) ? IRQSource::EXTERNAL : 0);
+    cpu->m_interrupts.SetNMILines(NMISource::EXTERNAL, (val & 2) ? NMISource::EXTERNAL : 0);
 }
 
 void Tests::InterruptTest(const string& romFile)
@@ -94,6 +289,7 @@ void Tests::InterruptTest(const string& romFile)
     cpu.Attach(&tc);
     cpu.m_enableTraps = true;
     cpu.m_showCycles  = true;
+    cpu.m_enableJIT   = s_enableJIT;
     cpu.JumpTo(0x0400);
     cpu.BreakAt(0x06F5);
     while(!tc.IsTrap())
@@ -115,12 +311,13 @@ void Tests::AllSuiteA(const string& romFile)
 
     TestCallbacks tc;
     RAM           ram;
-    CPU           cpu(&ram);
+    CPU           cpu(&ram, s_busType);
 
     ram.Load(romFile, 0x4000);
     cpu.Attach(&tc);
     cpu.m_enableTraps = true;
     cpu.m_showCycles  = true;
+    cpu.m_enableJIT   = s_enableJIT;
     cpu.JumpTo(0x4000);
     cpu.BreakAt(0x45C0);
     while(!tc.IsTrap())
@@ -142,12 +339,13 @@ void Tests::TimingTest(const string& romFile)
 
     TestCallbacks tc;
     RAM           ram;
-    CPU           cpu(&ram);
+    CPU           cpu(&ram, s_busType);
 
     ram.Load(romFile, 0x1000);
     cpu.Attach(&tc);
     cpu.m_enableTraps = true;
     cpu.m_showCycles  = true;
+    cpu.m_enableJIT   = s_enableJIT;
     cpu.JumpTo(0x1000);
     cpu.BreakAt(0x1269);
     while(!tc.IsTrap())
@@ -156,4 +354,304 @@ void Tests::TimingTest(const string& romFile)
     }
     Assert(cpu.Cycles() == 1141);
 }
+
+void Tests::LanesTest(const string& romFile)
+{
+    if(!filesystem::exists(romFile))
+    {
+        cout << "LanesTest ROM " << romFile << " not found" << endl;
+        return;
+    }
+
+    cout << "LanesTest: " << flush;
+
+    Lanes lanes;
+    lanes.Load(romFile, 0);
+    lanes.JumpTo(0x0400);
+    lanes.BreakAt(0x3469);
+    while(!lanes.Run(1000000))
+    {
+        cout << "#" << flush;
+    }
+
+    // the same run on a CPU, which every lane has to match
+    TestCallbacks tc;
+    RAM           ram;
+    CPU           cpu(&ram, BusType::Flat);
+    ram.Load(romFile, 0);
+    cpu.Attach(&tc);
+    cpu.m_enableTraps = true;
+    cpu.JumpTo(0x0400);
+    cpu.BreakAt(0x3469);
+    while(!tc.IsTrap())
+    {
+        cpu.Execute();
+    }
+    bool passed = true;
+    for(unsigned l = 0; l < Lanes::LANES; l++)
+    {
+        passed &= lanes.GetState(l).pc == 0x3469 && SameAsCPU(lanes, l, cpu, ram);
+    }
+    Assert(passed);
+}
+
+void Tests::LanesBranchTest()
+{
+    cout << "LanesBranchTest: " << flush;
+
+    Lanes lanes;
+    for(unsigned l = 0; l < Lanes::LANES; l++)
+    {
+        LoadBranchProgram(l, [&lanes, l](word_t addr, byte_t val) { lanes.Set(l, addr, val); });
+    }
+    lanes.JumpTo(BRANCH_PROGRAM_START);
+    lanes.BreakAt(BRANCH_PROGRAM_END);
+    while(!lanes.Run(1000000))
+    {
+        cout << "#" << flush;
+    }
+
+    // lanes ran both together and alone
+    bool passed = lanes.VectorSteps() && lanes.ScalarSteps();
+    for(unsigned l = 0; l < Lanes::LANES; l++)
+    {
+        TestCallbacks tc;
+        RAM           ram;
+        CPU           cpu(&ram, BusType::Flat);
+        LoadBranchProgram(l, [&ram](word_t addr, byte_t val) { ram.DirectSet(addr, val); });
+        cpu.Attach(&tc);
+        cpu.m_enableTraps = true;
+        cpu.JumpTo(BRANCH_PROGRAM_START);
+        cpu.BreakAt(BRANCH_PROGRAM_END);
+        while(!tc.IsTrap())
+        {
+            cpu.Execute();
+        }
+        passed &= lanes.GetState(l).pc == BRANCH_PROGRAM_END && SameAsCPU(lanes, l, cpu, ram);
+    }
+    Assert(passed);
+}
+
+void Tests::CoverageTest()
+{
+    cout << "CoverageTest: " << flush;
+
+    // the debug variant covers each instruction it runs, the plain one the
+    // blocks, idioms and native code it enters; they have to mark the same
+    Coverage stepped;
+    Coverage entered;
+    for(auto coverage : {&stepped, &entered})
+    {
+        TestCallbacks tc;
+        RAM           ram;
+        CPU           cpu(&ram, s_busType);
+        LoadBranchProgram(0, [&ram](word_t addr, byte_t val) { ram.DirectSet(addr, val); });
+        cpu.AttachCoverage(coverage);
+        cpu.m_enableJIT = s_enableJIT;
+        cpu.JumpTo(BRANCH_PROGRAM_START);
+        if(coverage == &stepped)
+        {
+            cpu.Attach(&tc);
+            cpu.m_enableTraps = true;
+            cpu.BreakAt(BRANCH_PROGRAM_END);
+        }
+        while(cpu.PC != BRANCH_PROGRAM_END)
+        {
+            cpu.Execute();
+        }
+    }
+
+    // everything up to the final JMP but the byte BRK skips
+    bool passed = stepped.Count(MemoryBank::RAM) == BRANCH_PROGRAM_END - BRANCH_PROGRAM_START - 1 &&
+                  !stepped.IsHit(MemoryBank::RAM, 0x0430) && !stepped.IsHit(MemoryBank::RAM, BRANCH_PROGRAM_END);
+    for(unsigned b = 0; b < Coverage::BANKS; b++)
+    {
+        for(unsigned addr = 0; addr < MEM_SIZE; addr++)
+        {
+            const auto bank = static_cast<MemoryBank>(b);
+            passed &= stepped.IsHit(bank, static_cast<word_t>(addr)) == entered.IsHit(bank, static_cast<word_t>(addr));
+        }
+    }
+    Assert(passed);
+}
+
+void Tests::MathPackTest()
+{
+    cout << "MathPackTest: " << flush;
+
+    RAM      ram;
+    MathPack mathPack(&ram);
+    auto     set = [&ram](word_t addr, const Float& value) {
+        for(word_t i = 0; i < value.size(); i++)
+        {
+            ram.DirectSet(static_cast<word_t>(addr + i), value[i]);
+        }
+    };
+    auto get = [&ram](word_t addr) {
+        Float value;
+        for(word_t i = 0; i < value.size(); i++)
+        {
+            value[i] = ram.DirectGet(static_cast<word_t>(addr + i));
+        }
+        return value;
+    };
+
+    bool passed = true;
+    bool error  = false;
+    for(const auto& test : FLOAT_CASES)
+    {
+        set(FR0, test.fr0);
+        set(FR1, test.fr1);
+        passed &= mathPack.Call(test.entry, error) && error == test.error && (error || get(FR0) == test.result);
+    }
+    for(const auto& test : INTEGER_CASES)
+    {
+        set(FR0, test.fr0);
+        passed &= mathPack.Call(FPI, error) && error == test.error && (error || ram.GetW(FR0) == test.result);
+    }
+
+    ram.SetW(FR0, 1234);
+    passed &= mathPack.Call(IFP, error) && !error && get(FR0) == Float{0x41, 0x12, 0x34, 0x00, 0x00, 0x00};
+
+    // the last character has bit 7 set
+    for(const auto& test : TEXT_CASES)
+    {
+        set(FR0, test.fr0);
+        passed &= mathPack.Call(FASC, error) && !error;
+        string text;
+        for(word_t addr = ram.GetW(INBUFF); text.size() < 20; addr++)
+        {
+            const byte_t c = ram.DirectGet(addr);
+            text += static_cast<char>(c & 0x7F);
+            if(c & 0x80)
+            {
+                break;
+            }
+        }
+        passed &= text == test.text;
+    }
+
+    // CIX is left past the number
+    const string text = "-12.5E3,";
+    for(word_t i = 0; i < text.size(); i++)
+    {
+        ram.DirectSet(static_cast<word_t>(0x0600 + i), static_cast<byte_t>(text[i]));
+    }
+    ram.SetW(INBUFF, 0x0600);
+    ram.DirectSet(CIX, 0);
+    passed &= mathPack.Call(AFP, error) && !error && get(FR0) == Float{0xC2, 0x01, 0x25, 0x00, 0x00, 0x00} && ram.DirectGet(CIX) == 7;
+    Assert(passed);
+}
+
+void Tests::ConditionTest()
+{
+    cout << "ConditionTest: " << flush;
+
+    RAM  ram;
+    CPU  cpu(&ram);
+    bool passed = true;
+    for(const auto& test : CONDITION_CASES)
+    {
+        cpu.A = test.a;
+        passed &= Condition(test.text).Evaluate(cpu, test.hits) == test.result;
+    }
+
+    // each level keeps a value on the stack, one past its size does not compile
+    auto nested = [](unsigned depth) {
+        string text;
+        for(unsigned i = 0; i < depth; i++)
+        {
+            text += "1+(";
+        }
+        return text + "1" + string(depth, ')');
+    };
+    passed &= Condition(nested(15)).Evaluate(cpu, 1);
+    bool tooDeep = false;
+    try
+    {
+        Condition condition(nested(16));
+    }
+    catch(const runtime_error&)
+    {
+        tooDeep = true;
+    }
+    Assert(passed && tooDeep);
+}
+
+void Tests::AotTest()
+{
+    cout << "AotTest: " << flush;
+
+    RAM ram;
+    for(word_t i = 0; i < sizeof(AOT_CARTRIDGE); i++)
+    {
+        ram.DirectSet(static_cast<word_t>(0xA000 + i), AOT_CARTRIDGE[i]);
+    }
+    for(word_t i = 0; i < sizeof(AOT_SUBROUTINE); i++)
+    {
+        ram.DirectSet(static_cast<word_t>(0xA010 + i), AOT_SUBROUTINE[i]);
+    }
+    ram.SetW(0xBFFA, 0xA000);
+    ram.SetW(0xBFFE, 0xA014);
+
+    const map<word_t, word_t> blocks = {
+        {0xA000, 0xA002}, {0xA002, 0xA005}, {0xA005, 0xA008}, {0xA008, 0xA00B}, {0xA010, 0xA012}, {0xA014, 0xA015},
+    };
+    Assert(Aot::FindBlocks(ram) == blocks);
+}
+
+void Tests::TimerTest()
+{
+    cout << "TimerTest: " << flush;
+
+    // the tick UpdateTimers would first change the bit on when run on every tick
+    auto perTick = [](uint64_t second, unsigned tick, unsigned freq, bool set) {
+        for(unsigned i = 0; i < 2 * (POKEY::LAST_TICK + 1); i++, tick++)
+        {
+            if(tick > POKEY::LAST_TICK)
+            {
+                second += CYCLES_PER_SEC;
+                tick = 0;
+            }
+            if((freq && tick % freq == 0) != set)
+            {
+                return second + tick * POKEY::TIMER_CYCLES;
+            }
+        }
+        return Scheduler::NEVER;
+    };
+
+    const uint64_t second = 5ull * CYCLES_PER_SEC;
+    bool           passed = true;
+    for(unsigned tick : {0u, 1u, 2u, 3u, 100u, POKEY::LAST_TICK - 2, POKEY::LAST_TICK - 1, POKEY::LAST_TICK, POKEY::LAST_TICK + 1})
+    {
+        for(unsigned freq : {0u, 1u, 2u, 3u, 7u, 64u, 255u})
+        {
+            for(bool set : {false, true})
+            {
+                passed &= POKEY::NextTimerChange(second, tick, freq, set) == perTick(second, tick, freq, set);
+            }
+        }
+    }
+    Assert(passed);
+}
+
+// registers, cycles and all memory of the lane
+bool Tests::SameAsCPU(const Lanes& lanes, unsigned lane, const CPU& cpu, const RAM& ram)
+{
+    const Lanes::State state = lanes.GetState(lane);
+    if(state.pc != cpu.PC || state.a != cpu.A || state.x != cpu.X || state.y != cpu.Y || state.s != cpu.S || state.f != cpu.GetF() ||
+       lanes.Cycles(lane) != cpu.TotalCycles())
+    {
+        return false;
+    }
+    for(unsigned addr = 0; addr < MEM_SIZE; addr++)
+    {
+        if(lanes.Get(lane, static_cast<word_t>(addr)) != ram.DirectGet(static_cast<word_t>(addr)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 } // namespace atre
@@ -5,6 +5,8 @@
 
 namespace atre
 {
+class Lanes;
+
 class TestCallbacks : public Callbacks
 {
 public:
@@ -26,9 +28,29 @@ public:
     static void InterruptTest(const std::string& romFile = "6502_interrupt_test.bin");
     static void AllSuiteA(const std::string& romFile = "AllSuiteA.bin");
     static void TimingTest(const std::string& romFile = "timingtest-1.bin");
+    // the functional test in every lane of a Lanes
+    static void LanesTest(const std::string& romFile = "6502_functional_test.bin");
+    // lanes seeded to take different branches, each checked against a CPU
+    static void LanesBranchTest();
+    // coverage of a run with and without the debug variant of the bus
+    static void CoverageTest();
+    // the floating point package against results of the OS ROM routines
+    static void MathPackTest();
+    // breakpoint conditions evaluated against their expected results
+    static void ConditionTest();
+    // the blocks the aot command finds in a small cartridge
+    static void AotTest();
+    // the ticks POKEY schedules for its timers against updating them on every tick
+    static void TimerTest();
+
+    // runs the suites with hot blocks compiled to native code
+    static bool    s_enableJIT;
+    // the bus of the suites that need nothing but memory
+    static BusType s_busType;
 
 private:
     static void InterruptReg(CPU* cpu, byte_t val);
+    static bool SameAsCPU(const Lanes& lanes, unsigned lane, const CPU& cpu, const RAM& ram);
     static void Assert(bool mustBeTrue);
 };
 } // namespace atre
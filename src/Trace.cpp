@@ -0,0 +1,227 @@
+#include "Trace.hpp"
+#include "Debugger.hpp"
+
+using namespace std;
+
+namespace atre
+{
+namespace
+{
+const char TRACE_MAGIC[8] = {'A', 'T', 'R', 'E', 'T', 'R', 'C', '1'};
+
+// bits of the per-record mask telling which fields follow
+const byte_t CODE_CHANGED = 0b00000001;
+const byte_t A_CHANGED    = 0b00000010;
+const byte_t X_CHANGED    = 0b00000100;
+const byte_t Y_CHANGED    = 0b00001000;
+const byte_t S_CHANGED    = 0b00010000;
+const byte_t F_CHANGED    = 0b00100000;
+const byte_t ADDR_CHANGED = 0b01000000;
+
+void PutVarint(uint64_t val, vector<byte_t>& out)
+{
+    while(val >= 0x80)
+    {
+        out.push_back(static_cast<byte_t>(val | 0x80));
+        val >>= 7;
+    }
+    out.push_back(static_cast<byte_t>(val));
+}
+
+bool GetVarint(istream& is, uint64_t& val)
+{
+    val = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        const int c = is.get();
+        if(c == EOF)
+        {
+            return false;
+        }
+        val |= static_cast<uint64_t>(c & 0x7F) << shift;
+        if(!(c & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+Trace::Trace(size_t capacity) : m_ring(), m_mask(), m_head(), m_tail(), m_streaming(), m_stopWriter(), m_writer()
+{
+    size_t size = 1;
+    while(size < capacity)
+    {
+        size <<= 1;
+    }
+    m_ring.resize(size);
+    m_mask = size - 1;
+}
+
+Trace::~Trace()
+{
+    StopWriter();
+}
+
+void Trace::WriteHeader(ostream& os)
+{
+    os.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+}
+
+// the cycle and PC are stored as deltas, other fields only when they changed
+void Trace::Encode(const TraceRecord& last, const TraceRecord& record, vector<byte_t>& out)
+{
+    byte_t mask = 0;
+    mask |= record.code != last.code ? CODE_CHANGED : 0;
+    mask |= record.a != last.a ? A_CHANGED : 0;
+    mask |= record.x != last.x ? X_CHANGED : 0;
+    mask |= record.y != last.y ? Y_CHANGED : 0;
+    mask |= record.s != last.s ? S_CHANGED : 0;
+    mask |= record.f != last.f ? F_CHANGED : 0;
+    mask |= record.addr != last.addr ? ADDR_CHANGED : 0;
+
+    out.push_back(mask);
+    PutVarint(record.cycle - last.cycle, out);
+    // zigzag, short jumps either way stay short
+    const auto pcDelta = static_cast<sword_t>(record.pc - last.pc);
+    PutVarint(static_cast<word_t>((pcDelta << 1) ^ (pcDelta >> 15)), out);
+    for(auto [bit, val] : {make_pair(CODE_CHANGED, record.code), make_pair(A_CHANGED, record.a), make_pair(X_CHANGED, record.x),
+                           make_pair(Y_CHANGED, record.y), make_pair(S_CHANGED, record.s), make_pair(F_CHANGED, record.f)})
+    {
+        if(mask & bit)
+        {
+            out.push_back(val);
+        }
+    }
+    if(mask & ADDR_CHANGED)
+    {
+        out.push_back(static_cast<byte_t>(record.addr & 0xFF));
+        out.push_back(static_cast<byte_t>(record.addr >> 8));
+    }
+}
+
+// record holds the previous record and is updated in place
+bool Trace::Decode(istream& is, TraceRecord& record)
+{
+    const int mask = is.get();
+    uint64_t  cycleDelta, pcDelta;
+    if(mask == EOF || !GetVarint(is, cycleDelta) || !GetVarint(is, pcDelta))
+    {
+        return false;
+    }
+    record.cycle += cycleDelta;
+    record.pc = static_cast<word_t>(record.pc + ((pcDelta >> 1) ^ (~(pcDelta & 1) + 1)));
+    for(auto [bit, field] : {make_pair(CODE_CHANGED, &record.code), make_pair(A_CHANGED, &record.a), make_pair(X_CHANGED, &record.x),
+                             make_pair(Y_CHANGED, &record.y), make_pair(S_CHANGED, &record.s), make_pair(F_CHANGED, &record.f)})
+    {
+        if(mask & bit)
+        {
+            *field = static_cast<byte_t>(is.get());
+        }
+    }
+    if(mask & ADDR_CHANGED)
+    {
+        const int lo = is.get();
+        const int hi = is.get();
+        record.addr  = static_cast<word_t>(lo | (hi << 8));
+    }
+    return is.good();
+}
+
+void Trace::StartWriter(const string& fileName)
+{
+    if(m_writer)
+    {
+        throw runtime_error("Trace is already being written");
+    }
+    auto ofs = make_unique<ofstream>(fileName, ios_base::binary);
+    if(!ofs->good())
+    {
+        throw runtime_error("Unable to open file");
+    }
+    WriteHeader(*ofs);
+
+    m_tail       = m_head.load();
+    m_stopWriter = false;
+    m_streaming  = true;
+    m_writer     = make_unique<thread>(&Trace::Writer, this, move(ofs));
+}
+
+void Trace::StopWriter()
+{
+    if(m_writer)
+    {
+        m_stopWriter = true;
+        m_writer->join();
+        m_writer.reset();
+    }
+}
+
+// the CPU can't lap the records between tail and head while streaming, so
+// they are read without locking; it only stops waiting after the last drain
+void Trace::Writer(unique_ptr<ofstream> ofs)
+{
+    TraceRecord    last {};
+    vector<byte_t> buffer;
+    while(true)
+    {
+        const bool     stopping = m_stopWriter;
+        const uint64_t head     = m_head.load(memory_order_acquire);
+        uint64_t       tail     = m_tail.load(memory_order_relaxed);
+        for(; tail < head; tail++)
+        {
+            const TraceRecord& record = m_ring[tail & m_mask];
+            Encode(last, record, buffer);
+            last = record;
+        }
+        m_tail.store(tail, memory_order_release);
+        ofs->write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        buffer.clear();
+        if(stopping)
+        {
+            m_streaming = false;
+            break;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+void Trace::Save(const string& fileName)
+{
+    ofstream ofs(fileName, ios_base::binary);
+    if(!ofs.good())
+    {
+        throw runtime_error("Unable to open file");
+    }
+    WriteHeader(ofs);
+
+    const uint64_t head  = m_head.load(memory_order_acquire);
+    const uint64_t first = head > m_ring.size() ? head - m_ring.size() : 0;
+    TraceRecord    last {};
+    vector<byte_t> buffer;
+    for(uint64_t i = first; i < head; i++)
+    {
+        Encode(last, m_ring[i & m_mask], buffer);
+        last = m_ring[i & m_mask];
+    }
+    ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+void Trace::Print(const string& fileName)
+{
+    ifstream ifs(fileName, ios_base::binary);
+    char     magic[sizeof(TRACE_MAGIC)];
+    if(!ifs.read(magic, sizeof(magic)) || memcmp(magic, TRACE_MAGIC, sizeof(magic)))
+    {
+        throw runtime_error("Not a trace file");
+    }
+
+    TraceRecord record {};
+    while(Decode(ifs, record))
+    {
+        cout << dec << record.cycle << ": " << hex << showbase << static_cast<int>(record.code) << " at " << record.addr << ", ";
+        Debugger::PrintState(record.a, record.x, record.y, record.pc, record.s, record.f);
+    }
+}
+} // namespace atre
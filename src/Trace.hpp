@@ -0,0 +1,72 @@
+#pragma once
+
+#include "atre.hpp"
+
+namespace atre
+{
+#pragma pack(push, 1)
+struct TraceRecord
+{
+    uint64_t cycle; // total cycles when the instruction started
+    word_t   pc;
+    word_t   addr; // last data address accessed, 0 without any
+    byte_t   code;
+    byte_t   a; // registers after the instruction
+    byte_t   x;
+    byte_t   y;
+    byte_t   s;
+    byte_t   f;
+};
+#pragma pack(pop)
+
+// instruction trace kept in a ring of the last records; a background writer
+// can stream every record to a delta compressed file, stalling the CPU when
+// it falls a full ring behind instead of dropping records
+class Trace
+{
+public:
+    // capacity is rounded up to a power of two
+    Trace(size_t capacity);
+    ~Trace();
+
+    void StartWriter(const std::string& fileName);
+    void StopWriter();
+    // writes the records still in the ring
+    void Save(const std::string& fileName);
+    // prints a trace file in the Debugger::DumpState format
+    static void Print(const std::string& fileName);
+
+    inline void Record(const TraceRecord& record)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if(m_streaming)
+        {
+            while(head - m_tail.load(std::memory_order_acquire) > m_mask)
+            {
+                std::this_thread::yield();
+            }
+        }
+        m_ring[head & m_mask] = record;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    inline uint64_t Count() const
+    {
+        return m_head.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::vector<TraceRecord>     m_ring;
+    size_t                       m_mask;
+    std::atomic<uint64_t>        m_head;
+    std::atomic<uint64_t>        m_tail; // next record for the writer
+    std::atomic_bool             m_streaming; // the CPU waits for the writer
+    std::atomic_bool             m_stopWriter;
+    std::unique_ptr<std::thread> m_writer;
+
+    static void Encode(const TraceRecord& last, const TraceRecord& record, std::vector<byte_t>& out);
+    static bool Decode(std::istream& is, TraceRecord& record);
+    static void WriteHeader(std::ostream& os);
+    void        Writer(std::unique_ptr<std::ofstream> ofs);
+};
+} // namespace atre
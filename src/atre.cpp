@@ -1,8 +1,10 @@
 #include "ANTIC.hpp"
+#include "Aot.hpp"
 #include "Atari.hpp"
 #include "Chips.hpp"
 #include "Debugger.hpp"
 #include "Tests.hpp"
+#include "Trace.hpp"
 #include "atre.hpp"
 
 using namespace atre;
@@ -49,16 +51,70 @@ int main(int /*argc*/, char* /*argv*/[])
                 cout << "  <os_rom_file> should be the Atari XL OS ROM image (16 kB, Rev B)" << endl;
                 cout << "  [cartridge_rom_file] is an optional additional 8kB ROM (BASIC or another cartridge)" << endl;
                 cout << "- tests: run internal testing suites" << endl;
+                cout << "- aot <cartridge_rom_file> <cpp_file>: translate an 8kB cartridge to C++" << endl;
+                cout << "  add the generated file to the build to run the cartridge natively" << endl;
                 cout << "- start and stop: control CPU execution" << endl;
+                cout << "- jit <on|off>: compile hot code to native x86-64 code" << endl;
+                cout << "- fp <on|off>: run the OS floating point routines natively" << endl;
+                cout << "- clock <1|2|4|8|max>: run the CPU at a multiple of the stock clock, video and timers unchanged" << endl;
+                cout << "- speed <1|2|4|...|max>: run at a multiple of real time or as fast as the host allows" << endl;
+                cout << "- frameskip <n>: draw every n+1st frame, interrupts and collisions unchanged" << endl;
+                cout << "  more frames are left out while the host falls behind real time" << endl;
+                cout << "- runahead <0-4>: show frames ahead of the emulation to hide the games' input lag, 0 turns it off" << endl;
+                cout << "- pacing [clear]: show or clear host frame times and how often the host fell behind" << endl;
+                cout << "- break <addr> [if <condition>]: stop before executing the instruction at hex address <addr>" << endl;
+                cout << "  <condition> like A==$9B && PEEK($D40B)>100 && hits>5 uses A, X, Y, S, P, PC, hits, PEEK() and DPEEK()" << endl;
+                cout << "- watch <r|w|x> <start> [end]: stop after reading, writing or executing the hex address range" << endl;
+                cout << "- clear: remove all breakpoints and watchpoints" << endl;
+                cout << "- trace on [file]: record executed instructions, streaming them to [file] if given" << endl;
+                cout << "- trace off, trace save <file>: stop recording, save the last recorded instructions" << endl;
+                cout << "- trace print <file>: decode a saved or streamed trace file" << endl;
+                cout << "- profile <on|off|clear>: count cycles per instruction and per called routine" << endl;
+                cout << "- profile labels <file>: load MADS, ld65 or NAME = $ADDR label files for reports" << endl;
+                cout << "- profile report [count], profile folded <file>: list hot spots, save stacks for flamegraph.pl" << endl;
+                cout << "- coverage <on|off|clear>: mark executed code per memory bank" << endl;
+                cout << "- coverage save <file>, coverage list <file>: save the bitmaps, save a hit and miss listing" << endl;
                 cout << "- exit" << endl;
             }
             else if(command == "tests")
             {
                 cout << "Running test suites..." << endl;
-                Tests::FunctionalTest();
-                Tests::InterruptTest();
-                Tests::AllSuiteA();
-                Tests::TimingTest();
+                for(auto jit : {false, true})
+                {
+                    for(auto bus : {BusType::Atari, BusType::Flat})
+                    {
+                        cout << (jit ? "JIT" : "Interpreter") << (bus == BusType::Flat ? ", flat bus:" : ", Atari bus:") << endl;
+                        Tests::s_enableJIT = jit;
+                        Tests::s_busType   = bus;
+                        Tests::FunctionalTest();
+                        if(bus == BusType::Atari)
+                        {
+                            // needs its feedback register
+                            Tests::InterruptTest();
+                        }
+                        Tests::AllSuiteA();
+                        Tests::TimingTest();
+                        Tests::CoverageTest();
+                    }
+                }
+                Tests::LanesTest();
+                Tests::LanesBranchTest();
+                Tests::MathPackTest();
+                Tests::ConditionTest();
+                Tests::AotTest();
+                Tests::TimerTest();
+            }
+            else if(command == "aot")
+            {
+                string cartridgeROM;
+                string outFile;
+                commands >> cartridgeROM >> outFile;
+                if(cartridgeROM.empty() || outFile.empty())
+                {
+                    cout << "Please specify cartridge ROM and output file names." << endl;
+                    continue;
+                }
+                Aot::Translate(cartridgeROM, outFile);
             }
             else if(command == "start")
             {
@@ -99,6 +155,194 @@ int main(int /*argc*/, char* /*argv*/[])
             {
                 debugger.Steps(false);
             }
+            else if(command == "jit")
+            {
+                string mode;
+                commands >> mode;
+                debugger.JIT(mode == "on");
+            }
+            else if(command == "fp")
+            {
+                string mode;
+                commands >> mode;
+                debugger.FloatingPoint(mode == "on");
+            }
+            else if(command == "clock")
+            {
+                string   mode;
+                unsigned multiplier = 0;
+                commands >> mode;
+                if(mode == "max")
+                {
+                    multiplier = CPU::MAX_CLOCK_MULTIPLIER;
+                }
+                else
+                {
+                    istringstream(mode) >> multiplier;
+                }
+                debugger.Clock(multiplier);
+            }
+            else if(command == "speed")
+            {
+                string   mode;
+                unsigned speed = 0;
+                commands >> mode;
+                if(mode != "max" && (!(istringstream(mode) >> speed) || !speed))
+                {
+                    cout << "Please specify a speed multiple or max." << endl;
+                    continue;
+                }
+                debugger.Speed(speed);
+            }
+            else if(command == "frameskip")
+            {
+                unsigned frames = 0;
+                if(!(commands >> frames))
+                {
+                    cout << "Please specify the number of frames to skip." << endl;
+                    continue;
+                }
+                debugger.FrameSkip(frames);
+            }
+            else if(command == "runahead")
+            {
+                unsigned frames = Debugger::MAX_RUN_AHEAD_FRAMES + 1;
+                commands >> frames;
+                if(frames > Debugger::MAX_RUN_AHEAD_FRAMES)
+                {
+                    cout << "Please specify 0 to " << Debugger::MAX_RUN_AHEAD_FRAMES << " frames." << endl;
+                    continue;
+                }
+                debugger.RunAhead(frames);
+            }
+            else if(command == "pacing")
+            {
+                string mode;
+                commands >> mode;
+                if(mode.empty())
+                {
+                    debugger.PacingReport();
+                }
+                else if(mode == "clear")
+                {
+                    debugger.PacingClear();
+                }
+                else
+                {
+                    cout << "Please specify clear or nothing." << endl;
+                }
+            }
+            else if(command == "break")
+            {
+                unsigned addr = MEM_SIZE;
+                string   keyword;
+                string   condition;
+                commands >> hex >> addr >> keyword;
+                getline(commands, condition);
+                if(addr >= MEM_SIZE || (!keyword.empty() && keyword != "if"))
+                {
+                    cout << "Please specify a hex address and optionally if and a condition." << endl;
+                    continue;
+                }
+                debugger.Break(static_cast<word_t>(addr), condition);
+            }
+            else if(command == "watch")
+            {
+                string   mode;
+                unsigned start = MEM_SIZE;
+                commands >> mode >> hex >> start;
+                unsigned end = start;
+                commands >> end;
+                if((mode != "r" && mode != "w" && mode != "x") || start >= MEM_SIZE || end >= MEM_SIZE || end < start)
+                {
+                    cout << "Please specify r, w or x and a hex address range." << endl;
+                    continue;
+                }
+                const Access access = mode == "r" ? Access::Read : (mode == "w" ? Access::Write : Access::Execute);
+                debugger.Watch(access, static_cast<word_t>(start), static_cast<word_t>(end));
+            }
+            else if(command == "clear")
+            {
+                debugger.ClearBreakpoints();
+            }
+            else if(command == "trace")
+            {
+                string mode;
+                string fileName;
+                commands >> mode >> fileName;
+                if(mode == "on")
+                {
+                    debugger.TraceOn(fileName);
+                }
+                else if(mode == "off")
+                {
+                    debugger.TraceOff();
+                }
+                else if((mode == "save" || mode == "print") && !fileName.empty())
+                {
+                    mode == "save" ? debugger.TraceSave(fileName) : Trace::Print(fileName);
+                }
+                else
+                {
+                    cout << "Please specify on, off, save or print and a file name." << endl;
+                }
+            }
+            else if(command == "profile")
+            {
+                string mode;
+                commands >> mode;
+                if(mode == "on" || mode == "off")
+                {
+                    debugger.Profile(mode == "on");
+                }
+                else if(mode == "clear")
+                {
+                    debugger.ProfileClear();
+                }
+                else if(mode == "report")
+                {
+                    unsigned count = 20;
+                    commands >> count;
+                    debugger.ProfileReport(count);
+                }
+                else if(mode == "labels" || mode == "folded")
+                {
+                    string fileName;
+                    commands >> fileName;
+                    if(fileName.empty())
+                    {
+                        cout << "Please specify a file name." << endl;
+                        continue;
+                    }
+                    mode == "labels" ? debugger.ProfileLabels(fileName) : debugger.ProfileFolded(fileName);
+                }
+                else
+                {
+                    cout << "Please specify on, off, clear, labels, report or folded." << endl;
+                }
+            }
+            else if(command == "coverage")
+            {
+                string mode;
+                string fileName;
+                commands >> mode >> fileName;
+                if(mode == "on" || mode == "off")
+                {
+                    debugger.CoverageOn(mode == "on");
+                }
+                else if(mode == "clear")
+                {
+                    debugger.CoverageClear();
+                }
+                else if((mode == "save" || mode == "list") && !fileName.empty())
+                {
+                    mode == "save" ? debugger.CoverageSave(fileName) : debugger.CoverageList(fileName);
+                }
+                else
+                {
+                    cout << "Please specify on, off or clear, or save or list and a file name." << endl;
+                }
+            }
             else if(command == "showdlist")
             {
                 debugger.ShowDList();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <bitset>
 #include <condition_variable>
@@ -17,7 +18,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <thread>
-#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -30,9 +31,10 @@ typedef byte_t   flag_t;
 namespace atre
 {
 constexpr int    MEM_SIZE            = 65536;
+constexpr int    CARTRIDGE_START     = 0xA000;
+constexpr int    CARTRIDGE_SIZE      = 8192;
 constexpr int    CYCLES_PER_SEC      = 1792080;
 constexpr int    FRAMES_PER_SEC      = 60;
-constexpr int    MILLISEC_PER_FRAME  = 1000 / FRAMES_PER_SEC;
 constexpr int    CYCLES_PER_FRAME    = CYCLES_PER_SEC / FRAMES_PER_SEC;
 constexpr int    TOTAL_SCANLINES     = 262;
 constexpr int    CYCLES_PER_SCANLINE = CYCLES_PER_FRAME / TOTAL_SCANLINES;